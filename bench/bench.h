@@ -0,0 +1,46 @@
+// -*- C++ -*-
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <chrono>
+
+#include "minirel.h"
+
+// Micro-benchmarks for the buffer manager and the DB layer.  Each benchmark
+// builds its own Minibase globals (a scratch database and buffer pool),
+// runs, prints a table to cout and tears the globals down again.  They are
+// run by name from bench_main.cpp:
+//
+//     BufMgrBench spacemap
+
+typedef int (*BenchFunction)( int argc, char** argv );
+
+// DB::AllocatePage / DeallocatePage throughput across run sizes.
+int SpaceMapBench( int argc, char** argv );
+
+// Page checksum cost: raw CRC32C per page, and per PinPage miss.
+int ChecksumBench( int argc, char** argv );
+
+// PinPage cost with and without a compressed second-tier cache.
+int Tier2Bench( int argc, char** argv );
+
+// BufPool with an inlined policy against virtual dispatch; page sizes.
+int DevirtBench( int argc, char** argv );
+
+// BufMgr hits, misses, dirty evictions, NewPage/FreePage and flushes by
+// policy and pool size, as a table, CSV or JSON.
+int BufMgrBench( int argc, char** argv );
+
+// N threads sharing MINIBASE_BM under a chosen access pattern; throughput
+// and pin latency per thread.
+int WorkloadBench( int argc, char** argv );
+
+
+// Wall-clock seconds from an arbitrary origin, for timing loops.
+inline double BenchNow()
+{
+	return std::chrono::duration<double>(
+		std::chrono::high_resolution_clock::now().time_since_epoch() ).count();
+}
+
+#endif
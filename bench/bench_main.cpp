@@ -0,0 +1,50 @@
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+
+using namespace std;
+
+#include "bench.h"
+
+int MINIBASE_RESTART_FLAG = 0;
+
+struct BenchEntry {
+	const char*   name;
+	BenchFunction run;
+	const char*   description;
+};
+
+static const BenchEntry benchmarks[] = {
+	{ "spacemap", SpaceMapBench, "DB page allocate/free throughput by run size" },
+	{ "checksum", ChecksumBench, "page checksum overhead on the PinPage miss path" },
+	{ "tier2",    Tier2Bench,    "PinPage cost with a compressed victim cache, by working-set size" },
+	{ "devirt",   DevirtBench,   "PinPage/UnpinPage with the replacer inlined vs. virtual; 4/8/16 KB pages" },
+	{ "bufmgr",   BufMgrBench,   "BufMgr operations by workload, policy and pool size (-h for options)" },
+	{ "workload", WorkloadBench, "multi-threaded zipfian/hotspot/scan/join pins through BufMgr (-h for options)" },
+};
+
+static const int numBenchmarks = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+static void Usage( const char* prog )
+{
+	cerr << "Usage: " << prog << " <benchmark> [options]\n\nBenchmarks:\n";
+	for (int i = 0; i < numBenchmarks; i++)
+		cerr << "  " << benchmarks[i].name << "\t" << benchmarks[i].description << endl;
+}
+
+int main (int argc, char **argv)
+{
+	if (argc < 2) {
+		Usage(argv[0]);
+		return 2;
+	}
+
+	for (int i = 0; i < numBenchmarks; i++) {
+		if (strcmp(argv[1], benchmarks[i].name) == 0)
+			return benchmarks[i].run(argc - 2, argv + 2);
+	}
+
+	cerr << "Unknown benchmark \"" << argv[1] << "\"\n";
+	Usage(argv[0]);
+	return 2;
+}
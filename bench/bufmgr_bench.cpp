@@ -0,0 +1,459 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "bench.h"
+#include "bufmgr.h"
+#include "db.h"
+#include "delay_storage.h"
+#include "replacer_registry.h"
+
+// The buffer manager's own operations, through BufMgr as a caller sees it,
+// for every combination of workload, replacement policy and pool size:
+//
+//     BufMgrBench bufmgr [-w workload]... [-p policy]... [-f frames,...]
+//                        [-n ops] [-c | -j] [dbname]
+//
+// -w  a workload below; may be repeated.  The default is all of them.
+// -p  a policy spec as BufMgr takes it ("Clock", "lru-k:k=3"); may be
+//     repeated.  The default is every registered policy.
+// -f  pool sizes in frames.  The default is 64,256,1024.
+// -n  operations per run instead of the workload's default.
+// -c  print CSV; -j print one JSON object per line.  The default is a
+//     table.
+//
+// Every run gets a fresh database and pool, and pages are read from the
+// database file, which the OS keeps cached: misses cost a system call,
+// not a disk seek.  Random choices use a fixed seed, so two builds see
+// the same page sequence.
+
+struct BenchResult {
+	long long ops;
+	double seconds;
+	long long hits;
+	long long misses;
+	long long diskReads;
+	long long diskWrites;
+	LatencyOp latencyOp;	// the operation whose percentiles are shown
+	double p50, p99;		// nanoseconds
+};
+
+typedef Status (*WorkloadFunction)( int numFrames, long long ops, BenchResult& result );
+
+struct Workload {
+	const char*      name;
+	WorkloadFunction run;
+	long long        defaultOps;
+	int              filePages;		// pages needed, as a multiple of the pool
+	const char*      description;
+};
+
+static unsigned int seed;
+
+static int NextRandom( int n )
+{
+	seed = seed * 1103515245 + 12345;
+	return (int)((seed >> 8) % n);
+}
+
+// Allocate numPages pages, write them out and leave the pool empty.
+static Status MakePages( int numPages, PageID& firstPid )
+{
+	Page* pg;
+	Status status = MINIBASE_DB->AllocatePage(firstPid, numPages);
+	for (PageID pid = firstPid; pid < firstPid + numPages && status == OK; pid++) {
+		status = MINIBASE_BM->PinPage(pid, pg, true);
+		if (status == OK) {
+			memset((char*)pg, 0, MINIBASE_PAGESIZE);
+			status = MINIBASE_BM->UnpinPage(pid, true);
+		}
+	}
+	if (status == OK) status = MINIBASE_BM->FlushAllPages();
+	return status;
+}
+
+// Pin and unpin pages of a set half the size of the pool, so after the
+// first round every pin is a hit.
+static Status HitWorkload( int numFrames, long long ops, BenchResult& result )
+{
+	int numPages = (numFrames > 1) ? numFrames / 2 : 1;
+	PageID firstPid;
+	Status status = MakePages(numPages, firstPid);
+
+	Page* pg;
+	for (int i = 0; i < numPages && status == OK; i++) {
+		status = MINIBASE_BM->PinPage(firstPid + i, pg);
+		if (status == OK) status = MINIBASE_BM->UnpinPage(firstPid + i);
+	}
+	MINIBASE_BM->ResetStat();
+
+	double start = BenchNow();
+	for (long long i = 0; i < ops && status == OK; i++) {
+		PageID pid = firstPid + (PageID)(i % numPages);
+		status = MINIBASE_BM->PinPage(pid, pg);
+		if (status == OK) status = MINIBASE_BM->UnpinPage(pid);
+	}
+	result.seconds = BenchNow() - start;
+	result.latencyOp = LAT_PIN_HIT;
+	return status;
+}
+
+// Uniform random pins over four times the pool, never dirtying a page:
+// most pins miss, and every eviction is clean.
+static Status MissWorkload( int numFrames, long long ops, BenchResult& result )
+{
+	int numPages = numFrames * 4;
+	PageID firstPid;
+	Status status = MakePages(numPages, firstPid);
+	MINIBASE_BM->ResetStat();
+
+	Page* pg;
+	double start = BenchNow();
+	for (long long i = 0; i < ops && status == OK; i++) {
+		PageID pid = firstPid + NextRandom(numPages);
+		status = MINIBASE_BM->PinPage(pid, pg);
+		if (status == OK) status = MINIBASE_BM->UnpinPage(pid);
+	}
+	result.seconds = BenchNow() - start;
+	result.latencyOp = LAT_PIN_MISS;
+	return status;
+}
+
+// The miss workload with every page unpinned dirty, so every eviction
+// writes its page back first.
+static Status DirtyWorkload( int numFrames, long long ops, BenchResult& result )
+{
+	int numPages = numFrames * 4;
+	PageID firstPid;
+	Status status = MakePages(numPages, firstPid);
+	MINIBASE_BM->ResetStat();
+
+	Page* pg;
+	double start = BenchNow();
+	for (long long i = 0; i < ops && status == OK; i++) {
+		PageID pid = firstPid + NextRandom(numPages);
+		status = MINIBASE_BM->PinPage(pid, pg);
+		if (status == OK) {
+			((int*)pg)[0]++;
+			status = MINIBASE_BM->UnpinPage(pid, true);
+		}
+	}
+	result.seconds = BenchNow() - start;
+	result.latencyOp = LAT_EVICTION;
+	return status;
+}
+
+// The batch workloads pin and unpin BATCH pages per call, and count an op
+// per page, to compare with hit and miss.
+enum { BATCH = 16 };
+
+// The hit workload, BATCH consecutive pages per PinPages.
+static Status BatchHitWorkload( int numFrames, long long ops, BenchResult& result )
+{
+	int numPages = (numFrames > 2 * BATCH) ? numFrames / 2 : BATCH;
+	PageID firstPid;
+	Status status = MakePages(numPages, firstPid);
+
+	Page* pg;
+	for (int i = 0; i < numPages && status == OK; i++) {
+		status = MINIBASE_BM->PinPage(firstPid + i, pg);
+		if (status == OK) status = MINIBASE_BM->UnpinPage(firstPid + i);
+	}
+	MINIBASE_BM->ResetStat();
+
+	PageID pids[BATCH];
+	Page* pages[BATCH];
+	long long done = 0;
+	double start = BenchNow();
+	while (done < ops && status == OK) {
+		for (int b = 0; b < BATCH; b++, done++)
+			pids[b] = firstPid + (PageID)(done % numPages);
+		status = MINIBASE_BM->PinPages(pids, BATCH, pages);
+		if (status == OK) status = MINIBASE_BM->UnpinPages(pids, BATCH);
+	}
+	result.seconds = BenchNow() - start;
+	result.ops = done;
+	result.latencyOp = LAT_PIN_HIT;
+	return status;
+}
+
+// The miss workload, BATCH random pages per PinPages.
+static Status BatchMissWorkload( int numFrames, long long ops, BenchResult& result )
+{
+	int numPages = numFrames * 4;
+	PageID firstPid;
+	Status status = MakePages(numPages, firstPid);
+	MINIBASE_BM->ResetStat();
+
+	PageID pids[BATCH];
+	Page* pages[BATCH];
+	long long done = 0;
+	double start = BenchNow();
+	while (done < ops && status == OK) {
+		for (int b = 0; b < BATCH; b++, done++)
+			pids[b] = firstPid + NextRandom(numPages);
+		status = MINIBASE_BM->PinPages(pids, BATCH, pages);
+		if (status == OK) status = MINIBASE_BM->UnpinPages(pids, BATCH);
+	}
+	result.seconds = BenchNow() - start;
+	result.ops = done;
+	result.latencyOp = LAT_PIN_MISS;
+	return status;
+}
+
+// NewPage, unpin, FreePage: allocation in the DB's space map plus a frame
+// taken and given back.  The pool is half full of other pages.
+static Status ChurnWorkload( int numFrames, long long ops, BenchResult& result )
+{
+	int numPages = (numFrames > 1) ? numFrames / 2 : 1;
+	PageID firstPid;
+	Status status = MakePages(numPages, firstPid);
+
+	Page* pg;
+	for (int i = 0; i < numPages && status == OK; i++) {
+		status = MINIBASE_BM->PinPage(firstPid + i, pg);
+		if (status == OK) status = MINIBASE_BM->UnpinPage(firstPid + i);
+	}
+	MINIBASE_BM->ResetStat();
+
+	double start = BenchNow();
+	for (long long i = 0; i < ops && status == OK; i++) {
+		PageID pid;
+		status = MINIBASE_BM->NewPage(pid, pg);
+		if (status == OK) status = MINIBASE_BM->UnpinPage(pid, true);
+		if (status == OK) status = MINIBASE_BM->FreePage(pid);
+	}
+	result.seconds = BenchNow() - start;
+	result.latencyOp = LAT_PIN_MISS;
+	return status;
+}
+
+// Dirty every frame, then FlushAllPages; only the flushes are timed, and
+// an op is one page written.
+static Status FlushWorkload( int numFrames, long long ops, BenchResult& result )
+{
+	PageID firstPid;
+	Status status = MakePages(numFrames, firstPid);
+	MINIBASE_BM->ResetStat();
+
+	Page* pg;
+	result.seconds = 0;
+	long long rounds = (ops + numFrames - 1) / numFrames;
+	for (long long r = 0; r < rounds && status == OK; r++) {
+		for (int i = 0; i < numFrames && status == OK; i++) {
+			status = MINIBASE_BM->PinPage(firstPid + i, pg);
+			if (status == OK) {
+				((int*)pg)[0]++;
+				status = MINIBASE_BM->UnpinPage(firstPid + i, true);
+			}
+		}
+		double start = BenchNow();
+		if (status == OK) status = MINIBASE_BM->FlushAllPages();
+		result.seconds += BenchNow() - start;
+	}
+	result.ops = rounds * numFrames;
+	result.latencyOp = LAT_DIRTY_WRITE;
+	return status;
+}
+
+static const Workload workloads[] = {
+	{ "hit",   HitWorkload,   2000000, 1, "pin+unpin of resident pages" },
+	{ "miss",  MissWorkload,  200000,  4, "random pins over 4x the pool, clean" },
+	{ "dirty", DirtyWorkload, 200000,  4, "random pins over 4x the pool, every unpin dirty" },
+	{ "churn", ChurnWorkload, 200000,  1, "NewPage+unpin+FreePage" },
+	{ "flush", FlushWorkload, 200000,  1, "FlushAllPages of a fully dirty pool, per page" },
+	{ "batch-hit",  BatchHitWorkload,  2000000, 1, "hit, 16 pages per PinPages/UnpinPages" },
+	{ "batch-miss", BatchMissWorkload, 200000,  4, "miss, 16 pages per PinPages/UnpinPages" },
+};
+
+static const int numWorkloads = sizeof(workloads) / sizeof(workloads[0]);
+
+static void Usage()
+{
+	cerr << "Usage: BufMgrBench bufmgr [-w workload]... [-p policy]... [-f frames,...]\n"
+		 << "                          [-n ops] [-s file|direct|memory] [-d device] [-c | -j]\n"
+		 << "                          [dbname]\n\nWorkloads:\n";
+	for (int i = 0; i < numWorkloads; i++)
+		cerr << "  " << workloads[i].name << "\t" << workloads[i].description << endl;
+	cerr << "Policies:\n";
+	ReplacerRegistry::List(cerr);
+	cerr << "Devices:\n";
+	DelayStorage::List(cerr);
+}
+
+static bool ParseSizes( const char* text, vector<int>& sizes )
+{
+	const char* p = text;
+	while (*p) {
+		char* end;
+		long n = strtol(p, &end, 10);
+		if (end == p || n <= 0) return false;
+		sizes.push_back((int)n);
+		if (*end != ',' && *end != '\0') return false;
+		p = (*end == ',') ? end + 1 : end;
+	}
+	return !sizes.empty();
+}
+
+enum OutputFormat { OUTPUT_TABLE, OUTPUT_CSV, OUTPUT_JSON };
+
+static void PrintHeader( OutputFormat format )
+{
+	if (format == OUTPUT_CSV)
+		cout << "workload,policy,frames,ops,seconds,ns_per_op,ops_per_sec,hit_ratio,"
+			 << "disk_reads,disk_writes,latency_op,p50_ns,p99_ns\n";
+	else if (format == OUTPUT_TABLE)
+		cout << left << setw(11) << "workload" << setw(14) << "policy" << right
+			 << setw(8) << "frames" << setw(10) << "ns/op" << setw(12) << "ops/s"
+			 << setw(8) << "hit %" << setw(10) << "reads" << setw(10) << "writes"
+			 << "  " << left << setw(12) << "latency" << right
+			 << setw(10) << "p50 ns" << setw(10) << "p99 ns" << endl;
+}
+
+static void PrintResult( OutputFormat format, const char* workload, const string& policy,
+                         int numFrames, const BenchResult& r )
+{
+	double nsPerOp = r.ops ? r.seconds * 1e9 / r.ops : 0;
+	double opsPerSec = (r.seconds > 0) ? r.ops / r.seconds : 0;
+	double hitRatio = (r.hits + r.misses) ? (double)r.hits / (r.hits + r.misses) : 0;
+	const char* op = LatencyStats::OpName(r.latencyOp);
+
+	ios::fmtflags flags = cout.flags();
+	cout << fixed;
+	if (format == OUTPUT_CSV) {
+		cout << workload << "," << policy << "," << numFrames << "," << r.ops << ","
+			 << setprecision(6) << r.seconds << "," << setprecision(1) << nsPerOp << ","
+			 << setprecision(0) << opsPerSec << "," << setprecision(4) << hitRatio << ","
+			 << r.diskReads << "," << r.diskWrites << "," << op << ","
+			 << setprecision(1) << r.p50 << "," << r.p99 << "\n";
+	}
+	else if (format == OUTPUT_JSON) {
+		cout << "{\"workload\": \"" << workload << "\", \"policy\": \"" << policy
+			 << "\", \"frames\": " << numFrames << ", \"ops\": " << r.ops
+			 << ", \"seconds\": " << setprecision(6) << r.seconds
+			 << ", \"ns_per_op\": " << setprecision(1) << nsPerOp
+			 << ", \"ops_per_sec\": " << setprecision(0) << opsPerSec
+			 << ", \"hit_ratio\": " << setprecision(4) << hitRatio
+			 << ", \"disk_reads\": " << r.diskReads << ", \"disk_writes\": " << r.diskWrites
+			 << ", \"latency_op\": \"" << op << "\", \"p50_ns\": " << setprecision(1) << r.p50
+			 << ", \"p99_ns\": " << r.p99 << "}\n";
+	}
+	else {
+		cout << left << setw(11) << workload << setw(14) << policy << right
+			 << setw(8) << numFrames << setprecision(1) << setw(10) << nsPerOp
+			 << setprecision(0) << setw(12) << opsPerSec
+			 << setprecision(1) << setw(8) << hitRatio * 100
+			 << setw(10) << r.diskReads << setw(10) << r.diskWrites
+			 << "  " << left << setw(12) << op << right
+			 << setprecision(0) << setw(10) << r.p50 << setw(10) << r.p99 << endl;
+	}
+	cout.flags(flags);
+}
+
+//--------------------------------------------------------------------
+// RunOne
+//
+// Input    : w, policy, numFrames, ops - what to run
+// Output   : result - filled in from the timing and the pool's counters
+// Purpose  : Create a database and a pool for one run and tear them
+//            down afterwards, so runs do not share state.
+// Return   : OK, or the error that stopped the run.
+//--------------------------------------------------------------------
+static Status RunOne( const Workload& w, const string& policy, int numFrames, long long ops,
+                      const char* dbname, const DBOptions& options, BenchResult& result )
+{
+	Status status;
+	unsigned dbPages = (unsigned)numFrames * w.filePages + 256;
+	minibase_globals = new SystemDefs(status, dbname, dbPages, numFrames, policy.c_str(), &options);
+	if (status == OK) {
+		seed = 12345;
+		result.ops = ops;
+		status = w.run(numFrames, ops, result);
+
+		BufStats stats = MINIBASE_BM->GetStats();
+		result.hits = stats.hits;
+		result.misses = stats.misses;
+		result.diskReads = stats.diskReads;
+		result.diskWrites = stats.diskWrites;
+		result.p50 = MINIBASE_BM->GetLatencyPercentile(result.latencyOp, 0.5);
+		result.p99 = MINIBASE_BM->GetLatencyPercentile(result.latencyOp, 0.99);
+	}
+
+	delete minibase_globals;
+	minibase_globals = 0;
+	remove(dbname);
+	return status;
+}
+
+int BufMgrBench( int argc, char** argv )
+{
+	vector<const Workload*> selected;
+	vector<string> policies;
+	vector<int> sizes;
+	long long ops = 0;
+	OutputFormat format = OUTPUT_TABLE;
+	const char* dbname = "bufmgr-bench.minibase-db";
+	DBOptions options;
+
+	for (int i = 0; i < argc; i++) {
+		if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+			const char* name = argv[++i];
+			int w = 0;
+			while (w < numWorkloads && strcmp(workloads[w].name, name) != 0) w++;
+			if (w == numWorkloads) { Usage(); return 2; }
+			selected.push_back(&workloads[w]);
+		}
+		else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) policies.push_back(argv[++i]);
+		else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+			if (!ParseSizes(argv[++i], sizes)) { Usage(); return 2; }
+		}
+		else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			ops = atoll(argv[++i]);
+			if (ops <= 0) { Usage(); return 2; }
+		}
+		else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+			if (!Storage::ParseKind(argv[++i], options.storage)) { Usage(); return 2; }
+		}
+		else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) options.device = argv[++i];
+		else if (strcmp(argv[i], "-c") == 0) format = OUTPUT_CSV;
+		else if (strcmp(argv[i], "-j") == 0) format = OUTPUT_JSON;
+		else if (argv[i][0] != '-') dbname = argv[i];
+		else { Usage(); return 2; }
+	}
+
+	if (selected.empty())
+		for (int w = 0; w < numWorkloads; w++) selected.push_back(&workloads[w]);
+	if (policies.empty()) ReplacerRegistry::GetNames(policies);
+	if (sizes.empty()) {
+		sizes.push_back(64);
+		sizes.push_back(256);
+		sizes.push_back(1024);
+	}
+
+	PrintHeader(format);
+
+	Status status = OK;
+	for (size_t w = 0; w < selected.size() && status == OK; w++) {
+		for (size_t p = 0; p < policies.size() && status == OK; p++) {
+			for (size_t s = 0; s < sizes.size() && status == OK; s++) {
+				BenchResult result;
+				status = RunOne(*selected[w], policies[p], sizes[s],
+				                ops ? ops : selected[w]->defaultOps, dbname, options, result);
+				if (status == OK)
+					PrintResult(format, selected[w]->name, policies[p], sizes[s], result);
+				else
+					cerr << "*** " << selected[w]->name << " with " << policies[p]
+						 << " and " << sizes[s] << " frames failed.\n";
+			}
+		}
+	}
+
+	if (status != OK) minibase_errors.show_errors();
+	return (status == OK) ? 0 : 1;
+}
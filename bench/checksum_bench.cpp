@@ -0,0 +1,118 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+
+#include "bench.h"
+#include "bufmgr.h"
+#include "checksum.h"
+#include "db.h"
+
+// Two measurements:
+//
+//   1. CRC32C over one page, hardware and software.
+//   2. The PinPage miss path with checksums on and off.  A file several
+//      times the pool size is scanned in order, so every pin misses, reads
+//      the page from the DB and (when on) verifies its trailer.  The pages
+//      are clean, so no write-back is timed.  The two settings are
+//      alternated for a few rounds and the best round of each is kept, so
+//      that file-cache warm-up does not land on one side.
+
+static const int crcRounds = 200000;
+static const int poolFrames = NUMBUF;
+static const int filePages = NUMBUF * 8;
+static const int scans = 20;
+static const int rounds = 5;
+
+static double CrcNsPerPage( unsigned int (*crc)( const void*, size_t ), const char* page )
+{
+	volatile unsigned int sink = 0;
+	double start = BenchNow();
+	for (int i = 0; i < crcRounds; i++)
+		sink += crc(page, MAX_SPACE);
+	return (BenchNow() - start) * 1e9 / crcRounds;
+}
+
+static double MissNsPerPage( PageID firstPid, Status& status )
+{
+	Page* pg;
+	double start = BenchNow();
+	for (int s = 0; s < scans && status == OK; s++) {
+		for (PageID pid = firstPid; pid < firstPid + filePages && status == OK; pid++) {
+			status = MINIBASE_BM->PinPage(pid, pg);
+			if (status == OK)
+				status = MINIBASE_BM->UnpinPage(pid);
+		}
+	}
+	return (BenchNow() - start) * 1e9 / ((double)scans * filePages);
+}
+
+int ChecksumBench( int argc, char** argv )
+{
+	Status status;
+	const char* dbname = (argc > 0) ? argv[0] : "checksum-bench.minibase-db";
+
+	char page[MINIBASE_PAGESIZE];
+	for (int i = 0; i < MINIBASE_PAGESIZE; i++)
+		page[i] = (char)(i * 31 + 7);
+
+	cout << "CRC32C over " << MAX_SPACE << " bytes\n";
+	cout << fixed << setprecision(0);
+	cout << "  software: " << CrcNsPerPage(Crc32cSoftware, page) << " ns/page\n";
+	if (Crc32cHardware())
+		cout << "  sse4.2:   " << CrcNsPerPage(Crc32c, page) << " ns/page\n";
+	else
+		cout << "  sse4.2:   not available on this CPU\n";
+
+	minibase_globals = new SystemDefs(status, dbname, filePages + 64, poolFrames, "LRU");
+	if (status != OK) {
+		cerr << "Error initializing Minibase.\n";
+		minibase_errors.show_errors();
+		return 1;
+	}
+
+	// Write every page once, with checksums, so both runs read the same file.
+	PageID firstPid;
+	Page* pg;
+	status = MINIBASE_DB->AllocatePage(firstPid, filePages);
+	for (PageID pid = firstPid; pid < firstPid + filePages && status == OK; pid++) {
+		status = MINIBASE_BM->PinPage(pid, pg, true);
+		if (status == OK) {
+			memcpy((char*)pg, page, MAX_SPACE);
+			status = MINIBASE_BM->UnpinPage(pid, true);
+		}
+	}
+	if (status == OK)
+		status = MINIBASE_BM->FlushAllPages();
+
+	double off = 0, on = 0;
+	for (int r = 0; r < rounds && status == OK; r++) {
+		MINIBASE_BM->SetPageChecksums(false);
+		double t = MissNsPerPage(firstPid, status);
+		if (r == 0 || t < off) off = t;
+
+		MINIBASE_BM->SetPageChecksums(true);
+		t = MissNsPerPage(firstPid, status);
+		if (r == 0 || t < on) on = t;
+	}
+
+	if (status != OK) {
+		cerr << "*** The miss-path scan failed.\n";
+		minibase_errors.show_errors();
+	} else {
+		cout << "PinPage miss, " << filePages << " pages through " << poolFrames << " frames\n";
+		cout << "  checksums off: " << off << " ns/miss\n";
+		cout << "  checksums on:  " << on << " ns/miss ("
+			 << (on - off) << " ns overhead)\n";
+	}
+
+	MINIBASE_BM->FlushAllPages();
+	delete minibase_globals;
+	minibase_globals = 0;
+	remove(dbname);
+
+	return (status == OK) ? 0 : 1;
+}
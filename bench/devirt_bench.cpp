@@ -0,0 +1,163 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+
+#include "bench.h"
+#include "bufmgr.h"
+#include "buf_pool.h"
+#include "lru.h"
+#include "db.h"
+
+// The same pin/unpin loops run against:
+//
+//   BufMgr                  - the wrapper, policy behind a Replacer*
+//   BufPool<DynamicPolicy>  - the core with a virtual replacer
+//   BufPool<LRU>            - the core with LRU inlined
+//
+// "hit" pins a page already in the pool; "miss" scans a file twice the
+// pool size, so every pin evicts a page and reads one (from the OS cache).
+// The pool is kept small so the replacer's own list work does not swamp
+// the call overhead being compared.  Then 8 KB and 16 KB page variants of
+// BufPool<LRU> run the miss loop, to show the cost per byte of bigger pages.
+
+static const int poolFrames = 16;
+static const int filePages = poolFrames * 2;
+static const int hitPins = 4000000;
+static const int missScans = 20000;
+
+template <class Pool>
+static double HitNs( Pool& pool, PageID pid, Status& status )
+{
+	Page* pg;
+	status = pool.PinPage(pid, pg);
+	if (status == OK) status = pool.UnpinPage(pid);
+
+	double start = BenchNow();
+	for (int i = 0; i < hitPins && status == OK; i++) {
+		status = pool.PinPage(pid, pg);
+		if (status == OK)
+			status = pool.UnpinPage(pid);
+	}
+	return (BenchNow() - start) * 1e9 / hitPins;
+}
+
+template <class Pool>
+static double MissNs( Pool& pool, PageID firstPid, int numPages, int stride, Status& status )
+{
+	Page* pg;
+	double start = BenchNow();
+	for (int s = 0; s < missScans && status == OK; s++) {
+		for (int i = 0; i < numPages && status == OK; i++) {
+			PageID pid = firstPid + i * stride;
+			status = pool.PinPage(pid, pg);
+			if (status == OK)
+				status = pool.UnpinPage(pid);
+		}
+	}
+	return (BenchNow() - start) * 1e9 / ((double)missScans * numPages);
+}
+
+// Allocate and write numPages pages of a pool, returning the first.
+template <class Pool>
+static PageID MakePages( Pool& pool, int numPages, Status& status )
+{
+	PageID firstPid;
+	Page* pg;
+	status = pool.NewPage(firstPid, pg, numPages);
+	if (status != OK) return INVALID_PAGE;
+	memset((char*)pg, 0, Pool::PAGE_SIZE);
+	status = pool.UnpinPage(firstPid, true);
+
+	for (int i = 1; i < numPages && status == OK; i++) {
+		PageID pid = firstPid + i * Pool::BLOCKS_PER_PAGE;
+		status = pool.PinPage(pid, pg, true);
+		if (status == OK) {
+			memset((char*)pg, 0, Pool::PAGE_SIZE);
+			status = pool.UnpinPage(pid, true);
+		}
+	}
+	if (status == OK) status = pool.FlushAllPages();
+	return firstPid;
+}
+
+template <int PageSize>
+static void PageSizeRow( Status& status )
+{
+	BufPool<LRU, PageSize> pool(poolFrames);
+	PageID firstPid = MakePages(pool, filePages, status);
+	if (status != OK) return;
+
+	double ns = MissNs(pool, firstPid, filePages, PageSize / MINIBASE_PAGESIZE, status);
+	cout << setw(8) << PageSize / 1024 << " KB" << setw(12) << ns
+		 << setw(12) << ns * MINIBASE_PAGESIZE / PageSize << endl;
+
+	pool.FlushAllPages();
+	for (int i = 0; i < filePages; i++)
+		MINIBASE_DB->DeallocatePage(firstPid + i * (PageSize / MINIBASE_PAGESIZE), PageSize / MINIBASE_PAGESIZE);
+}
+
+int DevirtBench( int argc, char** argv )
+{
+	Status status;
+	const char* dbname = (argc > 0) ? argv[0] : "devirt-bench.minibase-db";
+
+	minibase_globals = new SystemDefs(status, dbname, filePages * 8 + 64, poolFrames, "LRU");
+	if (status != OK) {
+		cerr << "Error initializing Minibase.\n";
+		minibase_errors.show_errors();
+		return 1;
+	}
+
+	BufPool<DynamicPolicy> dynamicPool(poolFrames);
+	dynamicPool.GetPolicy().Set(new LRU());
+	BufPool<LRU> staticPool(poolFrames);
+
+	PageID firstPid = MakePages(staticPool, filePages, status);
+
+	cout << fixed << setprecision(1);
+	cout << poolFrames << "-frame pool, LRU, ns per pin+unpin\n";
+	cout << setw(24) << "" << setw(10) << "hit" << setw(10) << "miss" << endl;
+
+	if (status == OK) {
+		double hit = HitNs(*MINIBASE_BM, firstPid, status);
+		double miss = MissNs(*MINIBASE_BM, firstPid, filePages, 1, status);
+		MINIBASE_BM->FlushAllPages();
+		cout << setw(24) << "BufMgr" << setw(10) << hit << setw(10) << miss << endl;
+	}
+	if (status == OK) {
+		double hit = HitNs(dynamicPool, firstPid, status);
+		double miss = MissNs(dynamicPool, firstPid, filePages, 1, status);
+		dynamicPool.FlushAllPages();
+		cout << setw(24) << "BufPool<DynamicPolicy>" << setw(10) << hit << setw(10) << miss << endl;
+	}
+	if (status == OK) {
+		double hit = HitNs(staticPool, firstPid, status);
+		double miss = MissNs(staticPool, firstPid, filePages, 1, status);
+		staticPool.FlushAllPages();
+		cout << setw(24) << "BufPool<LRU>" << setw(10) << hit << setw(10) << miss << endl;
+	}
+
+	if (status == OK) {
+		cout << "BufPool<LRU> misses by page size\n";
+		cout << setw(11) << "page" << setw(12) << "ns/miss" << setw(12) << "ns/4KB" << endl;
+		PageSizeRow<MINIBASE_PAGESIZE>(status);
+	}
+	if (status == OK) PageSizeRow<2 * MINIBASE_PAGESIZE>(status);
+	if (status == OK) PageSizeRow<4 * MINIBASE_PAGESIZE>(status);
+
+	if (status != OK) {
+		cerr << "*** The benchmark failed.\n";
+		minibase_errors.show_errors();
+	}
+
+	MINIBASE_BM->FlushAllPages();
+	delete minibase_globals;
+	minibase_globals = 0;
+	remove(dbname);
+
+	return (status == OK) ? 0 : 1;
+}
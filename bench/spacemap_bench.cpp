@@ -0,0 +1,75 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+
+#include "bench.h"
+#include "bufmgr.h"
+#include "db.h"
+
+// Allocate and free runs of 1 to 1M pages against a database big enough to
+// hold the largest run.  Only the space map is touched, so the pages never
+// need to be read or written; the cost measured is the free-extent search
+// plus set_bits.  Per-thread extent caches are switched off so that single
+// pages go through the same path as runs.
+
+static const int minRun = 1;
+static const int maxRun = 1 << 20;
+
+// Roughly this many pages are allocated (and freed) per run size, so that
+// small runs are timed over many calls and large runs over a few.
+static const double pagesPerSize = 16.0 * (1 << 20);
+
+int SpaceMapBench( int argc, char** argv )
+{
+	Status status;
+	const char* dbname = (argc > 0) ? argv[0] : "spacemap-bench.minibase-db";
+
+	// The run of 1M pages plus page 0 and the space map itself.
+	unsigned dbPages = maxRun + 64;
+
+	minibase_globals = new SystemDefs(status, dbname, dbPages, NUMBUF, "LRU");
+	if (status != OK) {
+		cerr << "Error initializing Minibase.\n";
+		minibase_errors.show_errors();
+		return 1;
+	}
+
+	MINIBASE_DB->SetExtentCacheSize(0);
+
+	cout << setw(10) << "run_size" << setw(12) << "iterations"
+		 << setw(16) << "alloc+free/s" << setw(16) << "pages/s" << endl;
+
+	for (int runSize = minRun; runSize <= maxRun && status == OK; runSize *= 4) {
+		int iterations = (int)(pagesPerSize / runSize);
+		if (iterations > 200000) iterations = 200000;
+		if (iterations < 16) iterations = 16;
+
+		PageID pid;
+		double start = BenchNow();
+		for (int i = 0; i < iterations && status == OK; i++) {
+			status = MINIBASE_DB->AllocatePage(pid, runSize);
+			if (status == OK)
+				status = MINIBASE_DB->DeallocatePage(pid, runSize);
+		}
+		double elapsed = BenchNow() - start;
+
+		if (status != OK) {
+			cerr << "*** Allocating a run of " << runSize << " pages failed.\n";
+			minibase_errors.show_errors();
+			break;
+		}
+
+		cout << setw(10) << runSize << setw(12) << iterations
+			 << setw(16) << (long)(iterations / elapsed)
+			 << setw(16) << (long)((double)iterations * runSize / elapsed) << endl;
+	}
+
+	delete minibase_globals;
+	minibase_globals = 0;
+	remove(dbname);
+
+	return (status == OK) ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+
+#include "bench.h"
+#include "bufmgr.h"
+#include "compressed_cache.h"
+#include "db.h"
+
+// Uniform random pins over working sets of 1x to 3x the pool size, without
+// and with a CompressedCache below the pool.  The cache gets the same
+// memory budget as the pool itself.  Pages hold record-like text, so they
+// compress a few times over, roughly like real heap pages.  The database
+// file is small enough to stay in the OS file cache: the time saved here is
+// the read system call, and on a real disk it would be much larger.
+
+static const int poolFrames = 256;
+static const int pinsPerRun = 400000;
+static const double workingSets[] = { 1.0, 1.5, 2.0, 2.5, 3.0 };
+static const int numWorkingSets = sizeof(workingSets) / sizeof(workingSets[0]);
+
+static void FillPage( char* page, PageID pid )
+{
+	int len = 0;
+	for (int rec = 0; len < MAX_SPACE - 64; rec++)
+		len += sprintf(page + len, "%06d|customer-%05d|ORDER-%04d|status=OPEN|",
+		               (int)pid, rec * 7 + (int)pid % 13, rec);
+	memset(page + len, 0, MAX_SPACE - len);
+}
+
+static double PinNs( PageID firstPid, int numPages, Status& status )
+{
+	unsigned int seed = 12345;
+	Page* pg;
+	double start = BenchNow();
+	for (int i = 0; i < pinsPerRun && status == OK; i++) {
+		seed = seed * 1103515245 + 12345;
+		PageID pid = firstPid + (PageID)((seed >> 8) % numPages);
+		status = MINIBASE_BM->PinPage(pid, pg);
+		if (status == OK)
+			status = MINIBASE_BM->UnpinPage(pid);
+	}
+	return (BenchNow() - start) * 1e9 / pinsPerRun;
+}
+
+int Tier2Bench( int argc, char** argv )
+{
+	Status status;
+	const char* dbname = (argc > 0) ? argv[0] : "tier2-bench.minibase-db";
+	int filePages = (int)(poolFrames * workingSets[numWorkingSets - 1]);
+
+	minibase_globals = new SystemDefs(status, dbname, filePages + 64, poolFrames, "LRU");
+	if (status != OK) {
+		cerr << "Error initializing Minibase.\n";
+		minibase_errors.show_errors();
+		return 1;
+	}
+
+	PageID firstPid;
+	Page* pg;
+	status = MINIBASE_DB->AllocatePage(firstPid, filePages);
+	for (PageID pid = firstPid; pid < firstPid + filePages && status == OK; pid++) {
+		status = MINIBASE_BM->PinPage(pid, pg, true);
+		if (status == OK) {
+			FillPage((char*)pg, pid);
+			status = MINIBASE_BM->UnpinPage(pid, true);
+		}
+	}
+	if (status == OK)
+		status = MINIBASE_BM->FlushAllPages();
+
+	cout << poolFrames << "-frame pool, compressed cache budget "
+		 << poolFrames * MINIBASE_PAGESIZE / 1024 << " KB, "
+		 << pinsPerRun << " random pins per run\n";
+	cout << setw(8) << "wset" << setw(14) << "no-tier2 ns" << setw(12) << "tier2 ns"
+		 << setw(12) << "pool miss" << setw(12) << "tier2 hit" << endl;
+
+	for (int w = 0; w < numWorkingSets && status == OK; w++) {
+		int numPages = (int)(poolFrames * workingSets[w]);
+
+		MINIBASE_BM->SetVictimCache(NULL);
+		MINIBASE_BM->FlushAllPages();
+		PinNs(firstPid, numPages, status);				// warm up
+		double plain = PinNs(firstPid, numPages, status);
+
+		// Every pool miss asks the cache, so its lookups are the misses.
+		MINIBASE_BM->FlushAllPages();
+		CompressedCache* tier2 = new CompressedCache((size_t)poolFrames * MINIBASE_PAGESIZE);
+		MINIBASE_BM->SetVictimCache(tier2);
+		PinNs(firstPid, numPages, status);
+		MINIBASE_BM->ResetStat();
+		double tiered = PinNs(firstPid, numPages, status);
+
+		long misses = tier2->GetNumLookups();
+		cout << fixed << setprecision(1) << setw(7) << workingSets[w] << "x"
+			 << setprecision(0) << setw(14) << plain << setw(12) << tiered
+			 << setprecision(3) << setw(12) << (double)misses / pinsPerRun
+			 << setw(12) << (misses > 0 ? (double)tier2->GetNumHits() / misses : 0.0) << endl;
+	}
+
+	if (status != OK) {
+		cerr << "*** The benchmark failed.\n";
+		minibase_errors.show_errors();
+	}
+
+	MINIBASE_BM->FlushAllPages();
+	delete minibase_globals;
+	minibase_globals = 0;
+	remove(dbname);
+
+	return (status == OK) ? 0 : 1;
+}
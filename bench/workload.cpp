@@ -0,0 +1,173 @@
+#include <math.h>
+#include <string>
+
+using namespace std;
+
+#include "workload.h"
+#include "replacer_registry.h"
+
+// Every page equally likely.
+class UniformPattern : public AccessPattern
+{
+	public:
+		UniformPattern( int numPages, unsigned seed ) : AccessPattern(seed), numPages(numPages) {}
+		int Next() { return (int)(NextRandom() % numPages); }
+	private:
+		int numPages;
+};
+
+// Zipfian over page ranks, page 0 the most popular, as YCSB generates it
+// (Gray et al., "Quickly generating billion-record synthetic databases").
+// zeta(n) is summed once per pattern, which is quick next to a run.
+class ZipfPattern : public AccessPattern
+{
+	public:
+		ZipfPattern( int numPages, double theta, unsigned seed ) : AccessPattern(seed)
+		{
+			this->numPages = numPages;
+			this->theta = theta;
+			double zeta2 = 1 + pow(0.5, theta);
+			zetan = 0;
+			for (int i = 1; i <= numPages; i++)
+				zetan += 1 / pow((double)i, theta);
+			alpha = 1 / (1 - theta);
+			eta = (1 - pow(2.0 / numPages, 1 - theta)) / (1 - zeta2 / zetan);
+		}
+
+		int Next()
+		{
+			double u = NextDouble();
+			double uz = u * zetan;
+			if (uz < 1) return 0;
+			if (uz < 1 + pow(0.5, theta)) return (numPages > 1) ? 1 : 0;
+			int page = (int)(numPages * pow(eta * u - eta + 1, alpha));
+			return (page < numPages) ? page : numPages - 1;
+		}
+
+	private:
+		int numPages;
+		double theta, zetan, alpha, eta;
+};
+
+// A hot set of the first hot*numPages pages gets ops of the accesses;
+// both sets are uniform inside.
+class HotspotPattern : public AccessPattern
+{
+	public:
+		HotspotPattern( int numPages, double hot, double ops, unsigned seed ) : AccessPattern(seed)
+		{
+			this->numPages = numPages;
+			hotPages = (int)(hot * numPages);
+			if (hotPages < 1) hotPages = 1;
+			if (hotPages > numPages) hotPages = numPages;
+			hotOps = ops;
+		}
+
+		int Next()
+		{
+			if (hotPages == numPages || NextDouble() < hotOps)
+				return (int)(NextRandom() % hotPages);
+			return hotPages + (int)(NextRandom() % (numPages - hotPages));
+		}
+
+	private:
+		int numPages, hotPages;
+		double hotOps;
+};
+
+// Every page in order, round and round; each thread starts at its own
+// share of the file.
+class ScanPattern : public AccessPattern
+{
+	public:
+		ScanPattern( int numPages, int start ) : AccessPattern(0), numPages(numPages), next(start) {}
+
+		int Next()
+		{
+			int page = next;
+			next = (next + 1 < numPages) ? next + 1 : 0;
+			return page;
+		}
+
+	private:
+		int numPages, next;
+};
+
+// A page nested-loop join: the first outer pages are the outer relation
+// and the rest the inner one.  Each outer page is followed by a scan of
+// the whole inner relation.  Threads start at different outer pages.
+class JoinPattern : public AccessPattern
+{
+	public:
+		JoinPattern( int numPages, int outer, int start ) : AccessPattern(0)
+		{
+			this->numPages = numPages;
+			this->outer = outer;
+			outerPage = start % outer;
+			innerPage = numPages;		// the outer page comes first
+		}
+
+		int Next()
+		{
+			if (innerPage < numPages) return innerPage++;
+			int page = outerPage;
+			outerPage = (outerPage + 1 < outer) ? outerPage + 1 : 0;
+			innerPage = outer;
+			return page;
+		}
+
+	private:
+		int numPages, outer, outerPage, innerPage;
+};
+
+AccessPattern* AccessPattern::Create( const char* spec, int numPages, int thread, int numThreads )
+{
+	string text(spec ? spec : "");
+	size_t colon = text.find(':');
+	string name = text.substr(0, colon);
+
+	ReplacerParams params;
+	if (colon != string::npos && !params.Parse(text.substr(colon + 1))) return NULL;
+	if (numPages < 1) return NULL;
+
+	unsigned seed = 12345 + thread;
+	bool ok = true;
+	AccessPattern* pattern = NULL;
+
+	if (name == "uniform") {
+		pattern = new UniformPattern(numPages, seed);
+	}
+	else if (name == "zipf") {
+		double theta = params.GetDouble("theta", 0.99, ok);
+		if (ok && theta > 0 && theta < 1) pattern = new ZipfPattern(numPages, theta, seed);
+	}
+	else if (name == "hotspot") {
+		double hot = params.GetDouble("hot", 0.2, ok);
+		double ops = params.GetDouble("ops", 0.8, ok);
+		if (ok && hot > 0 && hot <= 1 && ops >= 0 && ops <= 1)
+			pattern = new HotspotPattern(numPages, hot, ops, seed);
+	}
+	else if (name == "scan") {
+		pattern = new ScanPattern(numPages, (int)((long long)numPages * thread / numThreads));
+	}
+	else if (name == "join") {
+		int outer = params.GetInt("outer", numPages / 10, ok);
+		if (ok && outer >= 1 && outer < numPages)
+			pattern = new JoinPattern(numPages, outer, thread);
+	}
+
+	if (pattern && params.FirstUnused() != NULL) {
+		delete pattern;
+		pattern = NULL;
+	}
+	return pattern;
+}
+
+void AccessPattern::List( ostream& out )
+{
+	out << "  uniform\tevery page equally likely\n"
+		<< "  zipf\t\tzipfian; theta=<skew> (0.99), between 0 and 1\n"
+		<< "  hotspot\thot=<fraction of pages> (0.2) get ops=<fraction of pins> (0.8)\n"
+		<< "  scan\t\tsequential and wrapping, each thread from its own offset\n"
+		<< "  join\t\tpage nested-loop join; outer=<pages> (a tenth), the rest inner\n";
+}
@@ -0,0 +1,49 @@
+// -*- C++ -*-
+#ifndef _WORKLOAD_H_
+#define _WORKLOAD_H_
+
+#include <iostream>
+#include <string>
+
+// Page access patterns for the multi-threaded workload driver.  Each
+// thread owns an AccessPattern, made from a spec such as "zipf" or
+// "hotspot:hot=0.1,ops=0.9" (see List), and calls Next for the index of
+// the page to pin next, in [0, numPages).  Random patterns are seeded by
+// thread, so a run is repeatable.
+class AccessPattern
+{
+	public:
+
+		virtual ~AccessPattern() {}
+
+		virtual int Next() = 0;
+
+		// The pattern for thread (of numThreads) over numPages pages, or
+		// NULL if the spec names no pattern or has a bad parameter.
+		static AccessPattern* Create( const char* spec, int numPages, int thread, int numThreads );
+
+		// Print the patterns and their parameters.
+		static void List( std::ostream& out );
+
+	protected:
+
+		AccessPattern( unsigned long long seed ) : state(seed * 0x9E3779B97F4A7C15ULL + 1) {}
+
+		// xorshift64*: fast, and good enough to pick pages.
+		unsigned long long NextRandom()
+		{
+			state ^= state >> 12;
+			state ^= state << 25;
+			state ^= state >> 27;
+			return state * 0x2545F4914F6CDD1DULL;
+		}
+
+		// Uniform in [0, 1).
+		double NextDouble() { return (NextRandom() >> 11) * (1.0 / 9007199254740992.0); }
+
+	private:
+
+		unsigned long long state;
+};
+
+#endif
@@ -0,0 +1,328 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+#include "bench.h"
+#include "bufmgr.h"
+#include "db.h"
+#include "delay_storage.h"
+#include "workload.h"
+
+// N threads pinning pages of one file through MINIBASE_BM:
+//
+//     BufMgrBench workload [-t threads] [-a pattern] [-p policy] [-f frames]
+//                          [-P pages] [-n ops] [-w write-fraction]
+//                          [-H hold-us] [-l] [-c | -j] [dbname]
+//
+// -t  threads (4).
+// -a  the access pattern, see AccessPattern ("zipf").
+// -p  the replacement policy spec ("Clock").
+// -f  pool frames (256); must exceed the thread count, so that a pin
+//     never finds every frame pinned.
+// -P  pages in the file (4096).
+// -n  pins per thread (200000).
+// -w  the fraction of pins that write the page and unpin it dirty (0.05).
+// -H  microseconds each page stays pinned, spent spinning (0).
+// -l  pin into PageGuards, latching each page shared, or exclusive if it
+//     is to be written, so that readers and writers of a page exclude
+//     each other.  Latch waits count as pin latency.
+// -c  print CSV; -j print one JSON object per line.  The default is a
+//     table.
+//
+// Each thread reports its throughput and the latency of its PinPage
+// calls, lock waits included; the last line is the whole run.  A written
+// page gets a counter bumped; without -l threads may bump the same one at
+// once, and lost updates do not matter here.
+
+struct ThreadResult {
+	long long ops;
+	long long writes;
+	double seconds;
+	unsigned long long ticks;	// LatencyStats::Now() over the same time
+	unsigned long long counts[LatencyStats::NUM_BUCKETS];	// pin latency in ticks
+	Status status;
+};
+
+struct WorkloadConfig {
+	const char* pattern;
+	int numThreads;
+	int numPages;
+	long long ops;
+	double writeFraction;
+	double holdUs;
+	bool latch;
+	PageID firstPid;
+};
+
+static atomic<bool> go;
+
+static void RunThread( const WorkloadConfig* config, int thread, ThreadResult* result )
+{
+	memset(result, 0, sizeof(*result));
+	result->status = OK;
+	AccessPattern* pattern = AccessPattern::Create(config->pattern, config->numPages, thread, config->numThreads);
+	unsigned int seed = 777 + thread;
+
+	while (!go.load(memory_order_acquire))
+		this_thread::yield();
+
+	Page* pg;
+	PageGuard guard;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	unsigned long long startTicks = LatencyStats::Now();
+	for (long long i = 0; i < config->ops; i++) {
+		PageID pid = config->firstPid + pattern->Next();
+		seed = seed * 1103515245 + 12345;
+		bool write = (seed >> 8) / 16777216.0 < config->writeFraction;
+
+		unsigned long long before = LatencyStats::Now();
+		Status status;
+		if (config->latch) {
+			status = MINIBASE_BM->PinPage(pid, guard, write ? PIN_WRITE : PIN_READ);
+			pg = guard.GetPage();
+		}
+		else
+			status = MINIBASE_BM->PinPage(pid, pg);
+		result->counts[LatencyStats::Bucket(LatencyStats::Now() - before)]++;
+		if (status != OK) {
+			result->status = status;
+			break;
+		}
+
+		if (config->holdUs > 0) {
+			chrono::steady_clock::time_point until = chrono::steady_clock::now()
+				+ chrono::nanoseconds((long long)(config->holdUs * 1000));
+			while (chrono::steady_clock::now() < until) {}
+		}
+
+		if (write) {
+			((int*)pg)[0]++;
+			result->writes++;
+		}
+		status = config->latch ? guard.Release() : MINIBASE_BM->UnpinPage(pid, write);
+		if (status != OK) {
+			result->status = status;
+			break;
+		}
+		result->ops++;
+	}
+	result->ticks = LatencyStats::Now() - startTicks;
+	result->seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	delete pattern;
+}
+
+// The lowest value of the bucket holding quantile q, as LatencyStats
+// reports it, in nanoseconds.
+static double Percentile( const unsigned long long* counts, double q, double nsPerTick )
+{
+	unsigned long long total = 0;
+	for (int b = 0; b < LatencyStats::NUM_BUCKETS; b++)
+		total += counts[b];
+	if (total == 0) return 0;
+
+	unsigned long long rank = (unsigned long long)(q * total + 0.999999);
+	if (rank < 1) rank = 1;
+	unsigned long long seen = 0;
+	int b = 0;
+	for ( ; b < LatencyStats::NUM_BUCKETS - 1; b++) {
+		seen += counts[b];
+		if (seen >= rank) break;
+	}
+	return LatencyStats::BucketLow(b) * nsPerTick;
+}
+
+enum OutputFormat { OUTPUT_TABLE, OUTPUT_CSV, OUTPUT_JSON };
+
+static void PrintRow( OutputFormat format, const string& thread, const ThreadResult& r, double nsPerTick )
+{
+	double opsPerSec = (r.seconds > 0) ? r.ops / r.seconds : 0;
+	double p50 = Percentile(r.counts, 0.5, nsPerTick);
+	double p99 = Percentile(r.counts, 0.99, nsPerTick);
+	double p999 = Percentile(r.counts, 0.999, nsPerTick);
+	double max = Percentile(r.counts, 1.0, nsPerTick);
+
+	ios::fmtflags flags = cout.flags();
+	cout << fixed << setprecision(0);
+	if (format == OUTPUT_CSV) {
+		cout << thread << "," << r.ops << "," << r.writes << "," << setprecision(6) << r.seconds
+			 << "," << setprecision(0) << opsPerSec << "," << p50 << "," << p99 << ","
+			 << p999 << "," << max << "\n";
+	}
+	else if (format == OUTPUT_JSON) {
+		cout << "{\"thread\": \"" << thread << "\", \"ops\": " << r.ops << ", \"writes\": " << r.writes
+			 << ", \"seconds\": " << setprecision(6) << r.seconds << setprecision(0)
+			 << ", \"ops_per_sec\": " << opsPerSec << ", \"pin_p50_ns\": " << p50
+			 << ", \"pin_p99_ns\": " << p99 << ", \"pin_p999_ns\": " << p999
+			 << ", \"pin_max_ns\": " << max << "}\n";
+	}
+	else {
+		cout << setw(8) << thread << setw(10) << r.ops << setw(10) << r.writes
+			 << setprecision(3) << setw(10) << r.seconds << setprecision(0)
+			 << setw(12) << opsPerSec << setw(10) << p50 << setw(10) << p99
+			 << setw(10) << p999 << setw(12) << max << endl;
+	}
+	cout.flags(flags);
+}
+
+static void Usage()
+{
+	cerr << "Usage: BufMgrBench workload [-t threads] [-a pattern] [-p policy] [-f frames]\n"
+		 << "                            [-P pages] [-n ops] [-w write-fraction]\n"
+		 << "                            [-H hold-us] [-l] [-s file|direct|memory] [-d device]\n"
+		 << "                            [-c | -j] [dbname]\n\nPatterns:\n";
+	AccessPattern::List(cerr);
+	cerr << "Devices:\n";
+	DelayStorage::List(cerr);
+}
+
+int WorkloadBench( int argc, char** argv )
+{
+	WorkloadConfig config;
+	config.pattern = "zipf";
+	config.numThreads = 4;
+	config.numPages = 4096;
+	config.ops = 200000;
+	config.writeFraction = 0.05;
+	config.holdUs = 0;
+	config.latch = false;
+	const char* policy = "Clock";
+	int numFrames = 256;
+	OutputFormat format = OUTPUT_TABLE;
+	const char* dbname = "workload-bench.minibase-db";
+	DBOptions options;
+	bool badStorage = false;
+
+	for (int i = 0; i < argc; i++) {
+		bool more = i + 1 < argc;
+		if (strcmp(argv[i], "-t") == 0 && more) config.numThreads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-a") == 0 && more) config.pattern = argv[++i];
+		else if (strcmp(argv[i], "-p") == 0 && more) policy = argv[++i];
+		else if (strcmp(argv[i], "-f") == 0 && more) numFrames = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-P") == 0 && more) config.numPages = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-n") == 0 && more) config.ops = atoll(argv[++i]);
+		else if (strcmp(argv[i], "-w") == 0 && more) config.writeFraction = atof(argv[++i]);
+		else if (strcmp(argv[i], "-H") == 0 && more) config.holdUs = atof(argv[++i]);
+		else if (strcmp(argv[i], "-s") == 0 && more) badStorage = !Storage::ParseKind(argv[++i], options.storage);
+		else if (strcmp(argv[i], "-d") == 0 && more) options.device = argv[++i];
+		else if (strcmp(argv[i], "-l") == 0) config.latch = true;
+		else if (strcmp(argv[i], "-c") == 0) format = OUTPUT_CSV;
+		else if (strcmp(argv[i], "-j") == 0) format = OUTPUT_JSON;
+		else if (argv[i][0] != '-') dbname = argv[i];
+		else { Usage(); return 2; }
+	}
+
+	AccessPattern* check = AccessPattern::Create(config.pattern, config.numPages, 0, 1);
+	if (!check || config.numThreads < 1 || numFrames <= config.numThreads || config.ops < 1
+		|| config.writeFraction < 0 || config.writeFraction > 1 || config.holdUs < 0 || badStorage) {
+		delete check;
+		Usage();
+		return 2;
+	}
+	delete check;
+
+	Status status;
+	minibase_globals = new SystemDefs(status, dbname, config.numPages + 256, numFrames, policy, &options);
+	if (status != OK) {
+		cerr << "Error initializing Minibase.\n";
+		minibase_errors.show_errors();
+		return 1;
+	}
+
+	// Write the file, then warm the pool with a pass of the pattern.
+	Page* pg;
+	status = MINIBASE_DB->AllocatePage(config.firstPid, config.numPages);
+	for (int i = 0; i < config.numPages && status == OK; i++) {
+		status = MINIBASE_BM->PinPage(config.firstPid + i, pg, true);
+		if (status == OK) {
+			memset((char*)pg, 0, MINIBASE_PAGESIZE);
+			status = MINIBASE_BM->UnpinPage(config.firstPid + i, true);
+		}
+	}
+	if (status == OK) status = MINIBASE_BM->FlushAllPages();
+	AccessPattern* warm = AccessPattern::Create(config.pattern, config.numPages, 0, 1);
+	for (int i = 0; i < numFrames * 4 && status == OK; i++) {
+		PageID pid = config.firstPid + warm->Next();
+		status = MINIBASE_BM->PinPage(pid, pg);
+		if (status == OK) status = MINIBASE_BM->UnpinPage(pid);
+	}
+	delete warm;
+	MINIBASE_BM->ResetStat();
+
+	vector<ThreadResult> results(config.numThreads);
+	ThreadResult total;
+	memset(&total, 0, sizeof(total));
+	double wall = 0;
+
+	if (status == OK) {
+		go.store(false);
+		vector<thread> threads;
+		for (int t = 0; t < config.numThreads; t++)
+			threads.push_back(thread(RunThread, &config, t, &results[t]));
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		go.store(true, memory_order_release);
+		for (int t = 0; t < config.numThreads; t++)
+			threads[t].join();
+		wall = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+		for (int t = 0; t < config.numThreads; t++) {
+			const ThreadResult& r = results[t];
+			if (r.status != OK) status = r.status;
+			total.ops += r.ops;
+			total.writes += r.writes;
+			total.ticks += r.ticks;
+			for (int b = 0; b < LatencyStats::NUM_BUCKETS; b++)
+				total.counts[b] += r.counts[b];
+		}
+		total.seconds = wall;
+	}
+
+	if (status == OK) {
+		double threadSeconds = 0;
+		for (int t = 0; t < config.numThreads; t++)
+			threadSeconds += results[t].seconds;
+		double nsPerTick = total.ticks ? threadSeconds * 1e9 / total.ticks : 1;
+		BufStats stats = MINIBASE_BM->GetStats();
+
+		if (format == OUTPUT_TABLE) {
+			cout << config.numThreads << " threads, " << config.pattern << " over " << config.numPages
+				 << " pages, " << numFrames << " frames, " << policy << ", "
+				 << config.writeFraction * 100 << "% writes, hold " << config.holdUs << " us, "
+				 << (config.latch ? "latched" : "unlatched") << "; "
+				 << "hit ratio " << (stats.pinRequests ? (double)stats.hits / stats.pinRequests : 0) << endl;
+			cout << setw(8) << "thread" << setw(10) << "ops" << setw(10) << "writes"
+				 << setw(10) << "seconds" << setw(12) << "ops/s" << setw(10) << "pin p50"
+				 << setw(10) << "p99" << setw(10) << "p999" << setw(12) << "max ns" << endl;
+		}
+		else if (format == OUTPUT_CSV) {
+			cout << "thread,ops,writes,seconds,ops_per_sec,pin_p50_ns,pin_p99_ns,pin_p999_ns,pin_max_ns\n";
+		}
+
+		char name[16];
+		for (int t = 0; t < config.numThreads; t++) {
+			sprintf(name, "%d", t);
+			PrintRow(format, name, results[t], nsPerTick);
+		}
+		PrintRow(format, "all", total, nsPerTick);
+	}
+	else {
+		cerr << "*** The workload failed.\n";
+		minibase_errors.show_errors();
+	}
+
+	MINIBASE_BM->FlushAllPages();
+	delete minibase_globals;
+	minibase_globals = 0;
+	remove(dbname);
+
+	return (status == OK) ? 0 : 1;
+}
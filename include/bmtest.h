@@ -23,6 +23,17 @@ class BMTester : public TestDriver
 		int Test3();
 		int Test4();
 		int Test5();
+		int Test6();
+		int Test7();
+		int Test8();
+		int Test9();
+		int Test10();
+		int Test11();
+		int Test12();
+		int Test13();
+		int Test14();
+		int Test15();
+		int Test16();
 		const char* TestName();
 		void RunTest( Status& status, testFunction test );
 		Status RunAllTests();
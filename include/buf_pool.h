@@ -0,0 +1,879 @@
+#ifndef _BUF_POOL_H
+#define _BUF_POOL_H
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "db.h"
+#include "page.h"
+#include "buf_stats.h"
+#include "frame.h"
+#include "latency_stats.h"
+#include "mrc.h"
+#include "page_table.h"
+#include "replacer.h"
+#include "victim_cache.h"
+
+// Replacement policy that forwards to a Replacer chosen at run time.  This
+// is what BufMgr uses; a BufPool instantiated with a concrete policy such
+// as LRU calls it directly instead, and can inline it.
+class DynamicPolicy
+{
+	public:
+
+		DynamicPolicy() { replacer = NULL; }
+		~DynamicPolicy() { delete replacer; }
+
+		// Take ownership of r, deleting the previous replacer.
+		void Set(Replacer* r) { if (r != replacer) delete replacer; replacer = r; }
+		Replacer* Get() { return replacer; }
+
+		int PickVictim() { return replacer->PickVictim(); }
+		void AddFrame(int f) { replacer->AddFrame(f); }
+		void RemoveFrame(int f) { replacer->RemoveFrame(f); }
+		void DropFrame(int f) { replacer->DropFrame(f); }
+		void GetStats(ReplacerStats& stats) const { replacer->GetStats(stats); }
+
+	private:
+
+		Replacer* replacer;
+
+		DynamicPolicy(const DynamicPolicy&);
+		DynamicPolicy& operator=(const DynamicPolicy&);
+};
+
+// The buffer manager proper, specialized at compile time on its
+// replacement policy and page size.
+//
+// Policy is any class with the Replacer methods (PickVictim, AddFrame,
+// RemoveFrame, DropFrame, and GetStats if the pool's GetStats is used); it need not
+// derive from Replacer.  PageSize is a multiple
+// of MINIBASE_PAGESIZE: a bigger page is a run of consecutive DB pages,
+// read and written together and named by its first DB page (see
+// BasicFrame).  Pages of such a pool must be allocated by its NewPage.
+//
+// BufMgr wraps a BufPool<DynamicPolicy> to keep its run-time choice of
+// policy.  A pool with a fixed policy, e.g. BufPool<LRU, 16384>, can be
+// used on its own for pages that BufMgr does not manage.  Victim caches
+// hold MINIBASE_PAGESIZE pages, so only pools of that page size use one.
+// The pool drops a cached copy whenever it writes or frees the page; pages
+// written or freed through the DB directly are not seen.
+template <class Policy, int PageSize = MINIBASE_PAGESIZE>
+class BufPool
+{
+	public:
+
+		typedef BasicFrame<PageSize> FrameType;
+
+		enum { PAGE_SIZE = PageSize, BLOCKS_PER_PAGE = PageSize / MINIBASE_PAGESIZE };
+
+		BufPool( int numOfFrames );
+		~BufPool();
+		Status PinPage( PageID pid, Page*& page, bool isEmpty=false, int* frameIndex=NULL );
+		Status UnpinPage( PageID pid, bool dirty=false );
+
+		// UnpinPage for a page PinPage put in frameIndex, without looking
+		// for it.  If Resize has moved the page since, it is looked for.
+		Status UnpinFrame( int frameIndex, PageID pid, bool dirty=false );
+
+		// The latch of the frame PinPage put a page in.  It stays valid
+		// while the page is pinned, even if Resize moves the frame.
+		Latch& GetLatch( int frameIndex ) { return frames[frameIndex]->GetLatch(); }
+
+		// PinPage and UnpinPage for n pages at once; a page may appear
+		// more than once and is then pinned or unpinned that many times.
+		// The page table lookups of the batch overlap (see FindFrames).
+		// Either every page is pinned or unpinned, or, on FAIL, none is.
+		Status PinPages( const PageID* pids, int n, Page** pages );
+		Status UnpinPages( const PageID* pids, int n, bool dirty=false );
+		Status NewPage( PageID& firstPid, Page*& firstPage,int howMany=1 );
+		Status FreePage( PageID pid );
+		Status FlushPage( PageID pid );
+		Status FlushAllPages();
+
+		// The pool's half of FreePage: write the page out, empty its frame
+		// and drop any victim-cache copy, but leave it allocated in the DB.
+		Status RemovePage( PageID pid );
+
+		unsigned int GetNumOfUnpinnedFrames();
+		int GetNumFrames() const { return numFrames; }
+
+		Status Resize( int newFrames );
+
+		Policy& GetPolicy() { return replacer; }
+
+		// Offer every unpinned page to the policy again, e.g. after
+		// replacing a DynamicPolicy's replacer.  The new policy starts
+		// with no history, in frame order.
+		void RebuildPolicy();
+
+		void SetVictimCache(VictimCache* cache);
+
+		// Latency histograms of pins, evictions and I/O, on by default.
+		void SetLatencyTracking(bool on) { timing = on; }
+		LatencyStats& GetLatencyStats() { return latency; }
+
+		// The miss-ratio curve of the pages pinned, on by default.
+		void SetMissRatioTracking(bool on) { curveTracking = on; }
+		const MissRatioCurve& GetMissRatioCurve() const { return curve; }
+
+		// Fill in everything but stats.policy.  The counters may be read
+		// from any thread; the rest must be read by the pool's owner.
+		void GetStats(BufStats& stats);
+
+		void ResetStat();
+		void PrintStat();
+
+	private:
+
+		int numFrames;
+
+		// Frames are allocated one by one so that Resize can add and
+		// remove them without moving the pages of the others.
+		std::vector<FrameType*> frames;
+		PageTable table;          // the frame of every page in the pool
+		Policy replacer;
+		VictimCache* victimCache; // second tier for evicted pages, or NULL
+
+		int FindFrame( PageID pid ) { return table.Find(pid); }
+
+		// Enter every page in table again, after frames have moved.
+		void RebuildTable();
+
+		// Write a dirty frame's page back to the DB, counted and timed.
+		// If mayWait is false and the frame is latched exclusive, nothing
+		// is written and FAIL is returned.
+		Status WriteFrame( FrameType* frame, bool mayWait = true );
+
+		// How many lookups ahead FindFrames prefetches.
+		enum { PREFETCH_AHEAD = 8 };
+
+		// FindFrame for every page of a batch: frameOf[i] is the frame
+		// holding pids[i], or INVALID_FRAME.
+		void FindFrames( const PageID* pids, int n, std::vector<int>& frameOf );
+		StatCounter totalCall;		//total number of pin requests
+		StatCounter totalHit;		//total number of pin requests that result in a hit
+		StatCounter numDirtyPageWrites; //total number of dirty pages written back to disk
+		StatCounter numCleanEvictions;	//evictions that needed no write
+		StatCounter numDirtyEvictions;	//evictions that wrote the page back
+		StatCounter numDiskReads;		//pages read from disk
+
+		// Reading the clock twice costs about as much as a pin hit, so
+		// only one hit in HIT_SAMPLE is timed (and recorded with that
+		// weight).  Everything slower is timed every time.
+		enum { HIT_SAMPLE = 16 };
+
+		bool timing;
+		LatencyStats latency;
+
+		bool curveTracking;
+		MissRatioCurve curve;
+
+		LatencyStats* Timer() { return timing ? &latency : NULL; }
+		unsigned long long StartTimer() { return timing ? LatencyStats::Now() : 0; }
+
+		BufPool(const BufPool&);
+		BufPool& operator=(const BufPool&);
+};
+
+
+//--------------------------------------------------------------------
+// Constructor for BufPool
+//
+// Input   : bufSize  - number of frames(pages) in the this buffer pool
+// Output  : None
+// PostCond: All frames are empty.
+//--------------------------------------------------------------------
+template <class Policy, int PageSize>
+BufPool<Policy, PageSize>::BufPool(int bufSize)
+{
+	numFrames = bufSize;
+	for (int iter = 0; iter < numFrames; iter++)
+		frames.push_back(new FrameType);
+	table.Reset(numFrames);
+
+	victimCache = NULL;
+	timing = true;
+	curveTracking = true;
+}
+
+//--------------------------------------------------------------------
+// Destructor for BufPool
+//
+// Input   : None
+// Output  : None
+//--------------------------------------------------------------------
+template <class Policy, int PageSize>
+BufPool<Policy, PageSize>::~BufPool()
+{
+	FlushAllPages();
+	for (int iter = 0; iter < numFrames; iter++)
+		delete frames[iter];
+	delete victimCache;
+}
+
+//--------------------------------------------------------------------
+// BufPool::PinPage
+//
+// Input    : pid     - page id of a particular page
+//            isEmpty - (optional, default to false) if true indicate
+//                      that the page to be pinned is an empty page.
+// Output   : page - a pointer to a page in the buffer pool. (NULL
+//            if fail)
+//            frameIndex - (optional) the frame now holding the page,
+//            for UnpinFrame.
+// Purpose  : Pin the page with page id = pid to the buffer.
+//            Read the page from disk unless isEmpty is true or unless
+//            the page is already in the buffer.  If there is a victim
+//            cache, a page found there is not read from disk.
+// Condition: Either the page is already in the buffer, or there is at
+//            least one frame available in the buffer pool for the
+//            page.
+// PostCond : The page with page id = pid resides in the buffer and
+//            is pinned. The number of pin on the page increase by
+//            one.
+// Return   : OK if operation is successful.  FAIL otherwise.
+//--------------------------------------------------------------------
+template <class Policy, int PageSize>
+Status BufPool<Policy, PageSize>::PinPage(PageID pid, Page*& page, bool isEmpty, int* frameIndex)
+{
+	if(pid == INVALID_PAGE) return FAIL;
+
+	bool sampleHit = timing && totalCall % HIT_SAMPLE == 0;
+	unsigned long long start = sampleHit ? LatencyStats::Now() : 0;
+	totalCall++;
+	if (curveTracking) curve.Access(pid);
+
+	// Check if the page is in the buffer pool
+	FrameType* currFrame = NULL;
+	int frameNo = table.Find(pid);
+	bool inPool = (frameNo != INVALID_FRAME);
+	if (inPool) {
+		currFrame = frames[frameNo];
+		totalHit++;
+	}
+
+	if (inPool){
+		// Increase its pin count and set output page pointer
+		currFrame->Pin();
+		page = currFrame->GetPage();
+	}
+	else {
+		// Misses are timed from here, sampled or not.
+		start = StartTimer();
+
+		// Find the first free frame if there is one; the table holds a
+		// page for every frame that is not.
+		bool foundEmptyFrame = false;
+		for (frameNo = 0; frameNo < numFrames && table.Size() < numFrames; frameNo++) {
+			currFrame = frames[frameNo];
+			if (!currFrame->IsValid()){
+				foundEmptyFrame = true;
+				break;
+			}
+		}
+
+		if (!foundEmptyFrame) {
+			unsigned long long evictStart = StartTimer();
+
+			// Find a page to evict based on our replacement policy
+			int replacedPageID = replacer.PickVictim();
+
+			// Get a pointer to the frame we will flush
+			frameNo = table.Find(replacedPageID);
+			if (frameNo == INVALID_FRAME) {
+				page = NULL;
+				return FAIL;
+			}
+			currFrame = frames[frameNo];
+
+			bool wasDirty = currFrame->IsDirty();
+			if(FlushPage(replacedPageID) != OK) {
+				page = NULL;
+				return FAIL;
+			}
+			if (wasDirty) numDirtyEvictions++;
+			else numCleanEvictions++;
+
+			// The frame still holds the page, now the same as on disk.
+			if (victimCache && !victimCache->Contains(replacedPageID))
+				victimCache->Put(replacedPageID, currFrame->GetPage());
+
+			if (timing) latency.Record(LAT_EVICTION, evictStart);
+		}
+
+		currFrame->SetPageID(pid);
+		currFrame->Pin();
+		table.Insert(pid, frameNo);
+
+		// If the page is not empty, copy it from the victim cache or read
+		// it in from disk.  A failed read (including a bad checksum) leaves
+		// the frame empty again.  An empty page is about to be overwritten,
+		// so any cached copy is stale.
+		if (isEmpty) {
+			if (victimCache) victimCache->Invalidate(pid, BLOCKS_PER_PAGE);
+		}
+		else if (!(victimCache && victimCache->Lookup(pid, currFrame->GetPage()))) {
+			numDiskReads++;
+			if (currFrame->Read(pid, Timer()) != OK) {
+				table.Erase(pid);
+				currFrame->EmptyIt();
+				page = NULL;
+				return FAIL;
+			}
+		}
+
+
+		page = currFrame->GetPage();
+	}
+
+	if (frameIndex) *frameIndex = frameNo;
+
+	// Now that the frame is pinned we need to remove it from the ones that can be evicted
+	replacer.RemoveFrame(currFrame->GetPageID());
+	if (inPool) {
+		if (sampleHit) latency.Record(LAT_PIN_HIT, start, HIT_SAMPLE);
+	}
+	else if (timing) latency.Record(LAT_PIN_MISS, start);
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// BufPool::UnpinPage
+//
+// Input    : pid     - page id of a particular page
+//            dirty   - indicate whether the page with page id = pid
+//                      is dirty or not. (Optional, default to false)
+// Output   : None
+// Purpose  : Unpin the page with page id = pid in the buffer. Mark
+//            the page dirty if dirty is true.
+// Condition: The page is already in the buffer and is pinned.
+// PostCond : The page is unpinned and the number of pin on the
+//            page decrease by one.
+// Return   : OK if operation is successful.  FAIL otherwise.
+//--------------------------------------------------------------------
+template <class Policy, int PageSize>
+Status BufPool<Policy, PageSize>::UnpinPage(PageID pid, bool dirty)
+{
+	return UnpinFrame(FindFrame(pid), pid, dirty);
+}
+
+template <class Policy, int PageSize>
+Status BufPool<Policy, PageSize>::UnpinFrame(int frameIndex, PageID pid, bool dirty)
+{
+	if (frameIndex != INVALID_FRAME
+		&& (frameIndex >= numFrames || frames[frameIndex]->GetPageID() != pid))
+		frameIndex = FindFrame(pid);
+	if (frameIndex == INVALID_FRAME) return FAIL;
+
+	FrameType* targetFrame = frames[frameIndex];
+	if (targetFrame->NotPinned()) return FAIL;
+
+	if (dirty) targetFrame->DirtyIt();
+
+	targetFrame->Unpin();
+
+	if (targetFrame->NotPinned()) replacer.AddFrame(targetFrame->GetPageID());
+
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// BufPool::PinPages
+//
+// Input    : pids  - n page ids
+// Output   : pages - pages[i] is pids[i] in the pool (all NULL if fail)
+// Purpose  : Pin a batch of pages.  Every page is looked up first (see
+//            FindFrames), and the ones already in the pool are pinned
+//            first, so that the misses cannot evict them.  The misses
+//            are then read in page order, which makes adjacent pages one
+//            sequential run for the DB.  The hits, lookups included, are
+//            timed together and recorded as that many of their average.
+//            The batch goes into the miss ratio curve only once it is
+//            all pinned.
+// Condition: There are frames to spare for the misses.
+// Return   : OK if every page is pinned.  FAIL otherwise, with the pins
+//            already taken undone, and the pin and hit counts with them;
+//            the pages read and evicted on the way stay counted.
+//--------------------------------------------------------------------
+template <class Policy, int PageSize>
+Status BufPool<Policy, PageSize>::PinPages(const PageID* pids, int n, Page** pages)
+{
+	if (n < 0) return FAIL;
+
+	long long callsBefore = totalCall;
+	long long hitsBefore = totalHit;
+	bool tracking = curveTracking;
+	curveTracking = false;
+	unsigned long long start = StartTimer();
+	std::vector<int> frameOf;
+	FindFrames(pids, n, frameOf);
+
+	std::vector<std::pair<PageID, int> > misses;
+	unsigned hits = 0;
+	for (int i = 0; i < n; i++) {
+		pages[i] = NULL;
+		if (frameOf[i] == INVALID_FRAME) {
+			misses.push_back(std::make_pair(pids[i], i));
+			continue;
+		}
+
+		FrameType* currFrame = frames[frameOf[i]];
+		totalCall++;
+		totalHit++;
+		hits++;
+		currFrame->Pin();
+		replacer.RemoveFrame(pids[i]);
+		pages[i] = currFrame->GetPage();
+	}
+	unsigned long long hitTime = (timing && hits > 0) ? LatencyStats::Now() - start : 0;
+
+	std::sort(misses.begin(), misses.end());
+	for (size_t k = 0; k < misses.size(); k++) {
+		int i = misses[k].second;
+		if (PinPage(pids[i], pages[i]) != OK) {
+			for (int j = 0; j < n; j++) {
+				if (pages[j]) UnpinPage(pids[j]);
+				pages[j] = NULL;
+			}
+			totalCall.Add(callsBefore - totalCall);
+			totalHit.Add(hitsBefore - totalHit);
+			curveTracking = tracking;
+			return FAIL;
+		}
+	}
+
+	curveTracking = tracking;
+	if (curveTracking)
+		for (int i = 0; i < n; i++) curve.Access(pids[i]);
+	if (timing && hits > 0)
+		latency.Record(LAT_PIN_HIT, LatencyStats::Now() - hitTime / hits, hits);
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// BufPool::UnpinPages
+//
+// Input    : pids  - n page ids
+//            dirty - mark every page dirty
+// Purpose  : Unpin a batch of pages, looked up as PinPages does.
+// Return   : OK if every page was unpinned.  FAIL, with nothing unpinned,
+//            if a page is not in the pool or is pinned fewer times than
+//            it appears.
+//--------------------------------------------------------------------
+template <class Policy, int PageSize>
+Status BufPool<Policy, PageSize>::UnpinPages(const PageID* pids, int n, bool dirty)
+{
+	if (n < 0) return FAIL;
+
+	std::vector<int> frameOf;
+	FindFrames(pids, n, frameOf);
+
+	std::vector<int> byFrame(frameOf);
+	std::sort(byFrame.begin(), byFrame.end());
+	int times;
+	for (int k = 0; k < n; k += times) {
+		int frameNo = byFrame[k];
+		if (frameNo == INVALID_FRAME) return FAIL;
+		for (times = 1; k + times < n && byFrame[k + times] == frameNo; times++) {}
+		if (frames[frameNo]->GetPinCount() < times) return FAIL;
+	}
+
+	for (int i = 0; i < n; i++)
+		UnpinFrame(frameOf[i], pids[i], dirty);
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// BufPool::NewPage
+//
+// Input    : howMany - (optional, default to 1) how many pages to
+//                      allocate.
+// Output   : firstPid  - the page id of the first page (as output by
+//                   DB::AllocatePage) allocated.
+//            firstPage - a pointer to the page in memory.
+// Purpose  : Allocate howMany number of pages, and pin the first page
+//            into the buffer.
+// Condition: howMany > 0 and there is at least one free buffer space
+//            to hold a page.
+// PostCond : The page with page id = pid is pinned into the buffer.
+// Return   : OK if operation is successful.  FAIL otherwise.
+// Note     : Each page is BLOCKS_PER_PAGE DB pages, so the pages are
+//            firstPid, firstPid + BLOCKS_PER_PAGE, and so on.
+//--------------------------------------------------------------------
+template <class Policy, int PageSize>
+Status BufPool<Policy, PageSize>::NewPage (PageID& firstPid, Page*& firstPage, int howMany)
+{
+	// Condition Checks
+	if (howMany <= 0) return FAIL;
+
+	bool foundEmptyFrame = false;
+	FrameType* currFrame;
+	for (int iter = 0; iter < numFrames; iter++) {
+		currFrame = frames[iter];
+		if (!currFrame->IsValid() || currFrame->NotPinned()){
+			foundEmptyFrame = true;
+			break;
+		}
+	}
+	if (!foundEmptyFrame) return FAIL;
+
+	// Allocate the pages
+
+	if (MINIBASE_DB->AllocatePage(firstPid, howMany * BLOCKS_PER_PAGE) != OK) {
+		firstPid = INVALID_PAGE;
+		firstPage = NULL;
+		return FAIL;
+	}
+
+	if (PinPage(firstPid,firstPage,true) != OK) {
+		MINIBASE_DB->DeallocatePage(firstPid, howMany * BLOCKS_PER_PAGE);
+		firstPid = INVALID_PAGE;
+		firstPage = NULL;
+		return FAIL;
+	}
+
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// BufPool::FreePage
+//
+// Input    : pid     - page id of a particular page
+// Output   : None
+// Purpose  : Free the memory allocated for the page with
+//            page id = pid
+// Condition: Either the page is already in the buffer and is pinned
+//            no more than once, or the page is not in the buffer.
+// PostCond : The page is unpinned, and the frame where it resides in
+//            the buffer pool is freed.  Also the page is deallocated
+//            from the database.
+// Return   : OK if operation is successful.  FAIL otherwise.
+//--------------------------------------------------------------------
+template <class Policy, int PageSize>
+Status BufPool<Policy, PageSize>::FreePage(PageID pid)
+{
+	if (RemovePage(pid) != OK) return FAIL;
+
+	return MINIBASE_DB->DeallocatePage(pid, BLOCKS_PER_PAGE);
+}
+
+template <class Policy, int PageSize>
+Status BufPool<Policy, PageSize>::RemovePage(PageID pid)
+{
+	FrameType* targetFrame;
+	int frameIndex = FindFrame(pid);
+	if (frameIndex != INVALID_FRAME) {
+		targetFrame = frames[frameIndex];
+
+		if (targetFrame->GetPinCount() > 1) return FAIL;
+
+		UnpinPage(pid, true);
+		FlushPage(pid);
+	}
+	if (victimCache) victimCache->Invalidate(pid, BLOCKS_PER_PAGE);
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// BufPool::FlushPage
+//
+// Input    : pid  - page id of a particular page
+// Output   : None
+// Purpose  : Flush the page with the given pid to disk.
+// Condition: The page with page id = pid must be in the buffer,
+//            and is not pinned. pid cannot be INVALID_PAGE.
+// PostCond : The page with page id = pid is written to disk if it's dirty.
+//            The frame where the page resides is empty.
+// Return   : OK if operation is successful.  FAIL otherwise.
+//--------------------------------------------------------------------
+template <class Policy, int PageSize>
+Status BufPool<Policy, PageSize>::FlushPage(PageID pid)
+{
+	int frameIndex = FindFrame(pid);
+	if (frameIndex == INVALID_FRAME) return FAIL;
+
+	FrameType* targetFrame = frames[frameIndex];
+	if(!targetFrame->IsValid() || !targetFrame->NotPinned()) return FAIL;
+
+	if (targetFrame->IsDirty() && WriteFrame(targetFrame) != OK) return FAIL;
+
+	replacer.DropFrame(targetFrame->GetPageID());
+	table.Erase(targetFrame->GetPageID());
+	targetFrame->EmptyIt();
+	return OK;
+}
+
+// Whatever the write leaves on disk, a copy the victim cache holds is out
+// of date, so it is dropped first.  The page is only read, so its latch is
+// taken shared.  An unpinned frame is never latched, since a PageGuard
+// lets go of the latch before the pin, so only a pinned one can make this
+// wait; FlushAllPages writes those without waiting, as the writer holding
+// the latch may be the thread that called it.
+template <class Policy, int PageSize>
+Status BufPool<Policy, PageSize>::WriteFrame(FrameType* frame, bool mayWait)
+{
+	unsigned long long start = StartTimer();
+	Latch& latch = frame->GetLatch();
+	if (mayWait) latch.LockShared();
+	else if (!latch.TryLockShared()) return FAIL;
+
+	if (victimCache) victimCache->Invalidate(frame->GetPageID(), BLOCKS_PER_PAGE);
+	Status status = frame->Write(Timer());
+	latch.UnlockShared();
+
+	if (status != OK) return FAIL;
+	numDirtyPageWrites++;
+	if (timing) latency.Record(LAT_DIRTY_WRITE, start);
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// BufPool::FlushAllPages
+//
+// Input    : None
+// Output   : None
+// Purpose  : Flush all pages in this buffer pool to disk.
+// Condition: All pages in the buffer pool must not be pinned.
+// PostCond : All dirty pages in the buffer pool are written to disk
+//            (even if some pages are pinned), unless a guard holds the
+//            page for writing.  The frames of unpinned pages are empty.
+//            A pinned page keeps its frame, and stays dirty, since its
+//            holder may change it again; so does a page that fails to
+//            be written.
+// Return   : OK if every frame is now empty.  FAIL otherwise.
+//--------------------------------------------------------------------
+template <class Policy, int PageSize>
+Status BufPool<Policy, PageSize>::FlushAllPages()
+{
+	bool failedOnce = false;
+	FrameType* currFrame;
+	for (int iter = 0; iter < numFrames; iter++) {
+		currFrame = frames[iter];
+		if (currFrame->IsValid()) {
+			// A pinned page is written, but its frame is not emptied
+			if (!currFrame->NotPinned()){
+				if (currFrame->IsDirty()) WriteFrame(currFrame, false);
+				failedOnce = true;
+				continue;
+			}
+
+			if (currFrame->IsDirty() && WriteFrame(currFrame) != OK) {
+				failedOnce = true;
+				continue;
+			}
+
+			replacer.DropFrame(currFrame->GetPageID());
+			table.Erase(currFrame->GetPageID());
+			currFrame->EmptyIt();
+		}
+	}
+	return (failedOnce) ? FAIL : OK;
+}
+
+//--------------------------------------------------------------------
+// BufPool::GetNumOfUnpinnedFrames
+//
+// Input    : None
+// Output   : None
+// Purpose  : Find out how many unpinned locations are in the buffer
+//            pool.
+// Condition: None
+// PostCond : None
+// Return   : The number of unpinned buffers in the buffer pool.
+//--------------------------------------------------------------------
+template <class Policy, int PageSize>
+unsigned int BufPool<Policy, PageSize>::GetNumOfUnpinnedFrames()
+{
+	int count = 0;
+	FrameType* currFrame;
+	for (int iter = 0; iter < numFrames; iter++) {
+		currFrame = frames[iter];
+		if (currFrame->NotPinned()) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+//--------------------------------------------------------------------
+// BufPool::Resize
+//
+// Input    : newFrames - the number of frames wanted, at least 1
+// Purpose  : Grow or shrink the pool while it is in use.
+// Condition: To shrink, at most newFrames pages may be pinned.
+// PostCond : Growing adds empty frames.  Shrinking removes empty frames
+//            first, then unpinned clean pages, then unpinned dirty ones
+//            after writing them back; a removed page goes to the victim
+//            cache like any evicted page.  Pinned pages keep their
+//            frames, so pointers to them stay valid.
+// Return   : OK if the pool now has newFrames frames.  FAIL if
+//            newFrames is too small or a write-back fails; in the
+//            latter case the frames removed so far stay removed.
+//--------------------------------------------------------------------
+template <class Policy, int PageSize>
+Status BufPool<Policy, PageSize>::Resize(int newFrames)
+{
+	if (newFrames <= 0 || (int)(numFrames - GetNumOfUnpinnedFrames()) > newFrames)
+		return FAIL;
+
+	for ( ; numFrames < newFrames; numFrames++)
+		frames.push_back(new FrameType);
+	RebuildTable();
+
+	// Three passes: empty frames, then clean pages, then dirty ones.  A
+	// pass moves the frames after the ones it removes, so the table is
+	// rebuilt after each; within a pass only frames before the removed
+	// ones are looked up, and they have not moved.
+	for (int pass = 0; pass < 3 && numFrames > newFrames; pass++) {
+		for (int iter = numFrames - 1; iter >= 0 && numFrames > newFrames; iter--) {
+			FrameType* currFrame = frames[iter];
+			if (!currFrame->NotPinned()) continue;
+			if (pass == 0 && currFrame->IsValid()) continue;
+			if (pass == 1 && currFrame->IsDirty()) continue;
+
+			if (currFrame->IsValid()) {
+				PageID pid = currFrame->GetPageID();
+				bool wasDirty = currFrame->IsDirty();
+				if (FlushPage(pid) != OK) {
+					RebuildTable();
+					return FAIL;
+				}
+				if (wasDirty) numDirtyEvictions++;
+				else numCleanEvictions++;
+				if (victimCache && !victimCache->Contains(pid))
+					victimCache->Put(pid, currFrame->GetPage());
+			}
+
+			delete currFrame;
+			frames.erase(frames.begin() + iter);
+			numFrames--;
+		}
+		RebuildTable();
+	}
+
+	return OK;
+}
+
+template <class Policy, int PageSize>
+void BufPool<Policy, PageSize>::RebuildTable()
+{
+	table.Reset(numFrames);
+	for (int iter = 0; iter < numFrames; iter++)
+		if (frames[iter]->IsValid())
+			table.Insert(frames[iter]->GetPageID(), iter);
+}
+
+template <class Policy, int PageSize>
+void BufPool<Policy, PageSize>::RebuildPolicy()
+{
+	for (int iter = 0; iter < numFrames; iter++) {
+		FrameType* currFrame = frames[iter];
+		if (currFrame->IsValid() && currFrame->NotPinned())
+			replacer.AddFrame(currFrame->GetPageID());
+	}
+}
+
+// A pool of pages bigger than a victim cache's pages deletes the cache.
+template <class Policy, int PageSize>
+void BufPool<Policy, PageSize>::SetVictimCache(VictimCache* cache) {
+	if (PageSize != MINIBASE_PAGESIZE) {
+		delete cache;
+		cache = NULL;
+	}
+	if (cache != victimCache) delete victimCache;
+	victimCache = cache;
+}
+
+//--------------------------------------------------------------------
+// BufPool::FindFrames
+//
+// Input    : pids - n page ids
+// Output   : frameOf - the frame holding each page, or INVALID_FRAME
+// Purpose  : Look up every page of a batch in the page table.  A lookup
+//            mostly waits for its slot to come in from memory, so while
+//            one probes, the slot of the page PREFETCH_AHEAD places on is
+//            prefetched, and a frame that is found is prefetched for the
+//            pin that follows; the batch's cache misses overlap instead
+//            of coming one after another.
+//--------------------------------------------------------------------
+template <class Policy, int PageSize>
+void BufPool<Policy, PageSize>::FindFrames(const PageID* pids, int n, std::vector<int>& frameOf)
+{
+	frameOf.resize(n);
+	for (int i = 0; i < n && i < PREFETCH_AHEAD; i++)
+		table.Prefetch(pids[i]);
+
+	for (int i = 0; i < n; i++) {
+		if (i + PREFETCH_AHEAD < n) table.Prefetch(pids[i + PREFETCH_AHEAD]);
+		frameOf[i] = table.Find(pids[i]);
+		if (frameOf[i] != INVALID_FRAME) BUF_PREFETCH(frames[frameOf[i]]);
+	}
+}
+
+template <class Policy, int PageSize>
+void BufPool<Policy, PageSize>::ResetStat() {
+	totalHit.Reset();
+	totalCall.Reset();
+	numDirtyPageWrites.Reset();
+	numCleanEvictions.Reset();
+	numDirtyEvictions.Reset();
+	numDiskReads.Reset();
+	if (victimCache) victimCache->ResetStat();
+	latency.Reset();
+	curve.Reset();
+}
+
+template <class Policy, int PageSize>
+void BufPool<Policy, PageSize>::GetStats(BufStats& stats) {
+	stats.numFrames = numFrames;
+	stats.pinnedFrames = stats.dirtyFrames = stats.freeFrames = 0;
+	for (int iter = 0; iter < numFrames; iter++) {
+		FrameType* currFrame = frames[iter];
+		if (!currFrame->IsValid()) stats.freeFrames++;
+		if (!currFrame->NotPinned()) stats.pinnedFrames++;
+		if (currFrame->IsDirty()) stats.dirtyFrames++;
+	}
+
+	stats.pinRequests = totalCall;
+	stats.hits = totalHit;
+	stats.misses = stats.pinRequests - stats.hits;
+	stats.cleanEvictions = numCleanEvictions;
+	stats.dirtyEvictions = numDirtyEvictions;
+	stats.diskReads = numDiskReads;
+	stats.diskWrites = numDirtyPageWrites;
+
+	stats.victimLookups = victimCache ? victimCache->GetNumLookups() : 0;
+	stats.victimHits = victimCache ? victimCache->GetNumHits() : 0;
+
+	stats.policyStats.clear();
+	replacer.GetStats(stats.policyStats);
+
+	for (int op = 0; op < NUM_LATENCY_OPS; op++)
+		stats.latency[op] = latency.GetSummary((LatencyOp)op);
+
+	stats.predictedHitRatios.clear();
+	if (curveTracking)
+		for (int frames = numFrames > 1 ? numFrames / 2 : 1; frames <= numFrames * 4; frames *= 2)
+			stats.predictedHitRatios.push_back(std::make_pair(frames, curve.PredictHitRatio(frames)));
+}
+
+template <class Policy, int PageSize>
+void BufPool<Policy, PageSize>::PrintStat() {
+	cout<<"**Buffer Manager Statistics**"<<endl;
+	cout<<"Number of Dirty Pages Written to Disk: "<<numDirtyPageWrites<<endl;
+	cout<<"Number of Pin Page Requests: "<<totalCall<<endl;
+	cout<<"Number of Pin Page Request Misses "<<totalCall-totalHit<<endl;
+	if (timing) latency.Print(cout);
+	if (curveTracking) {
+		cout<<"Predicted LRU Hit Ratio:";
+		for (int frames = numFrames > 1 ? numFrames / 2 : 1; frames <= numFrames * 4; frames *= 2)
+			cout<<" "<<frames<<" frames "<<(int)(curve.PredictHitRatio(frames) * 100 + 0.5)<<"%";
+		cout<<endl;
+	}
+	if (victimCache) victimCache->PrintStat();
+}
+
+#endif // _BUF_POOL_H
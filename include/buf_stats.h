@@ -0,0 +1,109 @@
+#ifndef _BUF_STATS_H
+#define _BUF_STATS_H
+
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "minirel.h"
+#include "latency_stats.h"
+#include "replacer.h"
+
+// A count written by one thread at a time and readable from any thread
+// while it changes.  The increment is a relaxed load and store, which
+// costs no more than incrementing a plain long.
+class StatCounter
+{
+	public:
+
+		StatCounter() : value(0) {}
+
+		void operator++(int) { Add(1); }
+		void Add(long long n) { value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+		void Reset() { value.store(0, std::memory_order_relaxed); }
+		operator long long() const { return value.load(std::memory_order_relaxed); }
+
+	private:
+
+		std::atomic<long long> value;
+
+		StatCounter(const StatCounter&);
+		StatCounter& operator=(const StatCounter&);
+};
+
+// A snapshot of a database's I/O, from DB::GetIOStats, counted from the
+// last DB::ResetStat.  A read (or write) is sequential if it is of the page
+// after the one the previous read (or write) was of.  A run is a page read
+// at random and the sequential reads that follow it, so random I/O makes
+// runs of 1 and a scan one long run.  Bytes are what the storage moved,
+// fewer than the pages hold in a compressed database.
+struct DBIOStats
+{
+	enum { RUN_BUCKETS = 32 };
+
+	struct Counts {
+		long long calls;
+		long long bytes;
+		long long sequential;
+		long long runs[RUN_BUCKETS];	// runs of [2^b, 2^(b+1)) pages
+		LatencySummary latency;
+	};
+	Counts reads, writes;
+
+	DBIOStats();
+};
+
+enum StatsFormat {
+	STATS_JSON,
+	STATS_PROMETHEUS
+};
+
+// A snapshot of the buffer manager's statistics, from BufMgr::GetStats.
+// The counters run from the last ResetStat; the frame counts describe the
+// pool at the time of the snapshot.
+struct BufStats
+{
+	// Frames.  A frame is free if it holds no page; pinned and dirty
+	// frames may overlap.
+	int numFrames;
+	int pinnedFrames;
+	int dirtyFrames;
+	int freeFrames;
+
+	long long pinRequests;
+	long long hits;
+	long long misses;
+	long long cleanEvictions;	// evicted pages that were not written back
+	long long dirtyEvictions;	// evicted pages that were
+	long long diskReads;		// pages read from the DB
+	long long diskWrites;		// pages written to the DB
+
+	long long victimLookups;	// 0 if there is no victim cache
+	long long victimHits;
+
+	std::string policy;			// the replacement policy spec
+	ReplacerStats policyStats;	// the replacer's own figures
+
+	typedef LatencySummary Latency;
+	Latency latency[NUM_LATENCY_OPS];	// all zero if tracking is off
+
+	DBIOStats db;				// MINIBASE_DB's I/O
+
+	// (frames, hit ratio) an LRU pool of that many frames would have had,
+	// from the miss-ratio curve; empty if it is not tracked.
+	std::vector< std::pair<int, double> > predictedHitRatios;
+
+	BufStats();
+
+	void WriteJson(std::ostream& out) const;
+	void WritePrometheus(std::ostream& out) const;
+	void Write(std::ostream& out, StatsFormat format) const;
+
+	// Write the snapshot to path.  It is written under a temporary name
+	// and renamed into place, so a reader never sees a partial file.
+	Status Save(const char* path, StatsFormat format) const;
+};
+
+#endif // _BUF_STATS_H
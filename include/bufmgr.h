@@ -2,41 +2,149 @@
 #ifndef _BUF_H
 #define _BUF_H
 
+#include <mutex>
+#include <string>
+
 #include "db.h"
 #include "page.h"
 
 
-#include "frame.h"
+#include "buf_pool.h"
+#include "buf_stats.h"
+#include "page_guard.h"
 #include "replacer.h"
+#include "stats_server.h"
+#include "trace_recorder.h"
+#include "victim_cache.h"
 
 
+// The buffer manager used by the rest of Minibase.  The work is done by a
+// BufPool<DynamicPolicy>; the replacement policy is named by a spec that
+// ReplacerRegistry understands, such as "LRU" or "lru-k:k=3", and can be
+// changed while the pool is in use.
+//
+// Threads may share a BufMgr: every call holds poolLock while it works on
+// the pool, so calls are serialized, misses and write-backs included.  A
+// page pinned into a PageGuard is also latched, shared or exclusive by
+// the pin's intent, and the latch is taken after poolLock is let go.  A
+// page pinned by pointer is not latched; threads that pin it that way
+// must not write it at the same time.  A write-back holds the frame's
+// latch shared, so it never sends out a page a guard is changing:
+// eviction and FlushPage only write unpinned pages, which are never
+// latched, and FlushAllPages passes over a pinned page latched exclusive.
+// It does write other pinned pages, including ones pinned by pointer that
+// may be half changed; they stay dirty, to be written again.  The DB's space
+// lock, when both are held, is taken first: NewPage and FreePage allocate
+// and deallocate pages without poolLock, since the DB pins its space map
+// while holding its own lock.
 class BufMgr 
 {
 	private:
-		int numFrames;
+		BufPool<DynamicPolicy> pool;
+		std::string policySpec;
+
+		// Recursive so that one call may make another, as PublishStats
+		// calls GetStats.
+		std::recursive_mutex poolLock;
+
+		StatsServer* statsServer;	// NULL unless ServeStats was called
+		int statsRefreshMs;
+		long long lastPublishMs;
+		unsigned publishTick;
 
-		Frame* frames;
-		Replacer* replacer; // a pointer to the abstract base class of replacement policy,
-		                    // can be either set to a pointer to an LRU or MRU object. 
+		void PublishStats();
+		void PublishStatsIfDue();
 
-		int FindFrame( PageID pid );
-		long totalCall;		//total number of pin requests 
-		long totalHit;		//total number of pin requests that result in a hit
-		long numDirtyPageWrites; //total number of dirty pages written back to disk
+		TraceRecorder* trace;		// NULL unless tracing
+
+		// PageGuard's unpin, straight to the frame it pinned.
+		friend class PageGuard;
+		Status UnpinFrame(int frameIndex, PageID pid, bool dirty);
 
 	public:
 
-		BufMgr( int numOfFrames, const char* replacementPolicy);
+		// An unknown policy or bad parameter sets status to an error and
+		// leaves the pool with LRU; a caller that goes on anyway must mean
+		// to.
+		BufMgr( int numOfFrames, const char* replacementPolicy, Status& status);
 		~BufMgr();      
 		Status PinPage( PageID pid, Page*& page, bool isEmpty=false );
 		Status UnpinPage( PageID pid, bool dirty=false );
+
+		// Pin and latch the page into pin, releasing whatever pin held;
+		// the page is unpinned when pin lets go of it (see PageGuard).
+		// Waits while another guard holds the page in a conflicting mode.
+		Status PinPage( PageID pid, PageGuard& pin, PinIntent intent=PIN_READ, bool isEmpty=false );
+
+		// Pin or unpin n pages under one hold of poolLock, for callers
+		// that work on many pages at a time (see BufPool::PinPages).  The
+		// pages are not latched.
+		Status PinPages( const PageID* pids, int n, Page** pages );
+		Status UnpinPages( const PageID* pids, int n, bool dirty=false );
+
 		Status NewPage( PageID& firstPid, Page*& firstPage,int howMany=1 ); 
 		Status FreePage( PageID pid ); 
 		Status FlushPage( PageID pid );
 		Status FlushAllPages();
 
 		unsigned int GetNumOfUnpinnedFrames();
+		int GetNumFrames() const;
+
+		// Grow or shrink the pool to newFrames frames (see BufPool::Resize).
+		Status Resize(int newFrames);
+
+		// Switch to another replacement policy.  The unpinned pages are
+		// handed to the new replacer; history kept by the old one is lost.
+		// On error the current policy stays.
+		Status SetReplacementPolicy(const char* replacementPolicy);
+		const char* GetReplacementPolicy() const;
+
+		// Turn page checksums on or off (see Frame::SetChecksums).  Pick
+		// one setting before the database is created and keep it: pages
+		// written without a checksum fail verification later.
+		void SetPageChecksums(bool on);
+
+		// Put a cache tier (a CompressedCache or a FileCache) below the
+		// pool, or remove it with NULL.  The BufMgr takes ownership of the
+		// cache and deletes the one it replaces.
+		void SetVictimCache(VictimCache* cache);
+
+		// Per-operation latency histograms (see LatencyStats), printed by
+		// PrintStat.  Tracking is on by default.
+		void SetLatencyTracking(bool on);
+		double GetLatencyPercentile(LatencyOp op, double q);
+		LatencyStats& GetLatencyStats();
+
+		// The hit ratio an LRU pool of numFrames frames would have had on
+		// the pins since the last ResetStat, estimated from a sample of
+		// the pages (see MissRatioCurve).  PrintStat and GetStats show it
+		// for half, one, two and four times the pool.  Tracking is on by
+		// default.
+		void SetMissRatioTracking(bool on);
+		double PredictHitRatio(int numFrames);
+
+		// A snapshot of the counters, frame states, policy figures and
+		// latencies, and of MINIBASE_DB's I/O (see DB::GetIOStats).
+		BufStats GetStats();
+
+		// Write GetStats() to path as JSON or Prometheus text, e.g. for
+		// a node exporter's textfile collector.
+		Status ExportStats(const char* path, StatsFormat format);
+
+		// Serve the statistics over HTTP on 127.0.0.1:port (0 picks a
+		// port; see GetStatsPort) at /metrics and /stats.  The served
+		// snapshot is refreshed by PinPage at most every refreshMs, and
+		// by FlushAllPages and ResetStat.
+		Status ServeStats(int port, int refreshMs = 1000);
+		void StopServingStats();
+		int GetStatsPort() const;
+
+		// Record every PinPage, UnpinPage, NewPage, FreePage and flush
+		// call to a trace file (see TraceRecorder) until StopTrace.
+		Status StartTrace(const char* path);
+		Status StopTrace();
 
+		// ResetStat also resets MINIBASE_DB's statistics.
 		void ResetStat();
 		void PrintStat();
 
@@ -0,0 +1,96 @@
+#ifndef _CACHE_SIM_H
+#define _CACHE_SIM_H
+
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "replacer.h"
+#include "trace.h"
+
+// Replays trace events against a model of the buffer pool: which pages
+// are resident, pinned and dirty, with a real Replacer choosing victims.
+// No page data is kept and nothing is read or written, so a trace can be
+// replayed at any pool size without a DB.
+//
+// The model follows BufPool: a pinned page is not a candidate, a pin
+// with every frame pinned fails, FlushPage and FlushAllPages empty the
+// frames they write.  Events the trace marks as failed are skipped.
+// NewPage's pin needs no read, so it is not counted as a pin request.
+class CacheSim
+{
+	public:
+
+		// Takes ownership of replacer.
+		CacheSim(Replacer* replacer, int numFrames);
+		~CacheSim();
+
+		void Apply(const TraceEvent& event);
+
+		int GetNumFrames() const { return numFrames; }
+		Replacer* GetReplacer() { return replacer; }
+
+		long long GetNumPins() const { return numPins; }
+		long long GetNumHits() const { return numHits; }
+		long long GetNumMisses() const { return numPins - numHits - numFailedPins; }
+		long long GetNumEvictionWrites() const { return numEvictionWrites; }
+		long long GetNumFailedPins() const { return numFailedPins; }
+		double GetHitRatio() const { return numPins ? (double)numHits / numPins : 0; }
+
+	private:
+
+		struct PageState {
+			int pinCount;
+			bool dirty;
+		};
+
+		Replacer* replacer;
+		int numFrames;
+		std::unordered_map<int, PageState> pages;	// the resident pages
+
+		long long numPins;
+		long long numHits;
+		long long numEvictionWrites;
+		long long numFailedPins;
+
+		void Pin(int pid, bool counted);
+		void Drop(int pid);
+
+		CacheSim(const CacheSim&);
+		CacheSim& operator=(const CacheSim&);
+};
+
+// Belady's OPT: evicts the unpinned page whose next pin is furthest in the
+// future.  It cannot see the future itself; whoever replays the trace
+// calls SetNextUse before each pin with the position of that page's next
+// pin (see FindNextUses).  It minimizes misses, not eviction writes.
+class Belady : public Replacer
+{
+	public:
+
+		Belady();
+		virtual ~Belady();
+
+		virtual int PickVictim();
+		virtual void AddFrame(int f);
+		virtual void RemoveFrame(int f);
+
+		void SetNextUse(int pid, long long next);
+
+		// For every pin event (PIN or NEW, not failed) in events, the
+		// index of the next pin of the same page, or NO_NEXT_USE; other
+		// events get NO_NEXT_USE.
+		static void FindNextUses(const std::vector<TraceEvent>& events, std::vector<long long>& next);
+
+		static const long long NO_NEXT_USE;
+
+	private:
+
+		typedef std::set< std::pair<long long, int> > Order;
+
+		Order candidates;							// (next use, page)
+		std::unordered_map<int, long long> nextUse;
+};
+
+#endif // _CACHE_SIM_H
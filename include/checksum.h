@@ -0,0 +1,17 @@
+#ifndef _CHECKSUM_H
+#define _CHECKSUM_H
+
+#include <stddef.h>
+
+// CRC32C (Castagnoli polynomial) of len bytes.  Uses the SSE4.2 crc32
+// instruction when the CPU has it and a table-driven slicing-by-8 loop
+// otherwise; both give the same result.
+unsigned int Crc32c( const void* data, size_t len );
+
+// The software version, always available.  For benchmarks and tests.
+unsigned int Crc32cSoftware( const void* data, size_t len );
+
+// True if Crc32c runs on the SSE4.2 instruction.
+bool Crc32cHardware();
+
+#endif // _CHECKSUM_H
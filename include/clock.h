@@ -0,0 +1,51 @@
+#ifndef _CLOCK_H
+#define _CLOCK_H
+
+#include "db.h"
+#include "replacer.h"
+#include <list>
+#include <unordered_map>
+
+// CLOCK Buffer Replacement
+//
+// The unpinned pages sit on a ring with a reference bit each, set whenever
+// the page is unpinned.  With one hand, the hand sweeps the ring clearing
+// bits and evicts the first page whose bit is already clear.  With two
+// hands, a leading hand clears bits a fixed gap ahead of the trailing hand,
+// which evicts any page whose bit is still clear when it gets there; a page
+// survives only if it is used within the gap.
+class Clock : public Replacer {
+public:
+	// hands is 1 or 2.  gap is the distance between the two hands, in
+	// pages; 0 means half the ring when the hands are first placed.
+	Clock(int hands = 1, int gap = 0);
+	virtual ~Clock();
+
+	virtual int PickVictim();
+	virtual void AddFrame(int f);
+	virtual void RemoveFrame(int f);
+
+	// candidates, referenced (pages with their bit set), hand_steps
+	// (pages the evicting hand has passed over).
+	virtual void GetStats(ReplacerStats& stats) const;
+
+private:
+	struct Entry {
+		int  pid;
+		bool referenced;
+	};
+	typedef std::list<Entry> Ring;
+
+	int hands;
+	int gap;
+	Ring ring;
+	std::unordered_map<int, Ring::iterator> where;
+	Ring::iterator hand;		// the evicting hand
+	Ring::iterator lead;		// the clearing hand, if hands == 2
+	bool leadPlaced;
+	long handSteps;
+
+	void Advance(Ring::iterator& it);
+};
+
+#endif // CLOCK
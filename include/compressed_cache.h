@@ -0,0 +1,45 @@
+#ifndef _COMPRESSED_CACHE_H
+#define _COMPRESSED_CACHE_H
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "victim_cache.h"
+
+// Victim cache that keeps evicted pages compressed (page_codec) in memory,
+// within a fixed byte budget.  A pool miss that hits here costs one
+// decompression instead of a disk read.  When the budget is exceeded the
+// least recently used pages are dropped.  Pages that do not compress are
+// kept raw.
+class CompressedCache : public VictimCache {
+public:
+	CompressedCache(size_t budgetBytes);
+	virtual ~CompressedCache();
+
+	virtual bool Lookup(PageID pid, Page* page);
+	virtual bool Contains(PageID pid);
+	virtual void Put(PageID pid, const Page* page);
+	virtual void Invalidate(PageID first, int count = 1);
+	virtual void PrintStat();
+
+	size_t GetBytesUsed() const;
+	unsigned GetNumPages() const;
+
+private:
+	struct Entry {
+		PageID pid;
+		std::vector<char> data;		// compressed image, or the raw page
+	};
+	typedef std::list<Entry> EntryList;
+
+	size_t budget;
+	size_t bytesUsed;
+	EntryList entries;		// least recently used first
+	std::unordered_map<PageID, EntryList::iterator> index;
+
+	static size_t Footprint(const Entry& e);
+	void Erase(EntryList::iterator it);
+};
+
+#endif // _COMPRESSED_CACHE_H
@@ -8,8 +8,16 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "page.h"
+#include "buf_stats.h"
+#include "extent_index.h"
+#include "storage.h"
 
 // Each database is basically a UNIX file and consists of several relations
 // (viewed as heapfiles and their indexes) within it.
@@ -30,6 +38,18 @@ enum dbErrCodes {
     FILE_NOT_FOUND,
     FILE_NAME_TOO_LONG,
     NEG_RUN_SIZE,
+    BAD_DEVICE_MODEL,
+};
+
+// Options for creating a database.
+struct DBOptions {
+    bool compress;      // Store pages compressed; see DB::WritePage.
+    StorageKind storage;// Where the pages are kept; see storage.h.
+    const char* device; // Make the storage as slow as this device, as in
+                        // "hdd" or "ssd:qd=8"; see DelayStorage.  NULL for
+                        // no delay.
+
+    DBOptions() : compress(false), storage(FILE_STORAGE), device(0) {}
 };
 
 // oooooooooooooooooooooooooooooooooooooo
@@ -40,9 +60,11 @@ class DB {
     // Constructors
     // Create a database with the specified number of pages where the page
     // size is the default page size.
-    DB( const char* name, unsigned num_pages, Status& status );
+    DB( const char* name, unsigned num_pages, Status& status,
+        const DBOptions& options = DBOptions() );
 
-    // Open the database with the given name.
+    // Open the database with the given name.  A database that was created
+    // compressed is recognized by its page map file and opened compressed.
     DB( const char* name, Status& status );
 
     // Destructor: closes the database
@@ -54,9 +76,15 @@ class DB {
     // Read the contents of the specified page into the given memory area.
     Status ReadPage(PageID pageno, Page* pageptr);
 
-    // Write the contents of the specified page.
+    // Write the contents of the specified page.  In a compressed database
+    // the page is compressed first and stored in an extent just big enough
+    // for it; a page that does not compress is stored as is.
     Status WritePage(PageID pageno, Page* pageptr);
 
+    // Make every page written so far durable.  A compressed database
+    // saves its page map as well, once the pages it points at are on disk.
+    Status Sync();
+
     // Allocate a set of pages where the run size is taken to be 1 by default.
     // Gives back the page number of the first page of the allocated run.
     Status AllocatePage(PageID& start_page_num, int run_size = 1);
@@ -65,6 +93,20 @@ class DB {
     // a run size can be specified.
     Status DeallocatePage(PageID start_page_num, int run_size = 1);
 
+    // Choose how AllocatePage picks among the free runs that fit.
+    // The default is NEXT_FIT, which resumes after the last allocation.
+    void SetAllocPolicy(AllocPolicy policy);
+
+    // Single-page allocations are served from a small extent reserved by
+    // each calling thread, refilled this many pages at a time (default
+    // 64).  0 turns the per-thread caches off.
+    void SetExtentCacheSize(unsigned pages);
+
+    // Give the unused pages of every thread's extent cache back to the
+    // space map.  The buffer manager must still exist and no other thread
+    // may be allocating; SystemDefs calls this before shutting down.
+    Status ReleaseExtentCaches();
+
 
     // oooooooooooooooooooooooooooooooooooooo
 
@@ -82,34 +124,134 @@ class DB {
     int GetNumOfPages() const;
     int GetPageSize() const;
 
+    // Fragmentation of the free space: the number of free pages, the
+    // number of maximal free runs they form, and the longest such run.
+    int GetNumFreePages() const;
+    int GetNumFreeExtents() const;
+    int GetLargestFreeRun() const;
+
+    bool IsCompressed() const;
+
+    // Statistics on the pages this DB has stored: how many were read and
+    // written, in what pattern and how fast (see DBIOStats), and for a
+    // compressed database the compression ratio and the time spent in the
+    // codec.  GetIOStats may be called from any thread.
+    void ResetStat();
+    void PrintStat();
+    void GetIOStats( DBIOStats& stats );
+
     // Print out the space map of the database.
     // The space map is a bitmap showing which
     // pages of the db are currently allocated.
     Status dump_space_map();
 
   private:
-    int fd;
+    Storage* storage;
     unsigned num_pages;
     char* name;
 
+    ExtentIndex free_extents;   // Free runs, mirroring the space map.
+    AllocPolicy alloc_policy;
+    PageID alloc_cursor;        // Where the next NEXT_FIT search starts.
+
+      // Pages a thread has reserved for its own single-page allocations.
+      // The pages are already marked allocated in the space map.
+    struct extent_cache {
+        std::thread::id thread;
+        PageID   next;
+        unsigned left;
+    };
+
+    std::mutex space_lock;      // Guards the space map, free_extents,
+                                // alloc_cursor and extent_caches.
+    std::vector<extent_cache*> extent_caches;
+    unsigned extent_cache_size;
+    unsigned serial;            // Tells this DB's caches from a dead one's.
+
+      // Compressed storage.  The database file holds page images packed in
+      // extents of compress_unit bytes, and page_map says where each page
+      // is.  page_map is kept in memory and saved to "<name>.pagemap" by
+      // Sync and on close; free_units tracks the holes in the file.
+      //
+      // An extent the saved map points at is never written over, so that
+      // a crash leaves the file as the last saved map describes it: a
+      // page whose extent is saved moves to a new one when it is written,
+      // and the extents such pages leave behind stay in saved_frees, off
+      // free_units, until the next map is saved.
+    struct page_extent {
+        unsigned       unit;    // First unit of the extent.
+        unsigned short units;   // Length of the extent; 0 if never written.
+        unsigned short length;  // Bytes stored; MINIBASE_PAGESIZE if raw.
+    };
+
+    bool compressed;
+    std::vector<page_extent> page_map;
+    std::vector<bool> extent_saved;         // Page i's extent is in the saved map.
+    std::vector<page_extent> saved_frees;
+    ExtentIndex free_units;
+    unsigned file_units;        // Size of the database file, in units.
+    std::mutex io_lock;         // Guards the six above.
+
+      // I/O accounting for GetIOStats.
+    struct io_counts {
+        long long calls;
+        long long bytes;
+        long long sequential;
+        PageID    last;         // INVALID_PAGE before the first call.
+        long long run;          // Length of the run last is in.
+        long long runs[DBIOStats::RUN_BUCKETS];
+    };
+
+    std::mutex   stat_lock;     // Guards read_counts and write_counts.
+    io_counts    read_counts;
+    io_counts    write_counts;
+    LatencyStats io_latency;    // LAT_DB_READ and LAT_DB_WRITE.
+
+    long   pages_compressed;    // Pages written through the codec.
+    long   pages_stored_raw;    // Pages that did not compress.
+    long   pages_decompressed;
+    double bytes_in;            // Page bytes handed to WritePage.
+    double bytes_stored;        // Bytes actually written for them.
+    double compress_secs;
+    double decompress_secs;
+
     struct file_entry {
         PageID pagenum;         // INVALID_PAGE if no entry.
         char   fname[MAX_NAME];
     };
 
+      // A directory page is a fixed header followed by the entries
+      // themselves, filling the rest of the page.  The used entries are
+      // entries[0 .. num_used), kept sorted by name so that a page is
+      // searched by bisection.
     struct directory_page {
         PageID     next_page;
-        unsigned   num_entries;
-        file_entry *entries;  // Variable-sized struct
-//      file_entry entries[0];  // Variable-sized struct
+        PageID     next_free;    // Next page on the free-slot list.
+        unsigned   num_entries;  // Capacity of entries[].
+        unsigned   num_used;
+        file_entry entries[1];   // Really num_entries long.
     };
 
       // A first_page structure appears on the first page of the database.
     struct first_page {
         unsigned int   num_db_pages; // How big the database is.
+        PageID         free_dir_page;// First directory page with a free slot.
         directory_page dir;          // The first directory page.
     };               
 
+      // Where a file's entry lives: its start page, and the directory page
+      // holding the entry.
+    struct dir_location {
+        PageID start_page;
+        PageID dir_page;
+    };
+
+      // In-memory index of the whole directory, loaded when the database is
+      // opened and kept in step by AddFileEntry and DeleteFileEntry.
+    std::unordered_map<std::string, dir_location> file_index;
+    std::mutex dir_lock;        // Guards file_index; taken before any
+                                // directory page is pinned.
+
       /* Internal structure of a Minibase DB:
 
          The DB keeps two basic kinds of global information.  The first is
@@ -125,6 +267,19 @@ class DB {
          Page 1 of the database, and as many subsequent pages as needed,
          holds the "space map," which is a bitmap representing pages
          allocated in the database.
+
+         The directory pages form a chain through next_page.  Those with at
+         least one free slot are also linked through next_free, starting
+         from first_page::free_dir_page, so adding an entry goes straight
+         to a page with room.  A new directory page is linked in right
+         after page 0, so neither list ever has to be walked to its end.
+         Lookups do not read the directory pages at all: file_index holds
+         every entry.
+
+         The space map is mirrored in memory by an index of free extents
+         (see extent_index.h), rebuilt from the bitmap whenever the
+         database is created or opened, so that AllocatePage never has
+         to scan the bitmap.
      */
 
 
@@ -132,7 +287,44 @@ class DB {
     Status set_bits( PageID start, unsigned runsize, int bit );
 
       // Initializes the given directory page to contain no entries.
+      // used_bytes is the offset of dp->entries from the start of the page.
     void init_dir_page( directory_page* dp, unsigned used_bytes );
+
+      // The directory_page structure on the given pinned header page.
+    static directory_page* dir_page_of( PageID hpid, char* pg );
+
+      // Bisect a directory page for fname.  Sets slot to the entry if it is
+      // there, or to where it would be inserted if not.
+    static bool find_in_dir_page( const directory_page* dp, const char* fname,
+                                  unsigned& slot );
+
+      // Rebuild file_index by walking the directory chain.
+    Status load_directory();
+
+      // Rebuild free_extents from the space map.
+    Status build_extent_index();
+
+      // Count a read or write of bytes at pageno, taking latency from start.
+    void count_io( io_counts& counts, LatencyOp op, PageID pageno,
+                   unsigned bytes, unsigned long long start );
+
+      // Compressed-storage halves of ReadPage, WritePage and DeallocatePage.
+      // The first two set bytes to the bytes they moved.
+    Status read_compressed( PageID pageno, Page* pageptr, unsigned& bytes );
+    Status write_compressed( PageID pageno, Page* pageptr, unsigned& bytes );
+    void   free_compressed( PageID start_page_num, unsigned run_size );
+
+      // Name of the page map file, and loading and saving it.
+    char*  page_map_name() const;
+    Status load_page_map();
+    Status save_page_map();     // io_lock must be held.
+    void   move_extent( PageID pageno, unsigned short units );
+
+      // Allocate a run from free_extents; space_lock must be held.
+    Status allocate_run( PageID& start_page_num, unsigned run_size );
+
+      // The calling thread's extent cache, created on first use.
+    extent_cache* my_extent_cache();
 };
 
 // oooooooooooooooooooooooooooooooooooooo
@@ -0,0 +1,87 @@
+#ifndef _DELAY_STORAGE_H
+#define _DELAY_STORAGE_H
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#include "storage.h"
+
+// How long a device takes to serve a request.  A request waits for one of
+// queueDepth slots; its service time is a lognormal around the median
+// (jitter is the sigma, 0 for a fixed time), plus a seek and half a
+// rotation on average if the device has a head and the request does not
+// start where the last one ended, plus the transfer at mbps over a bus
+// shared by all slots.
+struct DeviceModel {
+    double readUs;          // Median service time of a read, in us.
+    double writeUs;         // Median service time of a write, in us.
+    double jitter;
+    double mbps;            // Transfer rate in MB/s; 0 for no limit.
+    int    queueDepth;
+    double seekMs;          // Full-stroke seek; 0 if there is no head.
+    double trackSeekMs;     // Shortest seek.
+    double rpm;             // 0 if there is no spindle.
+};
+
+// A storage that behaves like a slow device: it passes every request to
+// the storage it wraps and then holds the caller until the device model
+// says the request would have finished.  It is a stand-in for real disks
+// when benchmarking; see List for the models and their parameters.
+class DelayStorage : public Storage
+{
+	public:
+
+		// Wrap inner in the device named by spec, "preset" or
+		// "preset:name=value,...", overriding the preset's parameters.
+		// Returns NULL, leaving inner to the caller, if the spec is bad.
+		static DelayStorage* Create( const char* spec, Storage* inner );
+
+		// Print the presets and the parameters.
+		static void List( std::ostream& out );
+
+		~DelayStorage();
+
+		Status Open( const char* name, StorageMode mode );
+		void Close();
+		Status Read( long long offset, void* buf, unsigned length );
+		Status Write( long long offset, const void* buf, unsigned length );
+		Status Sync();
+		Status Allocate( long long size );
+		bool IsPersistent() const;
+
+		const DeviceModel& GetModel() const { return model; }
+
+		// Total time callers have been held, in seconds.
+		double GetDelaySeconds();
+
+	private:
+
+		typedef std::chrono::steady_clock Clock;
+
+		DelayStorage( const DeviceModel& model, Storage* inner );
+
+		DeviceModel model;
+		Storage* inner;
+
+		std::mutex lock;                    // Guards everything below.
+		std::vector<Clock::time_point> slotFree;   // When each slot is idle.
+		Clock::time_point busFree;          // When the bus is idle.
+		long long head;                     // Where the last request ended.
+		long long span;                     // The size of the store.
+		unsigned long long random;          // xorshift64* state.
+		double delaySecs;
+
+		// When a request arriving now would finish.
+		Clock::time_point Schedule( long long offset, unsigned length, double medianUs );
+
+		// Hold the caller until done, sleeping while that is far off and
+		// spinning for the last stretch, where sleeps overshoot.
+		void WaitUntil( Clock::time_point done );
+
+		double NextDouble();
+		double NextNormal();
+};
+
+#endif // _DELAY_STORAGE_H
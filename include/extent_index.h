@@ -0,0 +1,81 @@
+#ifndef _EXTENT_INDEX_H
+#define _EXTENT_INDEX_H
+
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "page.h"
+
+// How AllocatePage picks among the free runs that are big enough.
+enum AllocPolicy {
+    FIRST_FIT,      // lowest-addressed run that fits
+    BEST_FIT,       // smallest run that fits, lowest address on ties
+    NEXT_FIT        // first run that fits at or after a rotating cursor
+};
+
+// In-memory index of the free extents (maximal runs of unallocated pages)
+// of a database.  It mirrors the space map bitmap and lets the DB find a
+// run of any size without scanning the bitmap.
+//
+// Extents are kept three ways:
+//   - by start page, to coalesce neighbours and carve allocations;
+//   - by (length, start), which answers best-fit with one lower_bound;
+//   - in a segment tree over the pages, holding at each page the length of
+//     the extent that starts there and at each node the longest below it,
+//     which answers "the first extent at or after a page that holds n
+//     pages" in O(log pages).  It costs two words per page of the file.
+class ExtentIndex
+{
+	public:
+
+		ExtentIndex();
+		~ExtentIndex();
+
+		// Forget every extent.
+		void Clear();
+
+		// Record that pages [start, start+runSize) are free.  Overlapping
+		// or adjacent extents are coalesced.
+		void MarkFree(PageID start, unsigned runSize);
+
+		// Record that pages [start, start+runSize) are allocated.  Extents
+		// covering any part of the range are split around it.
+		void MarkUsed(PageID start, unsigned runSize);
+
+		// Find the start of a free run of at least runSize pages chosen
+		// according to policy.  NEXT_FIT looks at runs starting at or
+		// after cursor first and wraps around to the start of the file.
+		// Returns INVALID_PAGE if there is none.
+		PageID FindRun(unsigned runSize, AllocPolicy policy, PageID cursor = 0) const;
+
+		// Fragmentation metrics.
+		unsigned GetNumFreePages() const;
+		unsigned GetNumExtents() const;
+		unsigned GetLargestRun() const;
+
+	private:
+
+		typedef std::map<PageID, unsigned> StartMap;
+		typedef std::set< std::pair<unsigned, PageID> > SizeSet;
+
+		StartMap byStart;                 // start -> length
+		SizeSet  bySize;                  // (length, start)
+		unsigned numFreePages;
+
+		// The segment tree: longest[leaves + p] is the length of the
+		// extent starting at page p, or 0, and every other node holds
+		// the larger of its two children.  leaves is a power of two.
+		std::vector<unsigned> longest;
+		unsigned leaves;
+
+		PageID FindFirstFrom(unsigned runSize, PageID from) const;
+		PageID FirstFit(unsigned node, PageID lo, PageID hi, PageID from, unsigned runSize) const;
+		void SetLength(PageID start, unsigned runSize);
+		void Grow(PageID pages);
+		void Insert(PageID start, unsigned runSize);
+		void Erase(StartMap::iterator it);
+};
+
+#endif // _EXTENT_INDEX_H
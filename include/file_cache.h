@@ -0,0 +1,61 @@
+#ifndef _FILE_CACHE_H
+#define _FILE_CACHE_H
+
+#include <deque>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "storage.h"
+#include "victim_cache.h"
+
+// Victim cache kept in a local file, for databases on slow (e.g. network)
+// storage with a fast local disk to spare.  The file holds a fixed number
+// of page slots; which page is in which slot is indexed in memory only, so
+// the file is scratch space and starts empty every time.  Slots are
+// recycled by CLOCK.
+//
+// Admission: by default a page is only written to the file the second time
+// it is evicted within the last numSlots offers, so a one-off scan passes
+// through without flushing the cache.  SetAdmitAll(true) admits every page.
+class FileCache : public VictimCache {
+public:
+	// Create (or truncate) the cache file at path with room for numSlots
+	// pages.  The file is removed again when the cache is destroyed.
+	FileCache(const char* path, unsigned numSlots, Status& status);
+	virtual ~FileCache();
+
+	virtual bool Lookup(PageID pid, Page* page);
+	virtual bool Contains(PageID pid);
+	virtual void Put(PageID pid, const Page* page);
+	virtual void Invalidate(PageID first, int count = 1);
+	virtual void PrintStat();
+
+	void SetAdmitAll(bool on);
+	unsigned GetNumPages() const;
+
+private:
+	char* path;
+	FileStorage file;
+	bool isOpen;
+	unsigned numSlots;
+	bool admitAll;
+
+	std::unordered_map<PageID, unsigned> index;	// page -> slot
+	std::vector<PageID> slotPage;				// slot -> page, INVALID_PAGE if free
+	std::vector<char> referenced;				// CLOCK reference bits
+	std::vector<unsigned> freeSlots;
+	unsigned hand;
+
+	// Pages offered but not admitted, oldest first.  A page's entry in
+	// recentOffers is current only if its sequence number matches.
+	std::unordered_map<PageID, unsigned long> recentOffers;
+	std::deque< std::pair<PageID, unsigned long> > offerOrder;
+	unsigned long offerSeq;
+
+	bool Admit(PageID pid);
+	unsigned FindSlot();
+	void Drop(unsigned slot);
+};
+
+#endif // _FILE_CACHE_H
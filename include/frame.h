@@ -3,22 +3,67 @@
 
 #include "page.h"
 #include "db.h"
+#include "latency_stats.h"
+#include "latch.h"
 
 #define INVALID_FRAME -1
 
-class Frame 
+// Error codes of the buffer manager's error table (see bufmgr.cpp).
+enum bufErrCodes {
+	BAD_PAGE_CHECKSUM,
+	CACHE_FILE_ERROR,
+	UNKNOWN_REPLACER,
+	BAD_REPLACER_PARAM,
+	STATS_FILE_ERROR,
+	STATS_SERVER_ERROR,
+	TRACE_FILE_ERROR,
+};
+
+// The parts of a frame that do not depend on the page size.
+class FrameBase
+{
+	protected :
+
+		static bool checksums;
+
+		// Frame buffers start on a DirectStorage block, so that a page
+		// goes straight between the frame and the device.
+		static char* AllocateData(int size);
+		static void FreeData(char* data);
+
+	public :
+
+		// The checksum lives in the last PAGE_TRAILER_SIZE bytes of a
+		// page of any size and covers the rest of it.  Page's own
+		// checksum methods are these with MINIBASE_PAGESIZE.
+		static void StampChecksum(char* data, int size);
+		static bool ChecksumOK(const char* data, int size);
+
+		// Whether Write stamps and Read verifies the page checksum.
+		// Applies to all frames; on by default.
+		static void SetChecksums(bool on);
+};
+
+// A frame of the buffer pool, holding one page of PageSize bytes.  A page
+// bigger than MINIBASE_PAGESIZE is stored in the DB as a run of
+// PageSize / MINIBASE_PAGESIZE consecutive DB pages and named by the first.
+template <int PageSize>
+class BasicFrame : public FrameBase
 {
 	private :
 	
 		PageID pid;
-		Page   *data;
+		char   *data;
 		int    pinCount;
 		bool    dirty;
-		
+		Latch   latch;
+
+		enum { BLOCKS = PageSize / MINIBASE_PAGESIZE };
+
 	public :
 		
-		Frame();
-		~Frame();
+		BasicFrame();
+		~BasicFrame();
 		void Pin();
 		void Unpin();
 		int GetPinCount();
@@ -27,12 +72,121 @@ class Frame
 		void SetPageID(PageID pid);
 		bool IsDirty();
 		bool IsValid();
-		Status Write();
-		Status Read(PageID pid);
+		// If latency is given, the DB calls are timed into it as
+		// LAT_DB_WRITE and LAT_DB_READ.
+		Status Write(LatencyStats* latency = NULL);
+		Status Read(PageID pid, LatencyStats* latency = NULL);
 		bool NotPinned();
 		PageID GetPageID();
 		Page *GetPage();
 
+		// Guards the page's contents for pins that ask for it (see
+		// PageGuard); the frame itself never takes it.
+		Latch& GetLatch() { return latch; }
+
 };
 
+typedef BasicFrame<MINIBASE_PAGESIZE> Frame;
+
+template <int PageSize>
+BasicFrame<PageSize>::BasicFrame() {
+	static_assert(PageSize % MINIBASE_PAGESIZE == 0,
+	              "the page size must be a multiple of MINIBASE_PAGESIZE");
+	pid = INVALID_PAGE;
+	data = AllocateData(PageSize);
+	pinCount = 0;
+	dirty = false;
+}
+
+template <int PageSize>
+BasicFrame<PageSize>::~BasicFrame() {
+	FreeData(data);
+}
+
+template <int PageSize>
+inline void BasicFrame<PageSize>::Pin() {
+	pinCount++;
+}
+
+template <int PageSize>
+inline void BasicFrame<PageSize>::Unpin() {
+	pinCount--;
+}
+
+template <int PageSize>
+inline int BasicFrame<PageSize>::GetPinCount() {
+	return pinCount;
+}
+
+template <int PageSize>
+inline void BasicFrame<PageSize>::EmptyIt() {
+    pid = INVALID_PAGE;
+    pinCount = 0;
+    dirty = false;
+	// Do we need to wipe the data?
+}
+
+template <int PageSize>
+inline void BasicFrame<PageSize>::DirtyIt() {
+	dirty = true;
+}
+
+template <int PageSize>
+inline void BasicFrame<PageSize>::SetPageID(PageID pid) {
+	this->pid = pid;
+}
+
+template <int PageSize>
+inline bool BasicFrame<PageSize>::IsDirty() {
+	return dirty;
+}
+
+template <int PageSize>
+inline bool BasicFrame<PageSize>::IsValid() {
+    return (pid != INVALID_PAGE);
+}
+    
+template <int PageSize>
+Status BasicFrame<PageSize>::Write(LatencyStats* latency) {
+   if (checksums) StampChecksum(data, PageSize);
+
+   unsigned long long start = latency ? LatencyStats::Now() : 0;
+   for (int b = 0; b < BLOCKS; b++) {
+      Status status = MINIBASE_DB->WritePage(pid + b, (Page*)(data + b * MINIBASE_PAGESIZE));
+      if (status != OK) return status;
+   }
+   if (latency) latency->Record(LAT_DB_WRITE, start);
+   return OK;
+}
+
+template <int PageSize>
+Status BasicFrame<PageSize>::Read(PageID pid, LatencyStats* latency){ 
+   unsigned long long start = latency ? LatencyStats::Now() : 0;
+   for (int b = 0; b < BLOCKS; b++) {
+      Status status = MINIBASE_DB->ReadPage(pid + b, (Page*)(data + b * MINIBASE_PAGESIZE));
+      if (status != OK) return status;
+   }
+   if (latency) latency->Record(LAT_DB_READ, start);
+
+   if (checksums && !ChecksumOK(data, PageSize))
+      return MINIBASE_FIRST_ERROR(BUFMGR, BAD_PAGE_CHECKSUM);
+   return OK;
+}
+
+template <int PageSize>
+inline bool BasicFrame<PageSize>::NotPinned() {
+	return pinCount == 0;
+}
+
+template <int PageSize>
+inline PageID BasicFrame<PageSize>::GetPageID() { 
+	return pid;
+}
+
+// For a page bigger than MINIBASE_PAGESIZE, the start of the page.
+template <int PageSize>
+inline Page *BasicFrame<PageSize>::GetPage(){
+	return (Page*)data;
+}
+
 #endif
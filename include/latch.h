@@ -0,0 +1,85 @@
+#ifndef _LATCH_H
+#define _LATCH_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+// A reader/writer latch for one buffer frame: any number of threads may
+// hold it shared, or one thread exclusive.  Taking and dropping a free
+// latch is one atomic operation on state, with no system call; a thread
+// that finds it taken spins for a while and then parks on a condition
+// variable until a release wakes it.  A parked writer bars new readers,
+// so a stream of readers cannot starve it.
+//
+// The latch is not recursive: a thread that takes it twice, in either
+// mode, may wait forever on itself.
+class Latch
+{
+	public:
+
+		Latch() : state(0), parked(0) {}
+
+		void LockShared() { if (!TryLockShared()) Wait(false); }
+		void LockExclusive() { if (!TryLockExclusive()) Wait(true); }
+		void UnlockShared() { state.fetch_sub(1); WakeParked(); }
+		void UnlockExclusive() { state.fetch_and(~(unsigned)EXCLUSIVE); WakeParked(); }
+
+		bool TryLockShared();
+		bool TryLockExclusive();
+
+		// Turn a shared hold into an exclusive one, if the caller is the
+		// only reader; otherwise leave it shared and return false.
+		bool TryUpgrade();
+
+		// Turn an exclusive hold into a shared one, without letting go.
+		void Downgrade();
+
+		bool IsLocked() const { return (state.load() & (EXCLUSIVE | READERS)) != 0; }
+
+	private:
+
+		enum {
+			READERS        = (1u << 30) - 1,   // the number of shared holders
+			EXCLUSIVE      = 1u << 30,
+			WRITER_WAITING = 1u << 31          // a writer is parked
+		};
+
+		std::atomic<unsigned> state;
+		std::atomic<int> parked;        // threads in Wait's slow part
+		std::mutex parkLock;
+		std::condition_variable parkCond;
+
+		// Spin, then park, until the latch is ours.
+		void Wait(bool exclusive);
+
+		// Wake the parked threads, if there are any, to try again.
+		void WakeParked() { if (parked.load() > 0) WakeAll(); }
+		void WakeAll();
+
+		Latch( const Latch& );
+		Latch& operator=( const Latch& );
+};
+
+// Both retry for as long as the latch looks free, so that they fail only
+// when it is taken, never because another thread got in between the load
+// and the exchange.
+inline bool Latch::TryLockShared()
+{
+	unsigned s = state.load(std::memory_order_relaxed);
+	while ((s & (EXCLUSIVE | WRITER_WAITING)) == 0)
+		if (state.compare_exchange_weak(s, s + 1, std::memory_order_acquire))
+			return true;
+	return false;
+}
+
+inline bool Latch::TryLockExclusive()
+{
+	unsigned s = state.load(std::memory_order_relaxed);
+	while ((s & (EXCLUSIVE | READERS)) == 0)
+		if (state.compare_exchange_weak(s, (unsigned)EXCLUSIVE, std::memory_order_acquire))
+			return true;
+	return false;
+}
+
+#endif // _LATCH_H
@@ -0,0 +1,116 @@
+#ifndef _LATENCY_STATS_H
+#define _LATENCY_STATS_H
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#   include <intrin.h>
+#   define LATENCY_HAVE_TSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+#   include <x86intrin.h>
+#   define LATENCY_HAVE_TSC 1
+#else
+#   include <chrono>
+#   define LATENCY_HAVE_TSC 0
+#endif
+
+// The operations the buffer manager times.
+enum LatencyOp {
+	LAT_PIN_HIT,        // PinPage, page already in the pool
+	LAT_PIN_MISS,       // PinPage, page brought in
+	LAT_EVICTION,       // choosing and emptying a victim frame
+	LAT_DIRTY_WRITE,    // writing a dirty page back
+	LAT_DB_READ,        // DB::ReadPage of a missed page
+	LAT_DB_WRITE,       // DB::WritePage of a dirty page
+	NUM_LATENCY_OPS
+};
+
+// What GetSummary reports of one operation, in nanoseconds.
+struct LatencySummary {
+	unsigned long long count;
+	double mean, p50, p99, p999, max;
+};
+
+// Latency histograms, one per LatencyOp, cheap enough to leave on.
+//
+// Times are taken with the CPU's time-stamp counter where there is one
+// and converted to nanoseconds only when read.  Buckets are log-linear
+// (as in HdrHistogram): values below 32 ticks get a bucket each, and every
+// power of two above that is split into 16 buckets, so a reported
+// percentile is within 1/16 of the true value.  Each thread records into
+// its own set of counters, with no locking or shared cache lines; reads
+// merge them.
+class LatencyStats
+{
+	public:
+
+		LatencyStats();
+		~LatencyStats();
+
+		// The current time, in ticks, for starting a measurement.
+		static unsigned long long Now();
+
+		// Record the time from start (a Now() value) to now.  A caller
+		// that times only one operation in n passes weight n, so counts
+		// and means still describe every operation.
+		void Record(LatencyOp op, unsigned long long start, unsigned weight = 1);
+
+		// Merged over all threads.  Percentile takes q in [0, 1] and
+		// returns nanoseconds, 0 if nothing was recorded.
+		unsigned long long GetCount(LatencyOp op);
+		double GetMean(LatencyOp op);
+		double GetPercentile(LatencyOp op, double q);
+		LatencySummary GetSummary(LatencyOp op);
+
+		// Zero every counter.  Records made during the reset may be lost.
+		void Reset();
+
+		// One line per operation: count, mean, p50, p99, p999, max.
+		void Print(std::ostream& out);
+
+		static const char* OpName(LatencyOp op);
+
+		// The log-linear buckets, also used by MissRatioCurve.  Bucket
+		// maps any 64-bit value to [0, NUM_BUCKETS); BucketLow is the
+		// smallest value in a bucket.
+		enum { LINEAR_BITS = 5, HALF = 1 << (LINEAR_BITS - 1), NUM_BUCKETS = 64 * HALF };
+		static int Bucket(unsigned long long value);
+		static unsigned long long BucketLow(int bucket);
+
+	private:
+
+		// Written only by the thread that owns it.
+		struct Shard {
+			std::thread::id owner;
+			std::atomic<unsigned long long> counts[NUM_LATENCY_OPS][NUM_BUCKETS];
+			std::atomic<unsigned long long> sums[NUM_LATENCY_OPS];
+		};
+
+		std::mutex shardLock;
+		std::vector<Shard*> shards;
+		unsigned serial;
+
+		// For converting ticks to nanoseconds.
+		unsigned long long startTicks;
+		double startSeconds;
+
+		Shard* MyShard();
+		void Merge(LatencyOp op, std::vector<unsigned long long>& counts);
+		double NsPerTick();
+};
+
+inline unsigned long long LatencyStats::Now()
+{
+#if LATENCY_HAVE_TSC
+	return __rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+#endif // _LATENCY_STATS_H
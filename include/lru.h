@@ -5,19 +5,53 @@
 #include "replacer.h"
 #include <list>
 
+
+// SCHEMA FOR LEAST RECENTLY USED POLICY
+// Uses a list to maintain elements.
+// The head element is the least recently used.
+// New elements are added to the tail and old duplicate entries removed if present
+//
+// The methods are defined here so that a BufPool<LRU> can inline them.
+
 // LRU Buffer Replacement
 class LRU : public Replacer {
 public:
-	LRU();
-	virtual ~LRU();
+	LRU() {
+		frameChain = new std::list<int>();
+	}
+
+	virtual ~LRU() {
+		std::list<int>().swap(*frameChain); /* Not sure if I need this line but too afraid to remove.
+											   It creates a temporary empty list to swap the chain into
+											   effectively freeing both of their memories allocated to
+											   store their respective elements in a single statement. */
+		frameChain->clear();
+		delete frameChain;
+	}
+
+	virtual int PickVictim() {
+		if(frameChain->empty()) return INVALID_PAGE;
+		int victimFrameID = frameChain->front();
+		frameChain->pop_front();
+		return victimFrameID;
+	}
+
+	virtual void AddFrame(int f) {
+		frameChain->remove(f);
+		frameChain->push_back(f);
+	}
+
+	virtual void RemoveFrame(int f) {
+		frameChain->remove(f);
+	}
 
-	virtual int PickVictim();
-	virtual void AddFrame(int f);
-	virtual void RemoveFrame(int f); 
+	virtual void GetStats(ReplacerStats& stats) const {
+		stats.push_back(std::make_pair(std::string("candidates"), (double)frameChain->size()));
+	}
 
 private:
 	std::list<int>* frameChain;
 
 };
 
-#endif // LRU
\ No newline at end of file
+#endif // LRU
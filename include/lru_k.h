@@ -0,0 +1,57 @@
+#ifndef _LRU_K_H
+#define _LRU_K_H
+
+#include "db.h"
+#include "replacer.h"
+#include <deque>
+#include <set>
+#include <unordered_map>
+
+// LRU-K Buffer Replacement (O'Neil, O'Neil and Weikum)
+//
+// Evicts the unpinned page whose K-th most recent use is oldest.  Pages
+// used fewer than K times go first, least recently used first, so a page
+// touched once by a scan does not push out pages that are used repeatedly.
+// A use is an unpin.  Histories outlive eviction, so a page that comes
+// back soon keeps its history; at most `retain` histories of pages that
+// have left the pool are kept.  A pinned page keeps its history.
+class LRUK : public Replacer {
+public:
+	LRUK(int k = 2, int retain = 4096);
+	virtual ~LRUK();
+
+	virtual int PickVictim();
+	virtual void AddFrame(int f);
+	virtual void RemoveFrame(int f);
+	virtual void DropFrame(int f);
+
+	// candidates, candidates_below_k (candidates used fewer than K
+	// times), histories (pages with a kept history).
+	virtual void GetStats(ReplacerStats& stats) const;
+
+private:
+	// (K-th most recent use or -1 if fewer than K, most recent use, page)
+	typedef std::set< std::pair<std::pair<long, long>, int> > Order;
+
+	struct History {
+		std::deque<long> uses;		// most recent last, at most K
+		bool candidate;
+		Order::iterator pos;		// valid if candidate
+		long retiredAt;				// when the page left the pool, 0 if it is in it
+
+		History() : candidate(false), retiredAt(0) {}
+	};
+
+	int k;
+	int retain;
+	long now;
+	long retirements;
+	Order candidates;
+	std::unordered_map<int, History> histories;
+	std::deque< std::pair<int, long> > retired;	// (page, retiredAt), oldest first
+
+	static std::pair<std::pair<long, long>, int> Key(int pid, const History& h, int k);
+	void Retire(int pid);
+};
+
+#endif // LRU_K
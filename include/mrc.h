@@ -0,0 +1,90 @@
+#ifndef _MRC_H
+#define _MRC_H
+
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "latency_stats.h"
+
+// Online estimate of the miss-ratio curve: the hit ratio an LRU pool of
+// any size would have had on the pages pinned so far.
+//
+// It follows SHARDS (Waldspurger et al., FAST '15).  A page is sampled if
+// a hash of its id falls below a threshold, so every reference to it is
+// seen and its reuse distances (distinct pages used since its last use)
+// among the sampled pages are exact; scaled by 1/rate they estimate the
+// distances among all pages.  At most maxSamples pages are tracked: when
+// there are more, the page with the largest hash is dropped and the
+// threshold lowered to it, so memory stays bounded however many pages the
+// database has.  Rarely used pages therefore cost a hash and a compare.
+//
+// The curve is LRU's.  Other policies do better or worse at each size
+// (trace_sim shows how much), but the shape tells whether more frames
+// would help.
+class MissRatioCurve
+{
+	public:
+
+		// rate is the starting sampling rate, in (0, 1].  Tracking a
+		// sampled reference costs about as much as a pin hit, so the
+		// default samples one page in 16; with fewer than a few hundred
+		// sampled pages the small sizes are rough.
+		MissRatioCurve(double rate = 0.0625, int maxSamples = 4096);
+
+		// Note a reference to pid.
+		void Access(int pid)
+		{
+			unsigned h = Hash(pid);
+			if (h < threshold) Sample(pid, h);
+		}
+
+		// The estimated hit ratio of an LRU pool of numFrames frames, 0 if
+		// nothing has been sampled yet.
+		double PredictHitRatio(int numFrames) const;
+
+		double GetSamplingRate() const { return (double)threshold / HASH_RANGE; }
+
+		// Forget the distances seen so far, but not the pages.
+		void Reset();
+
+	private:
+
+		enum { HASH_BITS = 24, HASH_RANGE = 1 << HASH_BITS };
+
+		struct Sampled {
+			unsigned long long time;	// of the last reference
+			unsigned hash;
+		};
+
+		unsigned threshold;		// a page is sampled if its hash is below
+		int maxSamples;
+
+		std::unordered_map<int, Sampled> pages;
+		std::set< std::pair<unsigned, int> > byHash;	// to drop the largest
+
+		// A Fenwick tree over reference times, counting the pages whose
+		// last reference was at each time.
+		std::vector<int> tree;
+		unsigned long long clock;
+
+		// Reuse distances, scaled to all pages, in log-linear buckets as in
+		// LatencyStats; each reference weighs 1/rate.
+		double histogram[LatencyStats::NUM_BUCKETS];
+		double coldWeight;
+		double totalWeight;
+
+		static unsigned Hash(int pid)
+		{
+			return (unsigned)(((unsigned long long)(unsigned)pid * 0x9E3779B97F4A7C15ULL) >> (64 - HASH_BITS));
+		}
+
+		void Sample(int pid, unsigned hash);
+		void Drop(int pid);
+		void Renumber();
+		void TreeAdd(unsigned long long time, int delta);
+		int TreeCount(unsigned long long time) const;	// times 1..time
+};
+
+#endif // _MRC_H
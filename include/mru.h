@@ -5,19 +5,47 @@
 #include "replacer.h"
 #include <list>
 
+// The methods are defined here so that a BufPool<MRU> can inline them.
+
 // MRU Buffer Replacement
 class MRU : public Replacer {
 public:
-	MRU();
-	virtual ~MRU();
+	MRU() {
+		frameChain = new std::list<int>();
+	}
+
+	virtual ~MRU() {
+		std::list<int>().swap(*frameChain); /* Not sure if I need this line but too afraid to remove.
+											   It creates a temporary empty list to swap the chain into
+											   effectively freeing both of their memories allocated to
+											   store their respective elements in a single statement. */
+		frameChain->clear();
+		delete frameChain;
+	}
+
+	virtual int PickVictim() {
+		if(frameChain->empty()) return INVALID_PAGE;
+		int victimFrameID = frameChain->back();
+		frameChain->pop_back();
+		return victimFrameID;
+	}
+
+	virtual void AddFrame(int f) {
+		frameChain->remove(f);
+		frameChain->push_back(f);
+	}
+
+	virtual void RemoveFrame(int f) {
+		frameChain->remove(f);
+	}
 
-	virtual int PickVictim();
-	virtual void AddFrame(int f);
-	virtual void RemoveFrame(int f);
+	virtual void GetStats(ReplacerStats& stats) const {
+		stats.push_back(std::make_pair(std::string("candidates"), (double)frameChain->size()));
+	}
 
 private:
 	std::list<int>* frameChain;
 
 };
 
-#endif // MRU
\ No newline at end of file
+#endif // MRU
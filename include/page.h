@@ -9,7 +9,11 @@
 #include "minirel.h"
 
 const PageID INVALID_PAGE = -1;
-const int    MAX_SPACE = MINIBASE_PAGESIZE;
+
+// The last bytes of every page on disk are a trailer holding the page's
+// checksum; the rest is usable space.
+const int    PAGE_TRAILER_SIZE = sizeof(unsigned int);
+const int    MAX_SPACE = MINIBASE_PAGESIZE - PAGE_TRAILER_SIZE;
 
 
 class Page 
@@ -17,11 +21,19 @@ class Page
 	private:
 		
 		char data[MAX_SPACE];
+		unsigned int checksum;    // CRC32C of data; 0 if never written.
 
 	public:
 	    
 		Page();
 		~Page();
+
+		// Store the checksum of data in the trailer.
+		void StampChecksum();
+
+		// True if the trailer matches data.  A page that was never
+		// written (all zero, trailer included) also passes.
+		bool ChecksumOK() const;
 };
 
 #endif  // _PAGE_H
@@ -0,0 +1,17 @@
+#ifndef _PAGE_CODEC_H
+#define _PAGE_CODEC_H
+
+// A small, self-contained LZ77 codec for pages, writing the LZ4 block format
+// (greedy matching with a 4-byte hash, no entropy coding).  It trades ratio
+// for speed: a page compresses in a few microseconds and decompresses in
+// about one.
+
+// Compress srcLen bytes of src into dst.  Returns the compressed size, or 0
+// if it would not fit in dstCapacity bytes.  srcLen must be below 64 KB.
+int PageCompress( const char* src, int srcLen, char* dst, int dstCapacity );
+
+// Decompress srcLen bytes of src into exactly dstLen bytes of dst.  Returns
+// dstLen, or -1 if the input is malformed or does not decode to dstLen bytes.
+int PageDecompress( const char* src, int srcLen, char* dst, int dstLen );
+
+#endif // _PAGE_CODEC_H
@@ -0,0 +1,78 @@
+#ifndef _PAGE_GUARD_H
+#define _PAGE_GUARD_H
+
+#include <stddef.h>
+
+#include "page.h"
+#include "latch.h"
+
+class BufMgr;
+
+// What the holder of a pin means to do with the page.  A guard's pin
+// holds the frame's latch in the matching mode: shared for PIN_READ,
+// exclusive for PIN_WRITE.
+enum PinIntent {
+	PIN_READ,
+	PIN_WRITE
+};
+
+// A pin on a page, filled in by BufMgr::PinPage and released when the
+// guard is destroyed, reassigned or Released, so no return path can leak
+// it.  The guard remembers the frame holding the page, so releasing it
+// does not search the pool.  A page held with write intent is marked dirty
+// when it is released; once it has been, it stays dirty after a
+// Downgrade.  Guards move but do not copy; a moved-from guard holds
+// nothing.
+//
+// While the guard holds the page, it holds the frame's latch too, so
+// readers see no half-made change.  Latches are not recursive: a thread
+// must not hold two guards on one page, and should take the latches of
+// several pages in a fixed order, as the DB takes page 0 before the
+// space map.
+class PageGuard
+{
+	public:
+
+		PageGuard() : mgr(NULL), frame(-1), pid(INVALID_PAGE), page(NULL),
+		              latch(NULL), intent(PIN_READ), dirty(false) {}
+		~PageGuard() { Release(); }
+
+		PageGuard( PageGuard&& other );
+		PageGuard& operator=( PageGuard&& other );
+
+		bool IsValid() const { return mgr != NULL; }
+		PageID GetPageID() const { return pid; }
+		Page* GetPage() const { return page; }
+		PinIntent GetIntent() const { return intent; }
+		bool IsDirty() const { return dirty; }
+
+		// Switch to write intent, marking the page dirty.  Returns true if
+		// the latch went straight from shared to exclusive.  If other
+		// readers held it, it had to be let go first, and the page may
+		// have changed since the caller last looked.
+		bool Upgrade();
+
+		// Switch back to read intent, letting readers in at once.
+		void Downgrade();
+
+		// Unpin the page now.  Returns OK if nothing was held, or what the
+		// unpin returned.
+		Status Release();
+
+	private:
+
+		friend class BufMgr;
+
+		BufMgr* mgr;        // NULL if nothing is held
+		int frame;
+		PageID pid;
+		Page* page;
+		Latch* latch;       // the frame's, held in the mode of intent
+		PinIntent intent;
+		bool dirty;
+
+		PageGuard( const PageGuard& );
+		PageGuard& operator=( const PageGuard& );
+};
+
+#endif // _PAGE_GUARD_H
@@ -0,0 +1,75 @@
+#ifndef _PAGE_TABLE_H
+#define _PAGE_TABLE_H
+
+#include <vector>
+
+#include "page.h"
+#include "frame.h"
+
+// A hint to start loading p into the cache, for lookups that know what
+// they will touch next; nothing where the compiler has no such intrinsic.
+#if defined(__GNUC__) || defined(__clang__)
+#	define BUF_PREFETCH(p) __builtin_prefetch(p)
+#elif defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#	include <xmmintrin.h>
+#	define BUF_PREFETCH(p) _mm_prefetch((const char*)(p), _MM_HINT_T0)
+#else
+#	define BUF_PREFETCH(p) ((void)0)
+#endif
+
+// The buffer pool's page table: which frame holds each page.  It is a hash
+// table with open addressing and linear probing, never more than half
+// full, so a lookup is usually one probe and at worst a few adjacent
+// slots.  A batch of lookups prefetches the slot of a page further on
+// while it probes for this one, so that their cache misses overlap.
+class PageTable
+{
+	public:
+
+		PageTable();
+
+		// Forget every page and make room for n.
+		void Reset( int n );
+
+		// The frame holding pid, or INVALID_FRAME.
+		int Find( PageID pid ) const;
+
+		// Start loading the slot where the search for pid begins.
+		void Prefetch( PageID pid ) const { BUF_PREFETCH(&slots[Home(pid)]); }
+
+		// Record that frame now holds pid, which no frame held.
+		void Insert( PageID pid, int frame );
+
+		// Record that no frame holds pid any more.
+		void Erase( PageID pid );
+
+		int Size() const { return count; }
+
+	private:
+
+		struct Slot {
+			PageID pid;         // INVALID_PAGE if the slot is empty
+			int frame;
+		};
+
+		std::vector<Slot> slots;    // A power of two of them.
+		unsigned shift;             // 32 minus log2 of slots.size()
+		int count;
+
+		// Fibonacci hashing: the top bits of the product spread
+		// consecutive pages over the table.
+		unsigned Home( PageID pid ) const { return ((unsigned)pid * 2654435761u) >> shift; }
+		unsigned Next( unsigned i ) const { return (i + 1) & (unsigned)(slots.size() - 1); }
+};
+
+inline int PageTable::Find( PageID pid ) const
+{
+	if (pid == INVALID_PAGE) return INVALID_FRAME;
+
+	for (unsigned i = Home(pid); ; i = Next(i)) {
+		if (slots[i].pid == pid) return slots[i].frame;
+		if (slots[i].pid == INVALID_PAGE) return INVALID_FRAME;
+	}
+}
+
+#endif // _PAGE_TABLE_H
@@ -2,6 +2,13 @@
 #ifndef _REPLACER_H_
 #define _REPLACER_H_
 
+#include <string>
+#include <utility>
+#include <vector>
+
+// Named figures a replacer reports about itself, e.g. ("candidates", 12).
+typedef std::vector< std::pair<std::string, double> > ReplacerStats;
+
 class Replacer {
 
 public:
@@ -17,8 +24,16 @@ public:
 	// This function removes frame from the list of candidates to be replaced.
 	virtual void RemoveFrame(int frameId) = 0;
 
+	// This function removes frame because its page is leaving the pool,
+	// flushed or freed, rather than being pinned.  The default is
+	// RemoveFrame.
+	virtual void DropFrame(int frameId);
+
+	// This function appends the replacer's own figures to stats.  The
+	// default reports nothing.
+	virtual void GetStats(ReplacerStats& stats) const;
 
 	virtual ~Replacer() = 0;
 };
 
-#endif // _REPLACER
\ No newline at end of file
+#endif // _REPLACER
\ No newline at end of file
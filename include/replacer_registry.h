@@ -0,0 +1,62 @@
+#ifndef _REPLACER_REGISTRY_H
+#define _REPLACER_REGISTRY_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "minirel.h"
+#include "replacer.h"
+
+// Parameters of a replacement policy, parsed from the part of a policy
+// spec after the colon: "lru-k:k=3" or "clock:hands=2,gap=16".
+class ReplacerParams
+{
+	public:
+
+		// Parse "name=value,name=value".  Returns false on a malformed
+		// list.
+		bool Parse(const std::string& text);
+
+		// The value of an integer parameter, or def if it was not given.
+		// Sets ok to false if it was given but is not an integer.
+		int GetInt(const char* name, int def, bool& ok);
+		double GetDouble(const char* name, double def, bool& ok);
+
+		// The name of a parameter that no Get call asked for, or NULL.
+		const char* FirstUnused() const;
+
+	private:
+
+		std::map<std::string, std::string> values;
+		std::set<std::string> used;
+};
+
+// Makes a replacer from its parameters; returns NULL if a parameter is out
+// of range.
+typedef Replacer* (*ReplacerFactory)(ReplacerParams& params);
+
+// The replacement policies that can be named in a spec, such as the one
+// given to the BufMgr constructor.  LRU, MRU, CLOCK and LRU-K are built in;
+// names are not case sensitive.
+class ReplacerRegistry
+{
+	public:
+
+		// Add a policy.  Returns false if the name is taken.
+		static bool Register(const char* name, ReplacerFactory factory,
+		                     const char* description);
+
+		// Make a replacer from a spec "name" or "name:params".  An
+		// unknown name or a bad parameter is an error.
+		static Replacer* Create(const char* spec, Status& status);
+
+		// Print the known policies.
+		static void List(std::ostream& out);
+
+		// The names of the known policies, in lower case.
+		static void GetNames(std::vector<std::string>& names);
+};
+
+#endif // _REPLACER_REGISTRY_H
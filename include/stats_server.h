@@ -0,0 +1,55 @@
+#ifndef _STATS_SERVER_H
+#define _STATS_SERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "minirel.h"
+#include "buf_stats.h"
+
+// A minimal HTTP server on 127.0.0.1 that serves the last published
+// BufStats: GET /metrics in the Prometheus text format, GET /stats as
+// JSON.  It answers from its own thread and never touches the buffer
+// pool; the pool's owner calls Publish (BufMgr does so as it runs), so
+// the pool itself needs no locking.
+class StatsServer
+{
+	public:
+
+		StatsServer();
+		~StatsServer();
+
+		// Listen on port (0 picks a free one, see GetPort).  Fails with
+		// STATS_SERVER_ERROR if the port cannot be bound.
+		Status Start(int port);
+		void Stop();
+		bool IsRunning() const { return running; }
+		int GetPort() const { return port; }
+
+		// Replace the snapshot being served.
+		void Publish(const BufStats& stats);
+
+	private:
+
+		// A SOCKET or a file descriptor; -1 if none.
+		intptr_t listener;
+		int port;
+		bool running;
+		std::atomic<bool> stopping;
+		std::thread worker;
+
+		std::mutex docLock;		// guards the two documents
+		std::string json;
+		std::string prometheus;
+
+		void Serve();
+		void Answer(intptr_t client);
+
+		StatsServer(const StatsServer&);
+		StatsServer& operator=(const StatsServer&);
+};
+
+#endif // _STATS_SERVER_H
@@ -0,0 +1,164 @@
+#ifndef _STORAGE_H
+#define _STORAGE_H
+
+#include <mutex>
+#include <vector>
+
+#include "minirel.h"
+
+// Where a database keeps its bytes.  The DB reads and writes byte ranges
+// at given offsets and never touches a file itself, so the same database
+// can live in an ordinary file, in a file opened for direct I/O, or in
+// memory.  The kind is chosen in DBOptions when the database is created;
+// an existing database is always opened as a file.
+enum StorageKind {
+    FILE_STORAGE,       // an ordinary file, through the OS page cache
+    DIRECT_STORAGE,     // a file opened to bypass the OS page cache
+    MEMORY_STORAGE      // a buffer in memory, gone when the DB is closed
+};
+
+// How Storage::Open finds the store.  A new store starts out empty, even
+// if there was one of the same name; a temporary one is also removed when
+// it is closed, or as soon as it is opened where the platform allows a
+// file to outlive its name.
+enum StorageMode {
+    STORE_EXISTING,     // open the store that is there
+    STORE_NEW,          // create the store, and keep it once closed
+    STORE_TEMPORARY     // create the store, and remove it once closed
+};
+
+// The storage primitives.  Every call is safe from any thread; an offset is
+// part of each call, so there is no shared file position to race on.
+// Errors are DBMGR errors.
+class Storage
+{
+	public:
+
+		// A closed storage of the given kind.
+		static Storage* Create( StorageKind kind );
+
+		// The kind named "file", "direct" or "memory".
+		static bool ParseKind( const char* name, StorageKind& kind );
+
+		virtual ~Storage() {}
+
+		// Open the named store as mode says.
+		virtual Status Open( const char* name, StorageMode mode ) = 0;
+		virtual void Close() = 0;
+
+		// Read or write length bytes at offset.  A read past the end of the
+		// store is an error; a write past it extends the store.
+		virtual Status Read( long long offset, void* buf, unsigned length ) = 0;
+		virtual Status Write( long long offset, const void* buf, unsigned length ) = 0;
+
+		// Make every completed write durable.
+		virtual Status Sync() = 0;
+
+		// Make the store at least size bytes long.  New bytes read as zero.
+		virtual Status Allocate( long long size ) = 0;
+
+		// Whether anything is left of the store once it is closed.
+		virtual bool IsPersistent() const { return true; }
+
+	protected:
+
+		Storage() {}
+
+	private:
+
+		Storage( const Storage& );
+		Storage& operator=( const Storage& );
+};
+
+// An ordinary file.  On POSIX systems every transfer is a pread or pwrite,
+// so threads never wait on each other here; the Windows C runtime has only
+// the shared file position, so there each call seeks and transfers under
+// a lock.
+class FileStorage : public Storage
+{
+	public:
+
+		FileStorage() : fd(-1) {}
+		~FileStorage() { Close(); }
+
+		Status Open( const char* name, StorageMode mode );
+		void Close();
+		Status Read( long long offset, void* buf, unsigned length );
+		Status Write( long long offset, const void* buf, unsigned length );
+		Status Sync();
+		Status Allocate( long long size );
+
+		// Rename the file from to to, replacing any file named to, so that
+		// a reader finds either the old file or the new one complete.
+		static Status Replace( const char* from, const char* to );
+
+	protected:
+
+		int fd;
+
+		// Transfer length bytes at offset, retrying short transfers.
+		// ReadAt returns the bytes read, fewer at the end of the file, or
+		// -1 on an error.
+		long long ReadAt( void* buf, unsigned length, long long offset );
+		bool WriteAt( const void* buf, unsigned length, long long offset );
+
+		// The length of the file, or -1.
+		long long Size();
+
+#ifdef _WIN32
+		std::mutex seekLock;    // Guards the file position.
+#endif
+};
+
+// A file read and written around the OS page cache (O_DIRECT, F_NOCACHE,
+// or FILE_FLAG_NO_BUFFERING), so that every page the buffer pool misses
+// really goes to the device.  Such a file only moves whole aligned blocks
+// to and from aligned memory.  A transfer that is aligned already goes
+// straight to the file; anything else goes through a bounce buffer, and a
+// partial block is read, patched and written back.
+class DirectStorage : public FileStorage
+{
+	public:
+
+		static const unsigned BLOCK_SIZE = 4096;
+
+		DirectStorage() : block(NULL), blockSize(0) {}
+		~DirectStorage();
+
+		Status Open( const char* name, StorageMode mode );
+		Status Read( long long offset, void* buf, unsigned length );
+		Status Write( long long offset, const void* buf, unsigned length );
+		Status Allocate( long long size );
+
+	private:
+
+		char* block;            // Aligned bounce buffer of blockSize bytes.
+		unsigned blockSize;
+		std::mutex blockLock;   // Guards block.
+
+		// Make block at least length bytes long; blockLock must be held.
+		bool Reserve( unsigned length );
+};
+
+// A buffer in memory.  It grows as it is written and is freed on Close.
+class MemoryStorage : public Storage
+{
+	public:
+
+		MemoryStorage() {}
+
+		Status Open( const char* name, StorageMode mode );
+		void Close();
+		Status Read( long long offset, void* buf, unsigned length );
+		Status Write( long long offset, const void* buf, unsigned length );
+		Status Sync() { return OK; }
+		Status Allocate( long long size );
+		bool IsPersistent() const { return false; }
+
+	private:
+
+		std::vector<char> bytes;
+		std::mutex lock;        // Guards bytes, which Write may move.
+};
+
+#endif // _STORAGE_H
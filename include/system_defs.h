@@ -15,6 +15,7 @@
 class BufMgr;
 class DB;
 class Catalog;
+struct DBOptions;
 
 #define MINIBASE_MAXARRSIZE 50
 
@@ -22,16 +23,19 @@ class SystemDefs {
 
   public:
     SystemDefs( Status& status, const char* dbname, unsigned dbpages =0,
-                unsigned bufpoolsize =0, const char* replacement_policy =0 );
+                unsigned bufpoolsize =0, const char* replacement_policy =0,
+                const DBOptions* db_options =0 );
       /* This constructor uses a default log name and size, for multi-user
          Minibase.  For single-user Minibase, this is the designated
          constructor.  If "dbpages" is 0, the database is opened; if it is
-         greater than 0, the database is created with that number of pages. */
+         greater than 0, the database is created with that number of pages.
+         "db_options", if given, applies when the database is created. */
 
 
     SystemDefs( Status& status, const char* dbname, const char* logname,
                 unsigned dbpages, unsigned maxlogsize,
-                unsigned bufpoolsize =0, const char* replacement_policy =0 );
+                unsigned bufpoolsize =0, const char* replacement_policy =0,
+                const DBOptions* db_options =0 );
       /* This constructor lets you specify all aspects of the system. */
 
 
@@ -59,7 +63,8 @@ class SystemDefs {
   protected:
     void init( Status& status, const char* dbname, const char* logname,
                unsigned dbpages, unsigned maxlogsize,
-               unsigned bufpoolsize, const char* replacement_policy );
+               unsigned bufpoolsize, const char* replacement_policy,
+               const DBOptions* db_options );
 };
 
 extern SystemDefs *minibase_globals;
@@ -32,6 +32,15 @@ protected:
     virtual int Test5();
     virtual int Test6();
 	virtual int Test7();
+	virtual int Test8();
+	virtual int Test9();
+	virtual int Test10();
+	virtual int Test11();
+	virtual int Test12();
+	virtual int Test13();
+	virtual int Test14();
+	virtual int Test15();
+	virtual int Test16();
 
       // ...and this method, which is printed as the kind of test being done,
       // for example "Disk Space Management".
@@ -0,0 +1,87 @@
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#include <stdio.h>
+#include <vector>
+
+// The buffer manager calls a trace records.
+enum TraceEventType {
+	TRACE_PIN,          // PinPage(pid)
+	TRACE_UNPIN,        // UnpinPage(pid)
+	TRACE_NEW,          // NewPage; pid is the first page, pinned
+	TRACE_FREE,         // FreePage(pid)
+	TRACE_FLUSH,        // FlushPage(pid)
+	TRACE_FLUSH_ALL,    // FlushAllPages; pid is INVALID_PAGE
+	NUM_TRACE_EVENT_TYPES
+};
+
+// Bits of TraceEvent::flags.
+enum TraceFlags {
+	TRACE_DIRTY  = 1,   // UnpinPage with dirty set
+	TRACE_EMPTY  = 2,   // PinPage with isEmpty set
+	TRACE_FAILED = 4    // the call did not return OK
+};
+
+// One event, as stored in a trace file (16 bytes, in the byte order of
+// the machine that wrote it).
+struct TraceEvent {
+	unsigned long long time;    // ticks; see TraceHeader
+	int pid;
+	unsigned short thread;      // threads are numbered from 0 in the order
+	                            // of their first event
+	unsigned char type;         // a TraceEventType
+	unsigned char flags;        // TraceFlags
+};
+
+// The start of a trace file.  The events follow it.
+struct TraceHeader {
+	char magic[4];                  // "MBTR"
+	unsigned version;
+	unsigned eventSize;             // sizeof(TraceEvent)
+	unsigned numThreads;
+	unsigned long long startTicks;  // when the trace started
+	double nsPerTick;
+};
+
+#define TRACE_MAGIC "MBTR"
+#define TRACE_VERSION 1
+
+// Reads a trace file written by TraceRecorder.  Events of one thread are
+// in the order they happened.  Events of different threads are sorted by
+// time within each batch the recorder wrote, so they may be slightly out
+// of order across batches; ReadAll sorts them.
+class TraceReader
+{
+	public:
+
+		TraceReader();
+		~TraceReader();
+
+		// Open path and check its header.  Returns false if the file
+		// cannot be read or is not a trace.
+		bool Open(const char* path);
+		void Close();
+
+		// Read the next event.  Returns false at the end of the trace.
+		bool Next(TraceEvent& event);
+
+		// Read the rest of the events, sorted by time.
+		void ReadAll(std::vector<TraceEvent>& events);
+
+		const TraceHeader& GetHeader() const { return header; }
+
+		// Nanoseconds from the start of the trace to an event.
+		double ToNs(const TraceEvent& event) const;
+
+		static const char* TypeName(int type);
+
+	private:
+
+		FILE* file;
+		TraceHeader header;
+
+		TraceReader(const TraceReader&);
+		TraceReader& operator=(const TraceReader&);
+};
+
+#endif // _TRACE_H
@@ -0,0 +1,87 @@
+#ifndef _TRACE_RECORDER_H
+#define _TRACE_RECORDER_H
+
+#include <stdio.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "minirel.h"
+#include "trace.h"
+
+// Records buffer manager calls to a trace file (see trace.h) for offline
+// study, e.g. replaying them against other policies.
+//
+// Each thread appends its events to its own ring buffer, with no locks
+// and no shared cache lines; a background thread drains the rings every
+// millisecond and writes them out.  A thread whose ring is full waits for
+// the writer rather than drop events, since a trace with holes cannot be
+// replayed; GetNumStalls tells how often that happened.
+class TraceRecorder
+{
+	public:
+
+		TraceRecorder();
+		~TraceRecorder();
+
+		// Start a new trace in path.  Fails with TRACE_FILE_ERROR if the
+		// file cannot be created or a trace is already running.
+		Status Start(const char* path);
+
+		// Write out what is left and close the file.  No thread may be
+		// recording.  Fails with TRACE_FILE_ERROR if any write failed.
+		Status Stop();
+
+		bool IsRecording() const { return file != NULL; }
+
+		void Record(TraceEventType type, int pid, int flags = 0);
+
+		long long GetNumEvents() const { return numWritten; }
+		long long GetNumStalls() const { return numStalls; }
+
+	private:
+
+		// 1 MB of events per thread, enough for some milliseconds of
+		// calls while the writer sleeps or waits on the disk.
+		enum { RING_SIZE = 1 << 16, DRAIN_MS = 1 };
+
+		// A single-producer, single-consumer ring.  The owning thread
+		// advances head, the writer advances tail.  The owner keeps the
+		// last tail it read in tailSeen, and reads tail again only when
+		// the ring looks full, so it seldom touches the writer's line.
+		struct Ring {
+			TraceEvent events[RING_SIZE];
+			std::thread::id owner;
+			unsigned short thread;
+			unsigned long long tailSeen;
+			std::atomic<unsigned long long> head;
+			char pad[64];
+			std::atomic<unsigned long long> tail;
+		};
+
+		FILE* file;
+		bool writeFailed;
+		unsigned serial;
+		unsigned long long startTicks;
+		double startSeconds;
+
+		std::mutex ringLock;		// guards rings
+		std::vector<Ring*> rings;
+
+		std::thread writer;
+		std::atomic<bool> stopping;
+		std::vector<TraceEvent> batch;	// the writer's
+		std::atomic<long long> numWritten;
+		std::atomic<long long> numStalls;
+
+		Ring* MyRing();
+		void Write();
+		bool Drain();
+		void WriteHeader();
+
+		TraceRecorder(const TraceRecorder&);
+		TraceRecorder& operator=(const TraceRecorder&);
+};
+
+#endif // _TRACE_RECORDER_H
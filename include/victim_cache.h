@@ -0,0 +1,52 @@
+
+#ifndef _VICTIM_CACHE_H_
+#define _VICTIM_CACHE_H_
+
+#include "page.h"
+
+// A cache tier below the buffer pool.  The BufMgr asks it on every pool
+// miss before reading from the DB, and offers it every evicted page that it
+// does not already hold.  The tier is inclusive: a page stays cached while
+// it is in the pool, so evicting a clean page again costs nothing.  The
+// pool invalidates a cached page whenever it writes a newer version to the
+// DB or frees the page, so what the tier holds always matches the DB.
+class VictimCache {
+
+public:
+
+	VictimCache();
+
+	// If pid is cached, copy it into page and return true.  Otherwise
+	// return false.
+	virtual bool Lookup(PageID pid, Page* page) = 0;
+
+	// Whether a copy of pid is cached.  Does not count as a lookup.
+	virtual bool Contains(PageID pid) = 0;
+
+	// Offer a copy of page pid, just evicted from the pool and identical
+	// to the page on disk.  The cache may decline it.
+	virtual void Put(PageID pid, const Page* page) = 0;
+
+	// Forget any copies of the count pages from first; their contents on
+	// disk are changing or they have been deallocated.  Costs no more than
+	// looking up each page or scanning the cache, whichever is less.
+	virtual void Invalidate(PageID first, int count = 1) = 0;
+
+	virtual void PrintStat() = 0;
+
+	long GetNumLookups() const;
+	long GetNumHits() const;
+	void ResetStat();
+
+	virtual ~VictimCache() = 0;
+
+protected:
+
+	long numLookups;	// Lookup calls
+	long numHits;		// Lookup calls that found the page
+	long numPuts;		// pages accepted by Put
+	long numDeclined;	// pages offered to Put and not accepted
+	long numEvictions;	// pages dropped to make room
+};
+
+#endif // _VICTIM_CACHE_H_
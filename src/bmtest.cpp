@@ -7,7 +7,13 @@
 #include <assert.h>
 #include <conio.h>
 #include <time.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <utility>
 #include "bufmgr.h"
+#include "compressed_cache.h"
+#include "file_cache.h"
 #include "db.h"
 #include "bmtest.h"
 
@@ -327,12 +333,12 @@ int BMTester::Test3()
 int BMTester::Test4()
 {	//
 	//  A test on relation between buffer size and pinpage request miss/hit.
+	//  For timings, see "BufMgrBench bufmgr".
 	//
 	Page* pg;
 	PageID pid;
 	Status status;
 	int data, times;
-	clock_t initTime, endTime;
 
 	cout << "\n  Test 4 tests relation between buffer size and pinpage request miss/hit:\n";
 
@@ -350,9 +356,6 @@ int BMTester::Test4()
 	// Allocating Pages
 	//
 	
-	// Record the initial running time 
-	initTime = clock();
-
 	// Start to collect statistics
 	MINIBASE_BM->ResetStat();
 
@@ -418,10 +421,6 @@ int BMTester::Test4()
 	
 	MINIBASE_BM->FlushAllPages();
 
-    				     
-	// record the end time
-	endTime = clock();
-
     for (int index=0; index < numPages; index++ )
     {
 		pid = pids[index];
@@ -437,8 +436,6 @@ int BMTester::Test4()
     }
 
 	
-	cout << "  - The running time for above operation is " << (endTime - initTime)*(1000.0/CLOCKS_PER_SEC) <<"ms\n";
-	
 	cout << "  - Starting to print Statistics \n";
 	// Start to print statistics
 	MINIBASE_BM->PrintStat();
@@ -457,12 +454,12 @@ int BMTester::Test5()
 {
 	//
 	//  A test on locality.
+	//  For timings, see "BufMgrBench bufmgr".
 	//
 	Page* pg;
 	PageID pid;
 	Status status;
 	int data, times;
-	clock_t initTime, endTime;
 
 	cout << "\n  Test 5 tests locality\n";
 
@@ -481,9 +478,6 @@ int BMTester::Test5()
 	// Allocating Pages
 	//
 	
-	// Record the initial running time 
-	initTime = clock();
-
 	// Start to collect statistics
 	MINIBASE_BM->ResetStat();
 	
@@ -552,9 +546,6 @@ int BMTester::Test5()
 	}
 
 	MINIBASE_BM->FlushAllPages();
-    				     
-	// record the end time
-	endTime = clock();
 
     for (int index=0; index < numPages; index++ )
     {
@@ -569,8 +560,6 @@ int BMTester::Test5()
     }
 
 
-	cout << "  - The running time for above operation is " << (endTime - initTime)*(1000.0/CLOCKS_PER_SEC) <<"ms\n";
-	
 	cout << "  - Starting to print Statistics \n";
 	// Start to print statistics
 	MINIBASE_BM->PrintStat();
@@ -582,6 +571,1431 @@ int BMTester::Test5()
     return true;
 }
 
+int BMTester::Test6()
+{
+	//
+	//  A test on the free-extent index used by DB::AllocatePage.
+	//
+	PageID firstPid, pid;
+	Status status;
+
+	cout << "\n  Test 6 exercises the free-extent index of the database:\n";
+
+	const int runSize = 40;
+
+	MINIBASE_DB->SetAllocPolicy(FIRST_FIT);
+
+	cout << "  - Allocate a run of " << runSize << " pages and punch two holes in it\n";
+	status = MINIBASE_DB->AllocatePage( firstPid, runSize );
+	if ( status != OK )
+	{
+		cerr << "*** Could not allocate " << runSize << " pages in the database.\n";
+		return false;
+	}
+
+	int freePages = MINIBASE_DB->GetNumFreePages();
+	int freeExtents = MINIBASE_DB->GetNumFreeExtents();
+	int largestRun = MINIBASE_DB->GetLargestFreeRun();
+
+	// A hole of 3 pages at firstPid+5 and one of 2 pages at firstPid+20.
+	if ( status == OK )
+		status = MINIBASE_DB->DeallocatePage( firstPid + 5, 3 );
+	if ( status == OK )
+		status = MINIBASE_DB->DeallocatePage( firstPid + 20, 2 );
+
+	if ( status == OK && (MINIBASE_DB->GetNumFreePages() != freePages + 5
+		|| MINIBASE_DB->GetNumFreeExtents() != freeExtents + 2
+		|| MINIBASE_DB->GetLargestFreeRun() != largestRun) )
+	{
+		status = FAIL;
+		cerr << "*** The free-extent index does not reflect the two holes.\n";
+	}
+
+	cout << "  - Best-fit should consume a 3-page hole exactly\n";
+	if ( status == OK )
+	{
+		MINIBASE_DB->SetAllocPolicy(BEST_FIT);
+		status = MINIBASE_DB->AllocatePage( pid, 3 );
+		if ( status == OK && MINIBASE_DB->GetNumFreeExtents() != freeExtents + 1 )
+		{
+			status = FAIL;
+			cerr << "*** Best-fit allocation of 3 pages split a larger run.\n";
+		}
+		if ( status == OK )
+			status = MINIBASE_DB->DeallocatePage( pid, 3 );
+	}
+
+	cout << "  - First-fit should take the lowest hole that fits\n";
+	if ( status == OK )
+	{
+		MINIBASE_DB->SetAllocPolicy(FIRST_FIT);
+		status = MINIBASE_DB->AllocatePage( pid, 2 );
+		if ( status == OK && pid > firstPid + 5 )
+		{
+			status = FAIL;
+			cerr << "*** First-fit allocation of 2 pages skipped a lower hole.\n";
+		}
+		if ( status == OK )
+			status = MINIBASE_DB->DeallocatePage( pid, 2 );
+	}
+
+	cout << "  - Free the whole run; its extents should coalesce\n";
+	Status freeStatus = MINIBASE_DB->DeallocatePage( firstPid, runSize );
+	if ( status == OK && freeStatus != OK )
+		status = freeStatus;
+
+	if ( status == OK && (MINIBASE_DB->GetNumFreePages() != freePages + runSize
+		|| MINIBASE_DB->GetNumFreeExtents() > freeExtents + 1) )
+	{
+		status = FAIL;
+		cerr << "*** Freed pages did not coalesce into one extent.\n";
+	}
+
+	MINIBASE_DB->SetAllocPolicy(NEXT_FIT);
+
+	cout << "  - Free pages: " << MINIBASE_DB->GetNumFreePages()
+		 << ", free extents: " << MINIBASE_DB->GetNumFreeExtents()
+		 << ", largest free run: " << MINIBASE_DB->GetLargestFreeRun() << "\n";
+
+	if ( status == OK )
+		cout << "  Test 6 completed successfully.\n";
+
+	cout << "  Press any key to continue." << endl;
+	getch();
+
+	return status == OK;
+}
+
+int BMTester::Test7()
+{
+	//
+	//  A test on the file directory kept in the database header pages.
+	//
+	Status status = OK;
+	PageID pid;
+	char fname[MAX_NAME];
+
+	cout << "\n  Test 7 exercises the file directory of the database:\n";
+
+	// Enough entries to need several directory pages.
+	const int numFiles = 300;
+	const int numPages = MINIBASE_DB->GetNumOfPages();
+
+	cout << "  - Add " << numFiles << " file entries\n";
+	for ( int i = 0; status == OK && i < numFiles; i++ )
+	{
+		sprintf( fname, "test7-file-%d", i );
+		status = MINIBASE_DB->AddFileEntry( fname, 1 + i % (numPages - 1) );
+		if ( status != OK )
+			cerr << "*** Could not add file entry " << fname << endl;
+	}
+
+	if ( status == OK )
+	{
+		cout << "  - Try to add a duplicate entry\n";
+		status = MINIBASE_DB->AddFileEntry( "test7-file-7", 1 );
+		TestFailure( status, DBMGR, "Adding a duplicate file entry" );
+	}
+
+	cout << "  - Look the entries up\n";
+	for ( int i = 0; status == OK && i < numFiles; i++ )
+	{
+		sprintf( fname, "test7-file-%d", i );
+		status = MINIBASE_DB->GetFileEntry( fname, pid );
+		if ( status != OK )
+			cerr << "*** Could not find file entry " << fname << endl;
+		else if ( pid != 1 + i % (numPages - 1) )
+		{
+			status = FAIL;
+			cerr << "*** Wrong start page for file entry " << fname << endl;
+		}
+	}
+
+	cout << "  - Delete every other entry and add them back\n";
+	for ( int i = 0; status == OK && i < numFiles; i += 2 )
+	{
+		sprintf( fname, "test7-file-%d", i );
+		status = MINIBASE_DB->DeleteFileEntry( fname );
+		if ( status == OK && MINIBASE_DB->GetFileEntry( fname, pid ) == OK )
+		{
+			status = FAIL;
+			cerr << "*** Deleted file entry " << fname << " is still found\n";
+		}
+	}
+	for ( int i = 0; status == OK && i < numFiles; i += 2 )
+	{
+		sprintf( fname, "test7-file-%d", i );
+		status = MINIBASE_DB->AddFileEntry( fname, 1 );
+		if ( status == OK )
+			status = MINIBASE_DB->GetFileEntry( fname, pid );
+		if ( status == OK && pid != 1 )
+			status = FAIL;
+		if ( status != OK )
+			cerr << "*** Could not re-add file entry " << fname << endl;
+	}
+
+	cout << "  - Delete all the entries\n";
+	for ( int i = 0; i < numFiles; i++ )
+	{
+		sprintf( fname, "test7-file-%d", i );
+		Status delStatus = MINIBASE_DB->DeleteFileEntry( fname );
+		if ( status == OK && delStatus != OK )
+		{
+			status = delStatus;
+			cerr << "*** Error deleting file entry " << fname << endl;
+		}
+	}
+
+	if ( status == OK )
+	{
+		status = MINIBASE_DB->DeleteFileEntry( "test7-file-0" );
+		TestFailure( status, DBMGR, "Deleting a missing file entry" );
+	}
+
+	if ( status == OK )
+		cout << "  Test 7 completed successfully.\n";
+
+	cout << "  Press any key to continue." << endl;
+	getch();
+
+	return status == OK;
+}
+
+int BMTester::Test8()
+{
+	//
+	//  A test on the page checksums stamped and verified by the frames.
+	//
+	Status status;
+	PageID pid;
+	Page* pg;
+	Page image;
+	const char* text = "A page for test 8";
+
+	cout << "\n  Test 8 exercises the page checksums:\n";
+
+	cout << "  - Write a page and check the checksum it has on disk\n";
+	status = MINIBASE_BM->NewPage( pid, pg );
+	if ( status != OK )
+	{
+		cerr << "*** Could not allocate a new page in the database.\n";
+		return false;
+	}
+	strcpy( (char*)pg, text );
+	status = MINIBASE_BM->UnpinPage( pid, true );
+
+	// FlushPage also drops the page from the pool, so the next pin reads
+	// it from disk.
+	if ( status == OK )
+		status = MINIBASE_BM->FlushPage( pid );
+	if ( status == OK )
+		status = MINIBASE_DB->ReadPage( pid, &image );
+	if ( status == OK && !image.ChecksumOK() )
+	{
+		status = FAIL;
+		cerr << "*** Page " << pid << " was written without a valid checksum.\n";
+	}
+
+	unsigned numUnpinned = MINIBASE_BM->GetNumOfUnpinnedFrames();
+
+	cout << "  - Corrupt the page on disk and try to pin it\n";
+	if ( status == OK )
+	{
+		((char*)&image)[strlen(text) + 1] ^= 1;
+		status = MINIBASE_DB->WritePage( pid, &image );
+	}
+	if ( status == OK )
+	{
+		status = MINIBASE_BM->PinPage( pid, pg );
+		TestFailure( status, BUFMGR, "Pinning a page with a bad checksum" );
+	}
+	if ( status == OK && MINIBASE_BM->GetNumOfUnpinnedFrames() != numUnpinned )
+	{
+		status = FAIL;
+		cerr << "*** The failed pin left a frame in use.\n";
+	}
+
+	cout << "  - Pin it again with checksums turned off\n";
+	if ( status == OK )
+	{
+		MINIBASE_BM->SetPageChecksums( false );
+		status = MINIBASE_BM->PinPage( pid, pg );
+		MINIBASE_BM->SetPageChecksums( true );
+		if ( status != OK )
+			cerr << "*** Could not pin page " << pid << " without its checksum.\n";
+		else
+		{
+			if ( strcmp( (char*)pg, text ) != 0 )
+			{
+				status = FAIL;
+				cerr << "*** Page " << pid << " did not hold what was written to it.\n";
+			}
+			Status st2 = MINIBASE_BM->UnpinPage( pid );
+			if ( status == OK )
+				status = st2;
+			if ( status == OK )
+				status = MINIBASE_BM->FlushPage( pid );
+		}
+	}
+
+	cout << "  - Repair the page on disk and pin it\n";
+	if ( status == OK )
+	{
+		((char*)&image)[strlen(text) + 1] ^= 1;
+		status = MINIBASE_DB->WritePage( pid, &image );
+	}
+	if ( status == OK )
+	{
+		status = MINIBASE_BM->PinPage( pid, pg );
+		if ( status != OK )
+			cerr << "*** Could not pin the repaired page " << pid << endl;
+		else
+		{
+			if ( strcmp( (char*)pg, text ) != 0 )
+			{
+				status = FAIL;
+				cerr << "*** Page " << pid << " did not hold what was written to it.\n";
+			}
+			MINIBASE_BM->UnpinPage( pid );
+		}
+	}
+
+	Status freeStatus = MINIBASE_BM->FreePage( pid );
+	if ( status == OK && freeStatus != OK )
+	{
+		status = freeStatus;
+		cerr << "*** Error freeing page " << pid << endl;
+	}
+
+	if ( status == OK )
+		cout << "  Test 8 completed successfully.\n";
+
+	cout << "  Press any key to continue." << endl;
+	getch();
+
+	return status == OK;
+}
+
+// Fill the usable part of page pid with what version v of it holds: a
+// run of one byte, which compresses well, or noise, which does not,
+// alternating with pid and v.
+static void FillPage( Page* pg, PageID pid, int v )
+{
+	char* data = (char*)pg;
+	if ( (pid + v) % 2 == 0 )
+		memset( data, 'a' + (pid + v) % 26, MAX_SPACE );
+	else
+	{
+		unsigned seed = pid * 7919 + v;
+		for ( int i = 0; i < MAX_SPACE; i++ )
+		{
+			seed = seed * 1103515245 + 12345;
+			data[i] = (char)(seed >> 16);
+		}
+	}
+	sprintf( data, "page %d version %d", pid, v );
+}
+
+static bool PageHolds( Page* pg, PageID pid, int v )
+{
+	Page expected;
+	FillPage( &expected, pid, v );
+	return memcmp( pg, &expected, MAX_SPACE ) == 0;
+}
+
+// Free the n pages from firstPid on, and return the first error.
+static Status FreePages( PageID firstPid, int n )
+{
+	Status status = OK;
+	for ( PageID pid = firstPid; pid < firstPid + n; pid++ )
+	{
+		Status st2 = MINIBASE_BM->FreePage( pid );
+		if ( status == OK && st2 != OK )
+		{
+			status = st2;
+			cerr << "*** Error freeing page " << pid << endl;
+		}
+	}
+	return status;
+}
+
+// Allocate n new pages from firstPid on and write version 0 of each,
+// leaving them unpinned.  On an error the pages are freed again.
+static Status WritePages( PageID& firstPid, int n )
+{
+	Page* pg;
+	Status status = MINIBASE_BM->NewPage( firstPid, pg, n );
+	if ( status != OK )
+	{
+		cerr << "*** Could not allocate " << n << " new pages in the database.\n";
+		return status;
+	}
+	for ( PageID pid = firstPid; status == OK && pid < firstPid + n; pid++ )
+	{
+		if ( pid != firstPid )
+			status = MINIBASE_BM->PinPage( pid, pg, true );
+		if ( status == OK )
+		{
+			FillPage( pg, pid, 0 );
+			status = MINIBASE_BM->UnpinPage( pid, true );
+		}
+		if ( status != OK )
+			cerr << "*** Could not write page " << pid << endl;
+	}
+	if ( status != OK )
+		FreePages( firstPid, n );
+	return status;
+}
+
+int BMTester::Test9()
+{
+	//
+	//  A test on a compressed database.  It gets a SystemDefs of its
+	//  own, with a pool small enough that its pages are read back from
+	//  disk, and MINIBASE_DB and MINIBASE_BM point to it until the end.
+	//
+	Status status;
+	PageID firstPid, pid;
+	Page* pg;
+	char zname[200];
+	DBOptions options;
+
+	cout << "\n  Test 9 exercises a compressed database:\n";
+
+	const int numFrames = 10;
+	const int numPages = 4 * numFrames;
+
+	sprintf( zname, "%s-compressed", dbpath );
+	options.compress = true;
+
+	SystemDefs* saved = minibase_globals;
+	SystemDefs* zdefs = new SystemDefs( status, zname, 200, numFrames, "Clock", &options );
+
+	cout << "  - Write " << numPages << " pages, half of them incompressible\n";
+	if ( status == OK && !MINIBASE_DB->IsCompressed() )
+	{
+		status = FAIL;
+		cerr << "*** The database was not created compressed.\n";
+	}
+	if ( status == OK )
+		status = WritePages( firstPid, numPages );
+
+	// Every page changes between compressible and not, so it needs an
+	// extent of a different size.
+	cout << "  - Read them back and rewrite each one\n";
+	for ( pid = firstPid; status == OK && pid < firstPid + numPages; pid++ )
+	{
+		status = MINIBASE_BM->PinPage( pid, pg );
+		if ( status == OK )
+		{
+			if ( !PageHolds( pg, pid, 0 ) )
+			{
+				status = FAIL;
+				cerr << "*** Page " << pid << " did not hold what was written to it.\n";
+			}
+			FillPage( pg, pid, 1 );
+			Status st2 = MINIBASE_BM->UnpinPage( pid, true );
+			if ( status == OK )
+				status = st2;
+		}
+		else
+			cerr << "*** Could not pin page " << pid << endl;
+	}
+
+	cout << "  - Close the database, reopen it and read the pages\n";
+	delete zdefs;
+	zdefs = NULL;
+	if ( status == OK )
+	{
+		zdefs = new SystemDefs( status, zname, 0, numFrames, "Clock" );
+		if ( status != OK )
+			cerr << "*** Could not reopen the compressed database.\n";
+	}
+	if ( status == OK && !MINIBASE_DB->IsCompressed() )
+	{
+		status = FAIL;
+		cerr << "*** The database was not reopened compressed.\n";
+	}
+	for ( pid = firstPid; status == OK && pid < firstPid + numPages; pid++ )
+	{
+		status = MINIBASE_BM->PinPage( pid, pg );
+		if ( status == OK )
+		{
+			if ( !PageHolds( pg, pid, 1 ) )
+			{
+				status = FAIL;
+				cerr << "*** Page " << pid << " did not survive the reopen.\n";
+			}
+			Status st2 = MINIBASE_BM->UnpinPage( pid );
+			if ( status == OK )
+				status = st2;
+		}
+		else
+			cerr << "*** Could not pin page " << pid << " after the reopen.\n";
+	}
+
+	delete zdefs;
+	minibase_globals = saved;
+
+	strcat( zname, ".pagemap" );
+	remove( zname );
+	zname[strlen(zname) - strlen(".pagemap")] = '\0';
+	remove( zname );
+
+	if ( status == OK )
+		cout << "  Test 9 completed successfully.\n";
+
+	cout << "  Press any key to continue." << endl;
+	getch();
+
+	return status == OK;
+}
+
+// Put cache under the pool and run numPages pages, more than the pool
+// holds, through it: write them, then read every page and write its next
+// version, twice.  The cache must be big enough for all of them and the
+// DB's own pages besides; then no read may go to disk, and a read must
+// never see an older version.
+static Status RunPagesThroughCache( VictimCache* cache, int numPages )
+{
+	PageID firstPid, pid;
+	Page* pg;
+
+	MINIBASE_BM->SetVictimCache( cache );
+
+	Status status = WritePages( firstPid, numPages );
+	if ( status != OK )
+	{
+		MINIBASE_BM->SetVictimCache( NULL );
+		return status;
+	}
+
+	for ( int v = 0; status == OK && v < 2; v++ )
+	{
+		long hits = cache->GetNumHits();
+		long long reads = MINIBASE_BM->GetStats().diskReads;
+
+		for ( pid = firstPid; status == OK && pid < firstPid + numPages; pid++ )
+		{
+			status = MINIBASE_BM->PinPage( pid, pg );
+			if ( status != OK )
+			{
+				cerr << "*** Could not pin page " << pid << endl;
+				break;
+			}
+			if ( !PageHolds( pg, pid, v ) )
+			{
+				status = FAIL;
+				cerr << "*** Page " << pid << " did not hold version " << v << " of it.\n";
+			}
+			FillPage( pg, pid, v + 1 );
+			Status st2 = MINIBASE_BM->UnpinPage( pid, true );
+			if ( status == OK )
+				status = st2;
+		}
+
+		if ( status == OK && MINIBASE_BM->GetStats().diskReads != reads )
+		{
+			status = FAIL;
+			cerr << "*** Pages the victim cache held were read from disk.\n";
+		}
+		if ( status == OK && cache->GetNumHits() == hits )
+		{
+			status = FAIL;
+			cerr << "*** The victim cache served none of the pool's misses.\n";
+		}
+	}
+
+	Status st2 = FreePages( firstPid, numPages );
+	if ( status == OK )
+		status = st2;
+
+	MINIBASE_BM->SetVictimCache( NULL );
+	return status;
+}
+
+int BMTester::Test10()
+{
+	//
+	//  A test on the compressed victim cache, on its own and under the
+	//  pool.
+	//
+	Status status = OK;
+	Page pages[6], copy;
+
+	cout << "\n  Test 10 exercises the compressed victim cache:\n";
+
+	// Page i of pages is page i of the database, version 0; the odd ones
+	// are noise.
+	for ( int i = 0; i < 6; i++ )
+		FillPage( &pages[i], i, 0 );
+
+	CompressedCache* cache = new CompressedCache( 2 * MINIBASE_PAGESIZE + MINIBASE_PAGESIZE / 2 );
+
+	cout << "  - Put pages in the cache and look them up\n";
+	cache->Put( 2, &pages[2] );
+	if ( cache->GetBytesUsed() >= MINIBASE_PAGESIZE / 2 )
+	{
+		status = FAIL;
+		cerr << "*** A page of one repeated byte was not compressed.\n";
+	}
+	cache->Put( 1, &pages[1] );
+	if ( status == OK && (!cache->Contains( 1 ) || !cache->Contains( 2 ) || cache->Contains( 3 )) )
+	{
+		status = FAIL;
+		cerr << "*** The cache does not hold the pages put in it.\n";
+	}
+	for ( int i = 1; status == OK && i <= 2; i++ )
+		if ( !cache->Lookup( i, &copy ) || memcmp( &copy, &pages[i], MAX_SPACE ) != 0 )
+		{
+			status = FAIL;
+			cerr << "*** Page " << i << " did not come back from the cache as it was put.\n";
+		}
+	if ( status == OK && (cache->Lookup( 3, &copy ) || cache->GetNumHits() != 2) )
+	{
+		status = FAIL;
+		cerr << "*** The cache counted its lookups wrong.\n";
+	}
+
+	cout << "  - Invalidate a range of pages\n";
+	if ( status == OK )
+	{
+		cache->Invalidate( 0, 2 );
+		if ( cache->Contains( 1 ) || !cache->Contains( 2 ) || cache->Lookup( 1, &copy ) )
+		{
+			status = FAIL;
+			cerr << "*** Invalidate dropped the wrong pages.\n";
+		}
+	}
+
+	cout << "  - Overflow the cache's budget\n";
+	if ( status == OK )
+	{
+		// Only two of the noise pages fit, and page 3 is used least
+		// recently once page 1 is looked up.
+		cache->Put( 1, &pages[1] );
+		cache->Put( 3, &pages[3] );
+		cache->Lookup( 1, &copy );
+		cache->Put( 5, &pages[5] );
+		if ( cache->GetBytesUsed() > 2 * MINIBASE_PAGESIZE + MINIBASE_PAGESIZE / 2
+			 || cache->Contains( 2 ) || cache->Contains( 3 )
+			 || !cache->Contains( 1 ) || !cache->Contains( 5 ) )
+		{
+			status = FAIL;
+			cerr << "*** The cache did not drop its least recently used page.\n";
+		}
+	}
+	delete cache;
+
+	const int numPages = MINIBASE_BM->GetNumFrames() + 10;
+
+	cout << "  - Run " << numPages << " pages through the pool with the cache under it\n";
+	if ( status == OK )
+		status = RunPagesThroughCache( new CompressedCache( 2 * numPages * MINIBASE_PAGESIZE ), numPages );
+
+	if ( status == OK )
+		cout << "  Test 10 completed successfully.\n";
+
+	cout << "  Press any key to continue." << endl;
+	getch();
+
+	return status == OK;
+}
+
+int BMTester::Test11()
+{
+	//
+	//  A test on the victim cache kept in a file, on its own and under
+	//  the pool.
+	//
+	Status status;
+	Page pages[6], copy;
+	char cname[200];
+
+	cout << "\n  Test 11 exercises the file victim cache:\n";
+
+	for ( int i = 0; i < 6; i++ )
+		FillPage( &pages[i], i, 0 );
+
+	sprintf( cname, "%s-cache", dbpath );
+	FileCache* cache = new FileCache( cname, 4, status );
+	if ( status != OK )
+		cerr << "*** Could not create the cache file " << cname << endl;
+
+	cout << "  - A page is admitted the second time it is offered\n";
+	if ( status == OK )
+	{
+		cache->Put( 1, &pages[1] );
+		if ( cache->Contains( 1 ) )
+		{
+			status = FAIL;
+			cerr << "*** The cache admitted a page offered once.\n";
+		}
+		cache->Put( 1, &pages[1] );
+		if ( status == OK && !cache->Contains( 1 ) )
+		{
+			status = FAIL;
+			cerr << "*** The cache did not admit a page offered twice.\n";
+		}
+	}
+
+	cout << "  - Put pages in the cache and look them up\n";
+	if ( status == OK )
+	{
+		cache->SetAdmitAll( true );
+		cache->Put( 2, &pages[2] );
+		cache->Put( 3, &pages[3] );
+		for ( int i = 1; status == OK && i <= 3; i++ )
+			if ( !cache->Lookup( i, &copy ) || memcmp( &copy, &pages[i], MAX_SPACE ) != 0 )
+			{
+				status = FAIL;
+				cerr << "*** Page " << i << " did not come back from the cache as it was put.\n";
+			}
+	}
+
+	cout << "  - Invalidate a range of pages\n";
+	if ( status == OK )
+	{
+		cache->Invalidate( 2, 2 );
+		if ( !cache->Contains( 1 ) || cache->Contains( 2 ) || cache->Contains( 3 )
+			 || cache->Lookup( 2, &copy ) )
+		{
+			status = FAIL;
+			cerr << "*** Invalidate dropped the wrong pages.\n";
+		}
+	}
+
+	cout << "  - Offer more pages than the file has slots for\n";
+	for ( int i = 0; status == OK && i < 6; i++ )
+		cache->Put( i, &pages[i] );
+	if ( status == OK && cache->GetNumPages() != 4 )
+	{
+		status = FAIL;
+		cerr << "*** The cache holds " << cache->GetNumPages() << " pages in 4 slots.\n";
+	}
+	for ( int i = 0; status == OK && i < 6; i++ )
+		if ( cache->Contains( i )
+			 && (!cache->Lookup( i, &copy ) || memcmp( &copy, &pages[i], MAX_SPACE ) != 0) )
+		{
+			status = FAIL;
+			cerr << "*** Page " << i << " came back from a recycled slot changed.\n";
+		}
+	delete cache;
+
+	const int numPages = MINIBASE_BM->GetNumFrames() + 10;
+
+	cout << "  - Run " << numPages << " pages through the pool with the cache under it\n";
+	if ( status == OK )
+	{
+		cache = new FileCache( cname, 2 * numPages, status );
+		if ( status != OK )
+		{
+			cerr << "*** Could not create the cache file " << cname << endl;
+			delete cache;
+		}
+		else
+		{
+			cache->SetAdmitAll( true );
+			status = RunPagesThroughCache( cache, numPages );
+		}
+	}
+
+	if ( status == OK )
+		cout << "  Test 11 completed successfully.\n";
+
+	cout << "  Press any key to continue." << endl;
+	getch();
+
+	return status == OK;
+}
+
+int BMTester::Test12()
+{
+	//
+	//  A test on replacement policy specs, and on changing the policy of
+	//  a pool in use.
+	//
+	Status status = OK;
+	PageID firstPid, pid;
+	Page* pg;
+	Page* pinned[2];
+
+	cout << "\n  Test 12 exercises the replacement policy registry:\n";
+
+	const std::string policy = MINIBASE_BM->GetReplacementPolicy();
+
+	const char* badSpecs[] = { "no-such-policy", "lru-k:k=0", "lru-k:k=two",
+	                           "clock:hands=3", "lru:k=2", "clock:hands" };
+	const char* goodSpecs[] = { "MRU", "clock:hands=2,gap=8", "lru-k:k=3", "Lru" };
+
+	cout << "  - Try to switch to policies that do not exist or are misspecified\n";
+	for ( int i = 0; status == OK && i < 6; i++ )
+	{
+		status = MINIBASE_BM->SetReplacementPolicy( badSpecs[i] );
+		TestFailure( status, BUFMGR, badSpecs[i] );
+		if ( status == OK && policy != MINIBASE_BM->GetReplacementPolicy() )
+		{
+			status = FAIL;
+			cerr << "*** A rejected spec changed the policy to "
+				 << MINIBASE_BM->GetReplacementPolicy() << endl;
+		}
+	}
+
+	if ( status != OK )
+		return false;
+
+	const int numPages = MINIBASE_BM->GetNumFrames() + 5;
+
+	status = WritePages( firstPid, numPages );
+	if ( status != OK )
+		return false;
+
+	// Two pages stay pinned across the switches.
+	for ( int i = 0; status == OK && i < 2; i++ )
+		status = MINIBASE_BM->PinPage( firstPid + i, pinned[i] );
+
+	cout << "  - Switch policies while pages are pinned, and use each one\n";
+	for ( int i = 0; status == OK && i < 4; i++ )
+	{
+		unsigned numUnpinned = MINIBASE_BM->GetNumOfUnpinnedFrames();
+
+		status = MINIBASE_BM->SetReplacementPolicy( goodSpecs[i] );
+		if ( status != OK )
+		{
+			cerr << "*** Could not switch to " << goodSpecs[i] << endl;
+			break;
+		}
+		if ( strcmp( MINIBASE_BM->GetReplacementPolicy(), goodSpecs[i] ) != 0
+			 || MINIBASE_BM->GetNumOfUnpinnedFrames() != numUnpinned )
+		{
+			status = FAIL;
+			cerr << "*** The switch to " << goodSpecs[i] << " lost track of the pool.\n";
+		}
+
+		// More pages than frames, so the new policy picks victims.
+		for ( pid = firstPid + 2; status == OK && pid < firstPid + numPages; pid++ )
+		{
+			status = MINIBASE_BM->PinPage( pid, pg );
+			if ( status != OK )
+				cerr << "*** Could not pin page " << pid << " under " << goodSpecs[i] << endl;
+			else
+			{
+				if ( !PageHolds( pg, pid, 0 ) )
+				{
+					status = FAIL;
+					cerr << "*** Page " << pid << " did not hold what was written to it.\n";
+				}
+				Status st2 = MINIBASE_BM->UnpinPage( pid );
+				if ( status == OK )
+					status = st2;
+			}
+		}
+
+		for ( int j = 0; status == OK && j < 2; j++ )
+			if ( !PageHolds( pinned[j], firstPid + j, 0 ) )
+			{
+				status = FAIL;
+				cerr << "*** Pinned page " << firstPid + j << " changed under " << goodSpecs[i] << endl;
+			}
+	}
+
+	Status st2 = MINIBASE_BM->SetReplacementPolicy( policy.c_str() );
+	if ( status == OK && st2 != OK )
+	{
+		status = st2;
+		cerr << "*** Could not switch back to " << policy << endl;
+	}
+
+	st2 = FreePages( firstPid, numPages );
+	if ( status == OK )
+		status = st2;
+
+	if ( status == OK )
+		cout << "  Test 12 completed successfully.\n";
+
+	cout << "  Press any key to continue." << endl;
+	getch();
+
+	return status == OK;
+}
+
+int BMTester::Test13()
+{
+	//
+	//  A test on growing and shrinking the pool while pages are pinned.
+	//
+	Status status;
+	PageID firstPid, pid;
+	Page* pinned[3];
+	Page image;
+
+	cout << "\n  Test 13 exercises resizing the buffer pool:\n";
+
+	const int numFrames = MINIBASE_BM->GetNumFrames();
+	const int numPages = numFrames;
+
+	cout << "  - Fill the pool with dirty pages and pin three of them\n";
+	status = WritePages( firstPid, numPages );
+	if ( status != OK )
+		return false;
+
+	// Pages earlier tests left pinned count with ours.
+	const int numPinned = numFrames - MINIBASE_BM->GetNumOfUnpinnedFrames() + 3;
+
+	for ( int i = 0; status == OK && i < 3; i++ )
+		status = MINIBASE_BM->PinPage( firstPid + i, pinned[i] );
+
+	cout << "  - Double the pool\n";
+	if ( status == OK )
+	{
+		status = MINIBASE_BM->Resize( 2 * numFrames );
+		if ( status != OK )
+			cerr << "*** Could not grow the pool to " << 2 * numFrames << " frames.\n";
+		else if ( MINIBASE_BM->GetNumFrames() != 2 * numFrames
+				  || MINIBASE_BM->GetNumOfUnpinnedFrames() != (unsigned)(2 * numFrames - numPinned) )
+		{
+			status = FAIL;
+			cerr << "*** The grown pool has " << MINIBASE_BM->GetNumFrames() << " frames, "
+				 << MINIBASE_BM->GetNumOfUnpinnedFrames() << " of them unpinned.\n";
+		}
+	}
+
+	cout << "  - Shrink it to the pinned pages\n";
+	if ( status == OK )
+	{
+		status = MINIBASE_BM->Resize( numPinned );
+		if ( status != OK )
+			cerr << "*** Could not shrink the pool to " << numPinned << " frames.\n";
+		else if ( MINIBASE_BM->GetNumFrames() != numPinned || MINIBASE_BM->GetNumOfUnpinnedFrames() != 0 )
+		{
+			status = FAIL;
+			cerr << "*** The shrunk pool has " << MINIBASE_BM->GetNumFrames() << " frames, "
+				 << MINIBASE_BM->GetNumOfUnpinnedFrames() << " of them unpinned.\n";
+		}
+	}
+	for ( int i = 0; status == OK && i < 3; i++ )
+		if ( !PageHolds( pinned[i], firstPid + i, 0 ) )
+		{
+			status = FAIL;
+			cerr << "*** Pinned page " << firstPid + i << " moved or changed.\n";
+		}
+
+	// The pages that lost their frames were dirty, so they must have been
+	// written back on the way out.
+	for ( pid = firstPid + 3; status == OK && pid < firstPid + numPages; pid++ )
+	{
+		status = MINIBASE_DB->ReadPage( pid, &image );
+		if ( status == OK && !PageHolds( &image, pid, 0 ) )
+		{
+			status = FAIL;
+			cerr << "*** Page " << pid << " was not written back when its frame was removed.\n";
+		}
+	}
+
+	cout << "  - Try to shrink it below the number of pinned pages\n";
+	if ( status == OK )
+	{
+		status = MINIBASE_BM->Resize( numPinned - 1 );
+		TestFailure( status, FAIL, "Shrinking the pool below its pinned pages" );
+		if ( status == OK && MINIBASE_BM->GetNumFrames() != numPinned )
+		{
+			status = FAIL;
+			cerr << "*** The failed shrink left " << MINIBASE_BM->GetNumFrames() << " frames.\n";
+		}
+	}
+
+	Status st2 = MINIBASE_BM->Resize( numFrames );
+	if ( status == OK && st2 != OK )
+	{
+		status = st2;
+		cerr << "*** Could not grow the pool back to " << numFrames << " frames.\n";
+	}
+
+	st2 = FreePages( firstPid, numPages );
+	if ( status == OK )
+		status = st2;
+
+	if ( status == OK )
+		cout << "  Test 13 completed successfully.\n";
+
+	cout << "  Press any key to continue." << endl;
+	getch();
+
+	return status == OK;
+}
+
+int BMTester::Test14()
+{
+	//
+	//  A test on PageGuard: moving pins between guards, and switching
+	//  between read and write intent.
+	//
+	Status status = OK;
+	PageID pidA, pidB;
+	Page* pg;
+	Page image;
+
+	cout << "\n  Test 14 exercises page guards:\n";
+
+	status = MINIBASE_BM->NewPage( pidA, pg, 2 );
+	if ( status != OK )
+	{
+		cerr << "*** Could not allocate 2 new pages in the database.\n";
+		return false;
+	}
+	pidB = pidA + 1;
+	FillPage( pg, pidA, 0 );
+	status = MINIBASE_BM->UnpinPage( pidA, true );
+	if ( status == OK )
+		status = MINIBASE_BM->PinPage( pidB, pg, true );
+	if ( status == OK )
+	{
+		FillPage( pg, pidB, 0 );
+		status = MINIBASE_BM->UnpinPage( pidB, true );
+	}
+
+	unsigned numUnpinned = MINIBASE_BM->GetNumOfUnpinnedFrames();
+
+	cout << "  - Pin a page into a guard and move it to another\n";
+	PageGuard g1, g2, g3;
+	if ( status == OK )
+		status = MINIBASE_BM->PinPage( pidA, g1 );
+	if ( status == OK && (!g1.IsValid() || g1.GetPageID() != pidA || g1.GetIntent() != PIN_READ
+						  || g1.IsDirty() || !PageHolds( g1.GetPage(), pidA, 0 )
+						  || MINIBASE_BM->GetNumOfUnpinnedFrames() != numUnpinned - 1) )
+	{
+		status = FAIL;
+		cerr << "*** The guard does not hold page " << pidA << " for reading.\n";
+	}
+	if ( status == OK )
+	{
+		PageGuard moved( std::move( g1 ) );
+		g2 = std::move( moved );
+		if ( g1.IsValid() || moved.IsValid() || !g2.IsValid() || g2.GetPageID() != pidA
+			 || MINIBASE_BM->GetNumOfUnpinnedFrames() != numUnpinned - 1 )
+		{
+			status = FAIL;
+			cerr << "*** Moving the guard did not move its pin.\n";
+		}
+	}
+
+	cout << "  - Move a pin onto a guard that holds another page\n";
+	if ( status == OK )
+		status = MINIBASE_BM->PinPage( pidB, g3 );
+	if ( status == OK )
+	{
+		g3 = std::move( g2 );
+		if ( g2.IsValid() || g3.GetPageID() != pidA
+			 || MINIBASE_BM->GetNumOfUnpinnedFrames() != numUnpinned - 1 )
+		{
+			status = FAIL;
+			cerr << "*** The guard did not let go of page " << pidB << " when it was reassigned.\n";
+		}
+	}
+
+	cout << "  - Upgrade the guard, change the page and downgrade it\n";
+	if ( status == OK )
+	{
+		if ( !g3.Upgrade() )
+		{
+			status = FAIL;
+			cerr << "*** The only reader of a page could not upgrade in place.\n";
+		}
+		else if ( g3.GetIntent() != PIN_WRITE || !g3.IsDirty() )
+		{
+			status = FAIL;
+			cerr << "*** The upgraded guard does not mean to write.\n";
+		}
+		FillPage( g3.GetPage(), pidA, 1 );
+		g3.Downgrade();
+		if ( status == OK && (g3.GetIntent() != PIN_READ || !g3.IsDirty()) )
+		{
+			status = FAIL;
+			cerr << "*** The downgraded guard forgot that the page changed.\n";
+		}
+	}
+
+	if ( status == OK )
+	{
+		status = g3.Release();
+		if ( status == OK && (g3.IsValid() || g3.Release() != OK
+							  || MINIBASE_BM->GetNumOfUnpinnedFrames() != numUnpinned) )
+		{
+			status = FAIL;
+			cerr << "*** Releasing the guard did not unpin page " << pidA << " once.\n";
+		}
+	}
+
+	// The page was released dirty, so the flush must write it.
+	if ( status == OK )
+		status = MINIBASE_BM->FlushPage( pidA );
+	if ( status == OK )
+		status = MINIBASE_DB->ReadPage( pidA, &image );
+	if ( status == OK && !PageHolds( &image, pidA, 1 ) )
+	{
+		status = FAIL;
+		cerr << "*** The change made through the guard did not reach disk.\n";
+	}
+
+	cout << "  - Let a guard that meant to write go out of scope\n";
+	if ( status == OK )
+	{
+		PageGuard g;
+		status = MINIBASE_BM->PinPage( pidB, g, PIN_WRITE );
+		if ( status == OK )
+			FillPage( g.GetPage(), pidB, 1 );
+	}
+	if ( status == OK && MINIBASE_BM->GetNumOfUnpinnedFrames() != numUnpinned )
+	{
+		status = FAIL;
+		cerr << "*** The guard did not unpin page " << pidB << " when it went away.\n";
+	}
+	if ( status == OK )
+		status = MINIBASE_BM->FlushPage( pidB );
+	if ( status == OK )
+		status = MINIBASE_DB->ReadPage( pidB, &image );
+	if ( status == OK && !PageHolds( &image, pidB, 1 ) )
+	{
+		status = FAIL;
+		cerr << "*** The change made through the guard did not reach disk.\n";
+	}
+
+	g1.Release();
+	g2.Release();
+	g3.Release();
+	for ( PageID pid = pidA; pid <= pidB; pid++ )
+	{
+		Status st2 = MINIBASE_BM->FreePage( pid );
+		if ( status == OK && st2 != OK )
+		{
+			status = st2;
+			cerr << "*** Error freeing page " << pid << endl;
+		}
+	}
+
+	if ( status == OK )
+		cout << "  Test 14 completed successfully.\n";
+
+	cout << "  Press any key to continue." << endl;
+	getch();
+
+	return status == OK;
+}
+
+// What the second thread of Test 15 does: pin a page with the given
+// intent, note which version of it is there, write the next version if
+// it means to write, and let go.
+struct LatchProbe
+{
+	PageID pid;
+	PinIntent intent;
+	int version;			// the version found, or -1
+	std::atomic<bool> done;
+};
+
+static void ProbePage( LatchProbe* probe )
+{
+	PageGuard g;
+	probe->version = -1;
+	if ( MINIBASE_BM->PinPage( probe->pid, g, probe->intent ) == OK )
+	{
+		for ( int v = 0; v < 4; v++ )
+			if ( PageHolds( g.GetPage(), probe->pid, v ) )
+				probe->version = v;
+		if ( probe->intent == PIN_WRITE )
+			FillPage( g.GetPage(), probe->pid, probe->version + 1 );
+	}
+	g.Release();
+	probe->done = true;
+}
+
+// Start probe on a thread of its own.
+static std::thread StartProbe( LatchProbe& probe, PageID pid, PinIntent intent )
+{
+	probe.pid = pid;
+	probe.intent = intent;
+	probe.version = -1;
+	probe.done = false;
+	return std::thread( ProbePage, &probe );
+}
+
+// Whether probe finishes within ms milliseconds.
+static bool ProbeFinishes( LatchProbe& probe, int ms )
+{
+	for ( int waited = 0; !probe.done && waited < ms; waited++ )
+		std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+	return probe.done;
+}
+
+int BMTester::Test15()
+{
+	//
+	//  A test on the frame latches taken by page guards, with a second
+	//  thread pinning the page the test holds.
+	//
+	Status status;
+	PageID pid;
+	Page* pg;
+	PageGuard g;
+	LatchProbe probe;
+	std::thread probeThread;
+
+	cout << "\n  Test 15 exercises the frame latches:\n";
+
+	status = MINIBASE_BM->NewPage( pid, pg );
+	if ( status != OK )
+	{
+		cerr << "*** Could not allocate a new page in the database.\n";
+		return false;
+	}
+	FillPage( pg, pid, 0 );
+	status = MINIBASE_BM->UnpinPage( pid, true );
+
+	cout << "  - A second reader gets in while the page is read\n";
+	if ( status == OK )
+		status = MINIBASE_BM->PinPage( pid, g, PIN_READ );
+	if ( status == OK )
+	{
+		probeThread = StartProbe( probe, pid, PIN_READ );
+		if ( !ProbeFinishes( probe, 5000 ) )
+		{
+			status = FAIL;
+			cerr << "*** A reader waited for another reader.\n";
+		}
+		g.Release();
+		probeThread.join();
+		if ( status == OK && probe.version != 0 )
+		{
+			status = FAIL;
+			cerr << "*** The second reader did not find the page as written.\n";
+		}
+	}
+
+	cout << "  - A reader waits while the page is written\n";
+	if ( status == OK )
+		status = MINIBASE_BM->PinPage( pid, g, PIN_WRITE );
+	if ( status == OK )
+	{
+		probeThread = StartProbe( probe, pid, PIN_READ );
+		if ( ProbeFinishes( probe, 100 ) )
+		{
+			status = FAIL;
+			cerr << "*** A reader got in while the page was held for writing.\n";
+		}
+		FillPage( g.GetPage(), pid, 1 );
+		g.Release();
+		probeThread.join();
+		if ( status == OK && probe.version != 1 )
+		{
+			status = FAIL;
+			cerr << "*** The reader did not see the change the writer made.\n";
+		}
+	}
+
+	cout << "  - A writer waits while the page is read\n";
+	if ( status == OK )
+		status = MINIBASE_BM->PinPage( pid, g, PIN_READ );
+	if ( status == OK )
+	{
+		probeThread = StartProbe( probe, pid, PIN_WRITE );
+		if ( ProbeFinishes( probe, 100 ) || !PageHolds( g.GetPage(), pid, 1 ) )
+		{
+			status = FAIL;
+			cerr << "*** A writer got in while the page was held for reading.\n";
+		}
+		g.Release();
+		probeThread.join();
+		if ( status == OK && probe.version != 1 )
+		{
+			status = FAIL;
+			cerr << "*** The writer did not find the page as it was left.\n";
+		}
+	}
+	if ( status == OK )
+		status = MINIBASE_BM->PinPage( pid, g, PIN_READ );
+	if ( status == OK && !PageHolds( g.GetPage(), pid, 2 ) )
+	{
+		status = FAIL;
+		cerr << "*** The change the second writer made was lost.\n";
+	}
+
+	// FlushAllPages fails while pages are pinned, but still writes them,
+	// except one held for writing.
+	Page image;
+	cout << "  - Flush the pool while the page is read, then written\n";
+	if ( status == OK )
+	{
+		MINIBASE_BM->FlushAllPages();
+		status = MINIBASE_DB->ReadPage( pid, &image );
+		if ( status == OK && !PageHolds( &image, pid, 2 ) )
+		{
+			status = FAIL;
+			cerr << "*** A dirty page held for reading was not written.\n";
+		}
+	}
+	if ( status == OK )
+	{
+		g.Upgrade();
+		FillPage( g.GetPage(), pid, 3 );
+		MINIBASE_BM->FlushAllPages();
+		status = MINIBASE_DB->ReadPage( pid, &image );
+		if ( status == OK && !PageHolds( &image, pid, 2 ) )
+		{
+			status = FAIL;
+			cerr << "*** A page held for writing was written.\n";
+		}
+	}
+
+	g.Release();
+	Status freeStatus = MINIBASE_BM->FreePage( pid );
+	if ( status == OK && freeStatus != OK )
+	{
+		status = freeStatus;
+		cerr << "*** Error freeing page " << pid << endl;
+	}
+
+	if ( status == OK )
+		cout << "  Test 15 completed successfully.\n";
+
+	cout << "  Press any key to continue." << endl;
+	getch();
+
+	return status == OK;
+}
+
+int BMTester::Test16()
+{
+	//
+	//  A test on pinning and unpinning pages in batches.
+	//
+	Status status;
+	PageID firstPid;
+
+	cout << "\n  Test 16 exercises batches of pins:\n";
+
+	// One page more than there are frames to spare.
+	const unsigned numUnpinned = MINIBASE_BM->GetNumOfUnpinnedFrames();
+	const int numPages = numUnpinned + 1;
+
+	// The batches below need five distinct pages.
+	if ( numPages < 5 )
+	{
+		cerr << "*** Only " << numUnpinned << " frames are unpinned; the test needs 4.\n";
+		return false;
+	}
+
+	status = WritePages( firstPid, numPages );
+	if ( status != OK )
+		return false;
+
+	PageID* pids = new PageID[numPages];
+	Page** pages = new Page*[numPages];
+
+	cout << "  - Pin a batch of pages, some of them twice\n";
+	const int mid = numPages / 2;
+	const int batch[6] = { 1, mid, 1, numPages - 1, 0, mid };
+	for ( int i = 0; i < 6; i++ )
+		pids[i] = firstPid + batch[i];
+	if ( status == OK )
+		status = MINIBASE_BM->PinPages( pids, 6, pages );
+	for ( int i = 0; status == OK && i < 6; i++ )
+		if ( pages[i] == NULL || !PageHolds( pages[i], pids[i], 0 ) )
+		{
+			status = FAIL;
+			cerr << "*** Entry " << i << " of the batch is not page " << pids[i] << endl;
+		}
+	if ( status == OK && MINIBASE_BM->GetNumOfUnpinnedFrames() != numUnpinned - 4 )
+	{
+		status = FAIL;
+		cerr << "*** The batch of 4 distinct pages left "
+			 << MINIBASE_BM->GetNumOfUnpinnedFrames() << " of " << numUnpinned << " frames unpinned.\n";
+	}
+
+	cout << "  - Try to unpin batches holding a page that is not pinned that often\n";
+	if ( status == OK )
+	{
+		PageID notPinned[2] = { firstPid + 1, firstPid + numPages - 2 };
+		status = MINIBASE_BM->UnpinPages( notPinned, 2 );
+		TestFailure( status, FAIL, "Unpinning a batch with an unpinned page" );
+	}
+	if ( status == OK )
+	{
+		PageID tooOften[3] = { firstPid + 1, firstPid + 1, firstPid + 1 };
+		status = MINIBASE_BM->UnpinPages( tooOften, 3 );
+		TestFailure( status, FAIL, "Unpinning a page more often than it is pinned" );
+	}
+	if ( status == OK && MINIBASE_BM->GetNumOfUnpinnedFrames() != numUnpinned - 4 )
+	{
+		status = FAIL;
+		cerr << "*** A failed batch unpinned some of its pages.\n";
+	}
+
+	if ( status == OK )
+	{
+		status = MINIBASE_BM->UnpinPages( pids, 6 );
+		if ( status != OK )
+			cerr << "*** Could not unpin the batch.\n";
+		else if ( MINIBASE_BM->GetNumOfUnpinnedFrames() != numUnpinned )
+		{
+			status = FAIL;
+			cerr << "*** Unpinning the batch did not free its frames.\n";
+		}
+	}
+
+	cout << "  - Try to pin more pages than there are frames\n";
+	for ( int i = 0; i < numPages; i++ )
+		pids[i] = firstPid + i;
+	BufStats before = MINIBASE_BM->GetStats();
+	if ( status == OK )
+	{
+		status = MINIBASE_BM->PinPages( pids, numPages, pages );
+		TestFailure( status, FAIL, "Pinning a batch bigger than the pool" );
+	}
+	for ( int i = 0; status == OK && i < numPages; i++ )
+		if ( pages[i] != NULL )
+		{
+			status = FAIL;
+			cerr << "*** The failed batch handed out page " << pids[i] << endl;
+		}
+	if ( status == OK )
+	{
+		BufStats after = MINIBASE_BM->GetStats();
+		if ( MINIBASE_BM->GetNumOfUnpinnedFrames() != numUnpinned
+			 || after.pinRequests != before.pinRequests || after.hits != before.hits )
+		{
+			status = FAIL;
+			cerr << "*** The failed batch left pins or counted them.\n";
+		}
+	}
+
+	cout << "  - Pin a batch as big as the pool\n";
+	if ( status == OK )
+		status = MINIBASE_BM->PinPages( pids, numPages - 1, pages );
+	for ( int i = 0; status == OK && i < numPages - 1; i++ )
+		if ( !PageHolds( pages[i], pids[i], 0 ) )
+		{
+			status = FAIL;
+			cerr << "*** Entry " << i << " of the batch is not page " << pids[i] << endl;
+		}
+	if ( status == OK )
+		status = MINIBASE_BM->UnpinPages( pids, numPages - 1 );
+
+	delete [] pids;
+	delete [] pages;
+
+	Status st2 = FreePages( firstPid, numPages );
+	if ( status == OK )
+		status = st2;
+
+	if ( status == OK )
+		cout << "  Test 16 completed successfully.\n";
+
+	cout << "  Press any key to continue." << endl;
+	getch();
+
+	return status == OK;
+}
+
 const char* BMTester::TestName()
 {
     return "Buffer Management";
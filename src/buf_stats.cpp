@@ -0,0 +1,290 @@
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+
+using namespace std;
+
+#include "buf_stats.h"
+#include "frame.h"
+
+
+// Identifiers for the latency operations in exported names, in LatencyOp
+// order.
+static const char* opKeys[NUM_LATENCY_OPS] = {
+	"pin_hit", "pin_miss", "eviction", "dirty_write", "db_read", "db_write",
+};
+
+// Quote s as a JSON string, or as a Prometheus label value; both escape
+// backslash, double quote and newline the same way.
+static void WriteQuoted(ostream& out, const string& s)
+{
+	out << '"';
+	for (size_t i = 0; i < s.size(); i++) {
+		char c = s[i];
+		if (c == '"' || c == '\\') out << '\\' << c;
+		else if (c == '\n') out << "\\n";
+		else if ((unsigned char)c < 0x20) out << ' ';
+		else out << c;
+	}
+	out << '"';
+}
+
+DBIOStats::DBIOStats()
+{
+	Counts* both[2] = { &reads, &writes };
+	for (int i = 0; i < 2; i++) {
+		Counts& c = *both[i];
+		c.calls = c.bytes = c.sequential = 0;
+		for (int b = 0; b < RUN_BUCKETS; b++) c.runs[b] = 0;
+		c.latency.count = 0;
+		c.latency.mean = c.latency.p50 = c.latency.p99 = c.latency.p999 = c.latency.max = 0;
+	}
+}
+
+static void WriteJsonCounts(ostream& out, const char* name, const DBIOStats::Counts& c)
+{
+	out << "    \"" << name << "\": {\"calls\": " << c.calls << ", \"bytes\": " << c.bytes
+		<< ", \"sequential\": " << c.sequential << ", \"runs\": {";
+	bool first = true;
+	for (int b = 0; b < DBIOStats::RUN_BUCKETS; b++) {
+		if (c.runs[b] == 0) continue;
+		out << (first ? "" : ", ") << "\"" << (1LL << b) << "\": " << c.runs[b];
+		first = false;
+	}
+	const LatencySummary& l = c.latency;
+	out << "},\n      \"latency_ns\": {\"count\": " << l.count << ", \"mean\": " << l.mean
+		<< ", \"p50\": " << l.p50 << ", \"p99\": " << l.p99 << ", \"p999\": " << l.p999
+		<< ", \"max\": " << l.max << "}}";
+}
+
+//--------------------------------------------------------------------
+// WritePrometheusIO
+//
+// Purpose  : Write the DB's I/O figures, each family for reads and then
+//            writes.  Runs are a histogram of their length in pages;
+//            every page is in one run, so the sum is the number of calls.
+//--------------------------------------------------------------------
+static void WritePrometheusIO(ostream& out, const DBIOStats& db)
+{
+	const char* ops[2] = { "read", "write" };
+	const DBIOStats::Counts* counts[2] = { &db.reads, &db.writes };
+
+	out << "# HELP minibase_db_io_calls_total Database page reads and writes.\n"
+		<< "# TYPE minibase_db_io_calls_total counter\n";
+	for (int i = 0; i < 2; i++)
+		out << "minibase_db_io_calls_total{op=\"" << ops[i] << "\"} " << counts[i]->calls << "\n";
+
+	out << "# HELP minibase_db_io_bytes_total Bytes the database storage moved.\n"
+		<< "# TYPE minibase_db_io_bytes_total counter\n";
+	for (int i = 0; i < 2; i++)
+		out << "minibase_db_io_bytes_total{op=\"" << ops[i] << "\"} " << counts[i]->bytes << "\n";
+
+	out << "# HELP minibase_db_io_sequential_total Reads and writes of the page after the previous one.\n"
+		<< "# TYPE minibase_db_io_sequential_total counter\n";
+	for (int i = 0; i < 2; i++)
+		out << "minibase_db_io_sequential_total{op=\"" << ops[i] << "\"} " << counts[i]->sequential << "\n";
+
+	out << "# HELP minibase_db_io_run_pages Lengths of runs of sequential pages.\n"
+		<< "# TYPE minibase_db_io_run_pages histogram\n";
+	for (int i = 0; i < 2; i++) {
+		string labels = string("op=\"") + ops[i] + "\"";
+		long long runs = 0;
+		for (int b = 0; b < DBIOStats::RUN_BUCKETS; b++) {
+			runs += counts[i]->runs[b];
+			out << "minibase_db_io_run_pages_bucket{" << labels << ",le=\"" << ((2LL << b) - 1) << "\"} "
+				<< runs << "\n";
+		}
+		out << "minibase_db_io_run_pages_bucket{" << labels << ",le=\"+Inf\"} " << runs << "\n"
+			<< "minibase_db_io_run_pages_sum{" << labels << "} " << counts[i]->calls << "\n"
+			<< "minibase_db_io_run_pages_count{" << labels << "} " << runs << "\n";
+	}
+
+	out << "# HELP minibase_db_io_latency_seconds Latency of database page reads and writes.\n"
+		<< "# TYPE minibase_db_io_latency_seconds summary\n";
+	for (int i = 0; i < 2; i++) {
+		string labels = string("op=\"") + ops[i] + "\"";
+		const LatencySummary& l = counts[i]->latency;
+		out << "minibase_db_io_latency_seconds{" << labels << ",quantile=\"0.5\"} " << l.p50 / 1e9 << "\n"
+			<< "minibase_db_io_latency_seconds{" << labels << ",quantile=\"0.99\"} " << l.p99 / 1e9 << "\n"
+			<< "minibase_db_io_latency_seconds{" << labels << ",quantile=\"0.999\"} " << l.p999 / 1e9 << "\n"
+			<< "minibase_db_io_latency_seconds_sum{" << labels << "} " << l.mean * l.count / 1e9 << "\n"
+			<< "minibase_db_io_latency_seconds_count{" << labels << "} " << l.count << "\n";
+	}
+}
+
+BufStats::BufStats()
+{
+	numFrames = pinnedFrames = dirtyFrames = freeFrames = 0;
+	pinRequests = hits = misses = 0;
+	cleanEvictions = dirtyEvictions = 0;
+	diskReads = diskWrites = 0;
+	victimLookups = victimHits = 0;
+	for (int op = 0; op < NUM_LATENCY_OPS; op++) {
+		Latency& l = latency[op];
+		l.count = 0;
+		l.mean = l.p50 = l.p99 = l.p999 = l.max = 0;
+	}
+}
+
+void BufStats::WriteJson(ostream& out) const
+{
+	ios::fmtflags flags = out.flags();
+	out << fixed << setprecision(1);
+
+	out << "{\n";
+	out << "  \"frames\": {\"total\": " << numFrames << ", \"pinned\": " << pinnedFrames
+		<< ", \"dirty\": " << dirtyFrames << ", \"free\": " << freeFrames << "},\n";
+	out << "  \"pins\": {\"requests\": " << pinRequests << ", \"hits\": " << hits
+		<< ", \"misses\": " << misses << "},\n";
+	out << "  \"evictions\": {\"clean\": " << cleanEvictions << ", \"dirty\": " << dirtyEvictions << "},\n";
+	out << "  \"io\": {\"reads\": " << diskReads << ", \"writes\": " << diskWrites << "},\n";
+	out << "  \"victim_cache\": {\"lookups\": " << victimLookups << ", \"hits\": " << victimHits << "},\n";
+
+	out << "  \"policy\": {\"name\": ";
+	WriteQuoted(out, policy);
+	for (size_t i = 0; i < policyStats.size(); i++) {
+		out << ", ";
+		WriteQuoted(out, policyStats[i].first);
+		out << ": " << policyStats[i].second;
+	}
+	out << "},\n";
+
+	out << "  \"latency_ns\": {";
+	for (int op = 0; op < NUM_LATENCY_OPS; op++) {
+		const Latency& l = latency[op];
+		out << (op ? ",\n" : "\n") << "    \"" << opKeys[op] << "\": {\"count\": " << l.count
+			<< ", \"mean\": " << l.mean << ", \"p50\": " << l.p50 << ", \"p99\": " << l.p99
+			<< ", \"p999\": " << l.p999 << ", \"max\": " << l.max << "}";
+	}
+	out << "\n  },\n";
+
+	out << "  \"db_io\": {\n";
+	WriteJsonCounts(out, "reads", db.reads);
+	out << ",\n";
+	WriteJsonCounts(out, "writes", db.writes);
+	out << "\n  },\n";
+
+	out << setprecision(4) << "  \"predicted_hit_ratio\": {";
+	for (size_t i = 0; i < predictedHitRatios.size(); i++)
+		out << (i ? ", " : "") << "\"" << predictedHitRatios[i].first << "\": " << predictedHitRatios[i].second;
+	out << "}\n";
+	out << "}\n";
+
+	out.flags(flags);
+}
+
+//--------------------------------------------------------------------
+// BufStats::WritePrometheus
+//
+// Purpose  : Write the snapshot in the Prometheus text exposition
+//            format.  Counters end in _total; latencies are a summary
+//            in seconds, labelled by operation.
+//--------------------------------------------------------------------
+void BufStats::WritePrometheus(ostream& out) const
+{
+	streamsize precision = out.precision();
+	out << setprecision(9);
+
+	out << "# HELP minibase_buf_frames Buffer pool frames by state.\n"
+		<< "# TYPE minibase_buf_frames gauge\n"
+		<< "minibase_buf_frames{state=\"total\"} " << numFrames << "\n"
+		<< "minibase_buf_frames{state=\"pinned\"} " << pinnedFrames << "\n"
+		<< "minibase_buf_frames{state=\"dirty\"} " << dirtyFrames << "\n"
+		<< "minibase_buf_frames{state=\"free\"} " << freeFrames << "\n";
+
+	out << "# HELP minibase_buf_pin_requests_total PinPage calls.\n"
+		<< "# TYPE minibase_buf_pin_requests_total counter\n"
+		<< "minibase_buf_pin_requests_total " << pinRequests << "\n"
+		<< "# HELP minibase_buf_pin_hits_total PinPage calls that found the page in the pool.\n"
+		<< "# TYPE minibase_buf_pin_hits_total counter\n"
+		<< "minibase_buf_pin_hits_total " << hits << "\n"
+		<< "# HELP minibase_buf_pin_misses_total PinPage calls that brought the page in.\n"
+		<< "# TYPE minibase_buf_pin_misses_total counter\n"
+		<< "minibase_buf_pin_misses_total " << misses << "\n";
+
+	out << "# HELP minibase_buf_evictions_total Pages evicted, by whether they were written back.\n"
+		<< "# TYPE minibase_buf_evictions_total counter\n"
+		<< "minibase_buf_evictions_total{kind=\"clean\"} " << cleanEvictions << "\n"
+		<< "minibase_buf_evictions_total{kind=\"dirty\"} " << dirtyEvictions << "\n";
+
+	out << "# HELP minibase_buf_disk_reads_total Pages read from the database.\n"
+		<< "# TYPE minibase_buf_disk_reads_total counter\n"
+		<< "minibase_buf_disk_reads_total " << diskReads << "\n"
+		<< "# HELP minibase_buf_disk_writes_total Pages written to the database.\n"
+		<< "# TYPE minibase_buf_disk_writes_total counter\n"
+		<< "minibase_buf_disk_writes_total " << diskWrites << "\n";
+
+	out << "# HELP minibase_buf_victim_cache_lookups_total Victim cache lookups.\n"
+		<< "# TYPE minibase_buf_victim_cache_lookups_total counter\n"
+		<< "minibase_buf_victim_cache_lookups_total " << victimLookups << "\n"
+		<< "# HELP minibase_buf_victim_cache_hits_total Victim cache lookups that found the page.\n"
+		<< "# TYPE minibase_buf_victim_cache_hits_total counter\n"
+		<< "minibase_buf_victim_cache_hits_total " << victimHits << "\n";
+
+	out << "# HELP minibase_buf_policy_info The replacement policy in use.\n"
+		<< "# TYPE minibase_buf_policy_info gauge\n"
+		<< "minibase_buf_policy_info{policy=";
+	WriteQuoted(out, policy);
+	out << "} 1\n";
+	out << "# HELP minibase_buf_policy Figures reported by the replacement policy.\n"
+		<< "# TYPE minibase_buf_policy gauge\n";
+	for (size_t i = 0; i < policyStats.size(); i++) {
+		out << "minibase_buf_policy{name=";
+		WriteQuoted(out, policyStats[i].first);
+		out << "} " << policyStats[i].second << "\n";
+	}
+
+	out << "# HELP minibase_buf_latency_seconds Latency of buffer manager operations.\n"
+		<< "# TYPE minibase_buf_latency_seconds summary\n";
+	for (int op = 0; op < NUM_LATENCY_OPS; op++) {
+		const Latency& l = latency[op];
+		string labels = string("op=\"") + opKeys[op] + "\"";
+		out << "minibase_buf_latency_seconds{" << labels << ",quantile=\"0.5\"} " << l.p50 / 1e9 << "\n"
+			<< "minibase_buf_latency_seconds{" << labels << ",quantile=\"0.99\"} " << l.p99 / 1e9 << "\n"
+			<< "minibase_buf_latency_seconds{" << labels << ",quantile=\"0.999\"} " << l.p999 / 1e9 << "\n"
+			<< "minibase_buf_latency_seconds_sum{" << labels << "} " << l.mean * l.count / 1e9 << "\n"
+			<< "minibase_buf_latency_seconds_count{" << labels << "} " << l.count << "\n";
+	}
+
+	WritePrometheusIO(out, db);
+
+	out << "# HELP minibase_buf_predicted_hit_ratio Estimated hit ratio of an LRU pool of this many frames.\n"
+		<< "# TYPE minibase_buf_predicted_hit_ratio gauge\n";
+	for (size_t i = 0; i < predictedHitRatios.size(); i++)
+		out << "minibase_buf_predicted_hit_ratio{frames=\"" << predictedHitRatios[i].first << "\"} "
+			<< predictedHitRatios[i].second << "\n";
+
+	out.precision(precision);
+}
+
+void BufStats::Write(ostream& out, StatsFormat format) const
+{
+	if (format == STATS_PROMETHEUS) WritePrometheus(out);
+	else WriteJson(out);
+}
+
+Status BufStats::Save(const char* path, StatsFormat format) const
+{
+	string tmp = string(path) + ".tmp";
+	{
+		ofstream out(tmp.c_str(), ios::out | ios::trunc);
+		if (!out) return MINIBASE_FIRST_ERROR(BUFMGR, STATS_FILE_ERROR);
+		Write(out, format);
+		out.flush();
+		if (!out) {
+			out.close();
+			remove(tmp.c_str());
+			return MINIBASE_FIRST_ERROR(BUFMGR, STATS_FILE_ERROR);
+		}
+	}
+
+#ifdef _WIN32
+	// rename does not replace an existing file here.
+	remove(path);
+#endif
+	if (rename(tmp.c_str(), path) != 0) {
+		remove(tmp.c_str());
+		return MINIBASE_FIRST_ERROR(BUFMGR, STATS_FILE_ERROR);
+	}
+	return OK;
+}
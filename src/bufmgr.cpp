@@ -1,32 +1,40 @@
+#include <chrono>
 
 #include "bufmgr.h"
-#include "frame.h"
 #include "lru.h"
-#include "mru.h"
+#include "replacer_registry.h"
+
+static const char* bufErrMsgs[] = {
+	"Page checksum mismatch",   // BAD_PAGE_CHECKSUM
+	"Cannot open the victim cache file",   // CACHE_FILE_ERROR
+	"Unknown replacement policy",   // UNKNOWN_REPLACER
+	"Bad replacement policy parameter",   // BAD_REPLACER_PARAM
+	"Cannot write the statistics file",   // STATS_FILE_ERROR
+	"Cannot start the statistics server",   // STATS_SERVER_ERROR
+	"Cannot write the trace file",   // TRACE_FILE_ERROR
+};
+
+static error_string_table bufTable( BUFMGR, bufErrMsgs );
 
 //--------------------------------------------------------------------
 // Constructor for BufMgr
 //
 // Input   : bufSize  - number of frames(pages) in the this buffer manager
-//           replacementPolicy - a replacement policy, either LRU or MRU            
-// Output  : None
+//           replacementPolicy - a replacement policy spec, see
+//                               ReplacerRegistry
+// Output  : status - OK, or the error from ReplacerRegistry::Create
 // PostCond: All frames are empty.
-//           the "replacer" is initiated to LRU or MRU according to the
-//           replacement policy.
+//           the "replacer" is created from the spec, or is LRU if
+//           the spec is bad and status says so.  There is no form
+//           without status: a bad spec must not go unnoticed.
 //--------------------------------------------------------------------
-BufMgr::BufMgr(int bufSize, const char* replacementPolicy)
+BufMgr::BufMgr(int bufSize, const char* replacementPolicy, Status& status) : pool(bufSize)
 {
-	numFrames = bufSize;
-	frames = new Frame [numFrames];
-	
-	if (strcmpi(replacementPolicy, "LRU") == 0) 
-		replacer = new LRU();
-	else
-		replacer = new MRU();
-
-	totalCall = 0;
-	totalHit = 0;
-	numDirtyPageWrites = 0;
+	pool.GetPolicy().Set(new LRU());
+	policySpec = "LRU";
+	statsServer = NULL;
+	trace = NULL;
+	status = SetReplacementPolicy(replacementPolicy);
 }
 
 //--------------------------------------------------------------------
@@ -34,369 +42,340 @@ BufMgr::BufMgr(int bufSize, const char* replacementPolicy)
 //
 // Input   : None
 // Output  : None
+// Note    : The pool flushes itself when it is destroyed.
 //--------------------------------------------------------------------
 BufMgr::~BufMgr()
 {   
-	FlushAllPages();
-	delete [] frames;
-	delete replacer;
+	delete statsServer;
+	delete trace;
 }
 
-//--------------------------------------------------------------------
-// BufMgr::PinPage
-//
-// Input    : pid     - page id of a particular page 
-//            isEmpty - (optional, default to false) if true indicate
-//                      that the page to be pinned is an empty page.
-// Output   : page - a pointer to a page in the buffer pool. (NULL
-//            if fail)
-// Purpose  : Pin the page with page id = pid to the buffer.  
-//            Read the page from disk unless isEmpty is true or unless
-//            the page is already in the buffer.
-// Condition: Either the page is already in the buffer, or there is at
-//            least one frame available in the buffer pool for the 
-//            page.
-// PostCond : The page with page id = pid resides in the buffer and 
-//            is pinned. The number of pin on the page increase by
-//            one.
-// Return   : OK if operation is successful.  FAIL otherwise.
-//--------------------------------------------------------------------
+// The rest of the interface is documented in buf_pool.h.
+
 Status BufMgr::PinPage(PageID pid, Page*& page, bool isEmpty)
 {
-	if(pid == INVALID_PAGE) return FAIL;
-
-	totalCall++;
-
-	// Check if the page is in the buffer pool
-	bool inPool = false;
-	Frame* currFrame;
-	for (int iter = 0; iter < numFrames; iter++) {
-		currFrame = &frames[iter];
-		if (currFrame->GetPageID() == pid){
-			inPool = true;
-			totalHit++;
-			break;
-		}
-	}
+	std::lock_guard<std::recursive_mutex> guard(poolLock);
+	Status status = pool.PinPage(pid, page, isEmpty);
+	if (trace) trace->Record(TRACE_PIN, pid, (isEmpty ? TRACE_EMPTY : 0) | (status != OK ? TRACE_FAILED : 0));
+	if (statsServer) PublishStatsIfDue();
+	return status;
+}
 
-	if (inPool){
-		// Increase its pin count and set output page pointer
-		currFrame->Pin();
-		page = currFrame->GetPage();
-	}
-	else {
-		
-		// Find the first free frame if there is one
-		bool foundEmptyFrame = false;
-		for (int iter = 0; iter < numFrames; iter++) {
-			currFrame = &frames[iter];
-			if (!currFrame->IsValid()){
-				foundEmptyFrame = true;
-				break;
-			}
-		}
-		
-		if (!foundEmptyFrame) {
-		
-			// Find a page to evict based on our replacement policy
-			int replacedPageID = replacer->PickVictim();
-
-			// Get a pointer to the frame we will flush
-			for (int iter = 0; iter < numFrames; iter++) {
-				currFrame = &frames[iter];
-				if (currFrame->GetPageID() == replacedPageID){
-					break;
-				}
-			}
-
-			if(FlushPage(replacedPageID) != OK) { 
-				page = NULL;
-				return FAIL;
-			}
-		}
-
-		currFrame->SetPageID(pid);
-		currFrame->Pin();
-
-		// If the page is not empty, read it in from disk
-		if (!isEmpty && currFrame->Read(pid) != OK) {
-			page = NULL;
-			return FAIL;
-		}
-		
-
-		page = currFrame->GetPage();
+Status BufMgr::UnpinPage(PageID pid, bool dirty)
+{
+	std::lock_guard<std::recursive_mutex> guard(poolLock);
+	Status status = pool.UnpinPage(pid, dirty);
+	if (trace) trace->Record(TRACE_UNPIN, pid, (dirty ? TRACE_DIRTY : 0) | (status != OK ? TRACE_FAILED : 0));
+	return status;
+}
+
+Status BufMgr::PinPages(const PageID* pids, int n, Page** pages)
+{
+	std::lock_guard<std::recursive_mutex> guard(poolLock);
+	Status status = pool.PinPages(pids, n, pages);
+	if (trace) {
+		for (int i = 0; i < n; i++)
+			trace->Record(TRACE_PIN, pids[i], status != OK ? TRACE_FAILED : 0);
 	}
+	if (statsServer) PublishStatsIfDue();
+	return status;
+}
 
-	// Now that the frame is pinned we need to remove it from the ones that can be evicted
-	replacer->RemoveFrame(currFrame->GetPageID());
-	////std::cout << "pinned page: " << currFrame->GetPageID() <<std::endl;
-	return OK;
-} 
+Status BufMgr::UnpinPages(const PageID* pids, int n, bool dirty)
+{
+	std::lock_guard<std::recursive_mutex> guard(poolLock);
+	Status status = pool.UnpinPages(pids, n, dirty);
+	if (trace) {
+		for (int i = 0; i < n; i++)
+			trace->Record(TRACE_UNPIN, pids[i], (dirty ? TRACE_DIRTY : 0) | (status != OK ? TRACE_FAILED : 0));
+	}
+	return status;
+}
 
 //--------------------------------------------------------------------
-// BufMgr::UnpinPage
+// BufMgr::PinPage
 //
-// Input    : pid     - page id of a particular page 
-//            dirty   - indicate whether the page with page id = pid
-//                      is dirty or not. (Optional, default to false)
-// Output   : None
-// Purpose  : Unpin the page with page id = pid in the buffer. Mark 
-//            the page dirty if dirty is true.  
-// Condition: The page is already in the buffer and is pinned.
-// PostCond : The page is unpinned and the number of pin on the
-//            page decrease by one. 
-// Return   : OK if operation is successful.  FAIL otherwise.
+// Input    : pid, intent, isEmpty
+// Output   : pin - holds the page, and its frame's latch in the mode of
+//            intent
+// Purpose  : Pin the page under poolLock, then latch it without.  A
+//            thread waiting for a latch must not hold poolLock, or the
+//            holder could never unpin; the pin keeps the frame from
+//            being reused meanwhile.
 //--------------------------------------------------------------------
-Status BufMgr::UnpinPage(PageID pid, bool dirty)
+Status BufMgr::PinPage(PageID pid, PageGuard& pin, PinIntent intent, bool isEmpty)
 {
-	//std::cout << "Unin PageID " << pid << std::endl;
-	////std::cout << "Unpinning page  " << pid << " Dirty?: " << dirty << std::endl;
-	int frameIndex = FindFrame(pid);
-	if (frameIndex == INVALID_FRAME) return FAIL;
-
-	Frame* targetFrame = &frames[frameIndex];
-	if (targetFrame->NotPinned()) return FAIL;
-
-	if (dirty) targetFrame->DirtyIt();
-
-	targetFrame->Unpin();
+	pin.Release();
+
+	Page* page;
+	Latch* latch;
+	int frameIndex;
+	{
+		std::lock_guard<std::recursive_mutex> guard(poolLock);
+		Status status = pool.PinPage(pid, page, isEmpty, &frameIndex);
+		if (trace) trace->Record(TRACE_PIN, pid, (isEmpty ? TRACE_EMPTY : 0) | (status != OK ? TRACE_FAILED : 0));
+		if (statsServer) PublishStatsIfDue();
+		if (status != OK) return status;
+		latch = &pool.GetLatch(frameIndex);
+	}
 
-	if (targetFrame->NotPinned()) replacer->AddFrame(targetFrame->GetPageID());
+	if (intent == PIN_WRITE) latch->LockExclusive();
+	else latch->LockShared();
 
+	pin.mgr = this;
+	pin.frame = frameIndex;
+	pin.pid = pid;
+	pin.page = page;
+	pin.latch = latch;
+	pin.intent = intent;
+	pin.dirty = (intent == PIN_WRITE);
 	return OK;
 }
 
+Status BufMgr::UnpinFrame(int frameIndex, PageID pid, bool dirty)
+{
+	std::lock_guard<std::recursive_mutex> guard(poolLock);
+	Status status = pool.UnpinFrame(frameIndex, pid, dirty);
+	if (trace) trace->Record(TRACE_UNPIN, pid, (dirty ? TRACE_DIRTY : 0) | (status != OK ? TRACE_FAILED : 0));
+	return status;
+}
+
 //--------------------------------------------------------------------
 // BufMgr::NewPage
 //
-// Input    : howMany - (optional, default to 1) how many pages to 
-//                      allocate.
-// Output   : firstPid  - the page id of the first page (as output by
-//                   DB::AllocatePage) allocated.
-//            firstPage - a pointer to the page in memory.
-// Purpose  : Allocate howMany number of pages, and pin the first page
-//            into the buffer. 
-// Condition: howMany > 0 and there is at least one free buffer space
-//            to hold a page.
-// PostCond : The page with page id = pid is pinned into the buffer.
-// Return   : OK if operation is successful.  FAIL otherwise.
-// Note     : You can call DB::AllocatePage() to allocate a page.  
-//            You should call DB:DeallocatePage() to deallocate the
-//            pages you allocate if you failed to pin the page in the
-//            buffer.
+// Purpose  : As BufPool::NewPage, but the pages are allocated before
+//            poolLock is taken (see the class comment).
 //--------------------------------------------------------------------
-Status BufMgr::NewPage (PageID& firstPid, Page*& firstPage, int howMany)
+Status BufMgr::NewPage(PageID& firstPid, Page*& firstPage, int howMany)
 {
-	//std::cout << "New Page Request for " << howMany << " pages." << std::endl;
-	// Condition Checks
-	if (howMany <= 0) return FAIL;
-
-	bool foundEmptyFrame = false;
-	Frame* currFrame;
-	for (int iter = 0; iter < numFrames; iter++) {
-		currFrame = &frames[iter];
-		if (!currFrame->IsValid() || currFrame->NotPinned()){
-			foundEmptyFrame = true;
-			break;
-		}
+	const int blocks = howMany * BufPool<DynamicPolicy>::BLOCKS_PER_PAGE;
+	bool allocated = false;
+	Status status = FAIL;
+	if (howMany > 0 && GetNumOfUnpinnedFrames() > 0)
+		allocated = (MINIBASE_DB->AllocatePage(firstPid, blocks) == OK);
+
+	if (allocated) {
+		std::lock_guard<std::recursive_mutex> guard(poolLock);
+		status = pool.PinPage(firstPid, firstPage, true);
 	}
-	//std::cout << "Found empty frame? " << ((foundEmptyFrame) ? "yes" : "no") << "." << std::endl;
-	if (!foundEmptyFrame) return FAIL;
-
-	// Allocate the pages
-
-	//std::cout << "Allocating" << std::endl;
-
-	if (MINIBASE_DB->AllocatePage(firstPid, howMany) != OK) {
+	if (status != OK) {
+		if (allocated) MINIBASE_DB->DeallocatePage(firstPid, blocks);
 		firstPid = INVALID_PAGE;
 		firstPage = NULL;
-		return FAIL;
 	}
 
-	//std::cout << "Allocated " << howMany << " pages with fristPid = " << firstPid << std::endl;
+	std::lock_guard<std::recursive_mutex> guard(poolLock);
+	if (trace) trace->Record(TRACE_NEW, firstPid, status != OK ? TRACE_FAILED : 0);
+	return status;
+}
 
-	if (PinPage(firstPid,firstPage,true) != OK) {
-		MINIBASE_DB->DeallocatePage(firstPid, howMany);
-		firstPid = INVALID_PAGE;
-		firstPage = NULL;
-		return FAIL;
+Status BufMgr::FreePage(PageID pid)
+{
+	Status status;
+	{
+		std::lock_guard<std::recursive_mutex> guard(poolLock);
+		status = pool.RemovePage(pid);
 	}
+	if (status == OK)
+		status = MINIBASE_DB->DeallocatePage(pid, BufPool<DynamicPolicy>::BLOCKS_PER_PAGE);
 
-	//std::cout << "Allocated " << howMany << " new pages and pinned pageID: " << firstPid << std::endl;
-	return OK;
+	std::lock_guard<std::recursive_mutex> guard(poolLock);
+	if (trace) trace->Record(TRACE_FREE, pid, status != OK ? TRACE_FAILED : 0);
+	return status;
 }
 
-//--------------------------------------------------------------------
-// BufMgr::FreePage
-//
-// Input    : pid     - page id of a particular page 
-// Output   : None
-// Purpose  : Free the memory allocated for the page with 
-//            page id = pid  
-// Condition: Either the page is already in the buffer and is pinned
-//            no more than once, or the page is not in the buffer.
-// PostCond : The page is unpinned, and the frame where it resides in
-//            the buffer pool is freed.  Also the page is deallocated
-//            from the database. 
-// Return   : OK if operation is successful.  FAIL otherwise.
-// Note     : You can call MINIBASE_DB->DeallocatePage(pid) to
-//            deallocate a page.
-//--------------------------------------------------------------------
-Status BufMgr::FreePage(PageID pid)
+Status BufMgr::FlushPage(PageID pid)
 {
-	//std::cout << "Free PageID " << pid << std::endl;
-	////std::cout << "Free page:  " << pid << std::endl;
-
-	Frame* targetFrame;
-	int frameIndex = FindFrame(pid);
-	if (frameIndex != INVALID_FRAME) {
-		targetFrame = &frames[frameIndex];
-
-		if (targetFrame->GetPinCount() > 1) return FAIL;
-		
-		UnpinPage(pid, true);
-		FlushPage(pid);
-	}
-	
-	return MINIBASE_DB->DeallocatePage(pid);
+	std::lock_guard<std::recursive_mutex> guard(poolLock);
+	Status status = pool.FlushPage(pid);
+	if (trace) trace->Record(TRACE_FLUSH, pid, status != OK ? TRACE_FAILED : 0);
+	return status;
 }
 
+Status BufMgr::FlushAllPages()
+{
+	std::lock_guard<std::recursive_mutex> guard(poolLock);
+	Status status = pool.FlushAllPages();
+	if (trace) trace->Record(TRACE_FLUSH_ALL, INVALID_PAGE, status != OK ? TRACE_FAILED : 0);
+	if (statsServer) PublishStats();
+	return status;
+}
 
+unsigned int BufMgr::GetNumOfUnpinnedFrames()
+{
+	std::lock_guard<std::recursive_mutex> guard(poolLock);
+	return pool.GetNumOfUnpinnedFrames();
+}
 
+int BufMgr::GetNumFrames() const
+{
+	return pool.GetNumFrames();
+}
 
+Status BufMgr::Resize(int newFrames)
+{
+	std::lock_guard<std::recursive_mutex> guard(poolLock);
+	return pool.Resize(newFrames);
+}
 
 //--------------------------------------------------------------------
-// BufMgr::FlushPage
+// BufMgr::SetReplacementPolicy
 //
-// Input    : pid  - page id of a particular page 
-// Output   : None
-// Purpose  : Flush the page with the given pid to disk.
-// Condition: The page with page id = pid must be in the buffer,
-//            and is not pinned. pid cannot be INVALID_PAGE.
-// PostCond : The page with page id = pid is written to disk if it's dirty. 
-//            The frame where the page resides is empty.
-// Return   : OK if operation is successful.  FAIL otherwise.
+// Input    : replacementPolicy - a policy spec, see ReplacerRegistry
+// PostCond : On success the new replacer holds every unpinned page and
+//            the old one is deleted.  On error nothing changes.
+// Return   : OK, UNKNOWN_REPLACER or BAD_REPLACER_PARAM.
 //--------------------------------------------------------------------
-Status BufMgr::FlushPage(PageID pid)
+Status BufMgr::SetReplacementPolicy(const char* replacementPolicy)
 {
-	//std::cout << "Flush Page" << pid << std::endl;
-	////std::cout << "Flush Page  " << pid << std::endl;
-	int frameIndex = FindFrame(pid);
-	if (frameIndex == INVALID_FRAME) return FAIL;
+	Status status;
+	Replacer* r = ReplacerRegistry::Create(replacementPolicy, status);
+	if (r == NULL) return status;
+
+	std::lock_guard<std::recursive_mutex> guard(poolLock);
+	pool.GetPolicy().Set(r);
+	pool.RebuildPolicy();
+	policySpec = replacementPolicy;
+	return OK;
+}
 
-	Frame* targetFrame = &frames[frameIndex];
-	if(!targetFrame->IsValid() || !targetFrame->NotPinned()) return FAIL;
+const char* BufMgr::GetReplacementPolicy() const
+{
+	return policySpec.c_str();
+}
 
-	if (targetFrame->IsDirty()){
-		if (targetFrame->Write() != OK) return FAIL;
-		numDirtyPageWrites++;
-	}
-	
-	replacer->RemoveFrame(targetFrame->GetPageID());
-	targetFrame->EmptyIt();
-	//std::cout << "Flush OK " << std::endl;
-	return OK;
-} 
+void BufMgr::SetPageChecksums(bool on) {
+	Frame::SetChecksums(on);
+}
 
-//--------------------------------------------------------------------
-// BufMgr::FlushAllPages
-//
-// Input    : None
-// Output   : None
-// Purpose  : Flush all pages in this buffer pool to disk.
-// Condition: All pages in the buffer pool must not be pinned.
-// PostCond : All dirty pages in the buffer pool are written to 
-//            disk (even if some pages are pinned). All frames are empty.
-// Return   : OK if operation is successful.  FAIL otherwise.
-//--------------------------------------------------------------------
+void BufMgr::SetVictimCache(VictimCache* cache) {
+	std::lock_guard<std::recursive_mutex> guard(poolLock);
+	pool.SetVictimCache(cache);
+}
 
-Status BufMgr::FlushAllPages()
-{
-	//std::cout << "Flush all " << std::endl;
-	bool failedOnce = false;
-	Frame* currFrame;
-	for (int iter = 0; iter < numFrames; iter++) {
-		currFrame = &frames[iter];
-		if (currFrame->IsValid()) {
-			// Check that the frame is not pinned
-			if (!currFrame->NotPinned()){
-				failedOnce = true;
-			}
-
-			if (currFrame->IsDirty()){
-				if (currFrame->Write() != OK) failedOnce = true;
-				numDirtyPageWrites++;
-			}
-
-			replacer->RemoveFrame(currFrame->GetPageID());
-			currFrame->EmptyIt();
-		}
-	}
-	return (failedOnce) ? FAIL : OK;
+void BufMgr::SetLatencyTracking(bool on) {
+	std::lock_guard<std::recursive_mutex> guard(poolLock);
+	pool.SetLatencyTracking(on);
 }
 
+double BufMgr::GetLatencyPercentile(LatencyOp op, double q) {
+	return pool.GetLatencyStats().GetPercentile(op, q);
+}
+
+LatencyStats& BufMgr::GetLatencyStats() {
+	return pool.GetLatencyStats();
+}
+
+void BufMgr::SetMissRatioTracking(bool on) {
+	std::lock_guard<std::recursive_mutex> guard(poolLock);
+	pool.SetMissRatioTracking(on);
+}
+
+double BufMgr::PredictHitRatio(int numFrames) {
+	std::lock_guard<std::recursive_mutex> guard(poolLock);
+	return pool.GetMissRatioCurve().PredictHitRatio(numFrames);
+}
+
+BufStats BufMgr::GetStats() {
+	std::lock_guard<std::recursive_mutex> guard(poolLock);
+	BufStats stats;
+	pool.GetStats(stats);
+	stats.policy = policySpec;
+	if (minibase_globals && MINIBASE_DB) MINIBASE_DB->GetIOStats(stats.db);
+	return stats;
+}
+
+Status BufMgr::ExportStats(const char* path, StatsFormat format) {
+	return GetStats().Save(path, format);
+}
+
+static long long MillisecondsNow() {
+	return std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
 //--------------------------------------------------------------------
-// BufMgr::GetNumOfUnpinnedFrames
+// BufMgr::ServeStats
 //
-// Input    : None
-// Output   : None
-// Purpose  : Find out how many unpinned locations are in the buffer
-//            pool.
-// Condition: None
-// PostCond : None
-// Return   : The number of unpinned buffers in the buffer pool.
+// Input    : port      - TCP port on 127.0.0.1, 0 for any free one
+//            refreshMs - how stale the served snapshot may get while
+//                        the pool is busy
+// Purpose  : Start a StatsServer and publish a first snapshot.  The
+//            server thread only reads published snapshots, so PinPage
+//            publishes a new one when refreshMs have passed; it looks
+//            at the clock only every 256 pins.
+// Return   : OK, or STATS_SERVER_ERROR.  Serving again restarts the
+//            server on the new port.
 //--------------------------------------------------------------------
-unsigned int BufMgr::GetNumOfUnpinnedFrames()
-{
-	int count = 0;
-	Frame* currFrame;
-	for (int iter = 0; iter < numFrames; iter++) {
-		currFrame = &frames[iter];
-		if (currFrame->NotPinned()) {
-			count++;
-		}
+Status BufMgr::ServeStats(int port, int refreshMs) {
+	std::lock_guard<std::recursive_mutex> guard(poolLock);
+	StopServingStats();
+
+	statsServer = new StatsServer;
+	Status status = statsServer->Start(port);
+	if (status != OK) {
+		delete statsServer;
+		statsServer = NULL;
+		return status;
 	}
 
-	return count;
+	statsRefreshMs = refreshMs;
+	publishTick = 0;
+	PublishStats();
+	return OK;
 }
 
-//--------------------------------------------------------------------
-// BufMgr::FindFrame
-//
-// Input    : pid - a page id 
-// Output   : None
-// Purpose  : Look for the page in the buffer pool, return the frame
-//            number if found.
-// PreCond  : None
-// PostCond : None
-// Return   : the frame number if found. INVALID_FRAME otherwise.
-//--------------------------------------------------------------------
-int BufMgr::FindFrame( PageID pid )
-{
-	Frame* currFrame;
-	for (int iter = 0; iter < numFrames; iter++) {
-		currFrame = &frames[iter];
-		if (currFrame->GetPageID() == pid) {
-			return iter;
-		}
+void BufMgr::StopServingStats() {
+	std::lock_guard<std::recursive_mutex> guard(poolLock);
+	delete statsServer;
+	statsServer = NULL;
+}
+
+int BufMgr::GetStatsPort() const {
+	return statsServer ? statsServer->GetPort() : 0;
+}
+
+void BufMgr::PublishStats() {
+	statsServer->Publish(GetStats());
+	lastPublishMs = MillisecondsNow();
+}
+
+void BufMgr::PublishStatsIfDue() {
+	if (++publishTick % 256 != 0) return;
+	if (MillisecondsNow() - lastPublishMs >= statsRefreshMs) PublishStats();
+}
+
+Status BufMgr::StartTrace(const char* path) {
+	std::lock_guard<std::recursive_mutex> guard(poolLock);
+	StopTrace();
+
+	trace = new TraceRecorder;
+	Status status = trace->Start(path);
+	if (status != OK) {
+		delete trace;
+		trace = NULL;
 	}
-	return INVALID_FRAME;
+	return status;
 }
 
+Status BufMgr::StopTrace() {
+	std::lock_guard<std::recursive_mutex> guard(poolLock);
+	if (!trace) return OK;
 
+	Status status = trace->Stop();
+	delete trace;
+	trace = NULL;
+	return status;
+}
 
 void BufMgr::ResetStat() { 
-	totalHit = 0; 
-	totalCall = 0; 
-	numDirtyPageWrites = 0;
+	std::lock_guard<std::recursive_mutex> guard(poolLock);
+	pool.ResetStat();
+	if (minibase_globals && MINIBASE_DB) MINIBASE_DB->ResetStat();
+	if (statsServer) PublishStats();
 }
 
 void  BufMgr::PrintStat() {
-	cout<<"**Buffer Manager Statistics**"<<endl;
-	cout<<"Number of Dirty Pages Written to Disk: "<<numDirtyPageWrites<<endl;
-	cout<<"Number of Pin Page Requests: "<<totalCall<<endl;
-	cout<<"Number of Pin Page Request Misses "<<totalCall-totalHit<<endl;
+	std::lock_guard<std::recursive_mutex> guard(poolLock);
+	pool.PrintStat();
 }
-
@@ -0,0 +1,170 @@
+#include "cache_sim.h"
+#include "db.h"
+
+
+//--------------------------------------------------------------------
+// CacheSim
+//--------------------------------------------------------------------
+CacheSim::CacheSim(Replacer* replacer, int numFrames)
+{
+	this->replacer = replacer;
+	this->numFrames = numFrames;
+	numPins = 0;
+	numHits = 0;
+	numEvictionWrites = 0;
+	numFailedPins = 0;
+}
+
+CacheSim::~CacheSim()
+{
+	delete replacer;
+}
+
+void CacheSim::Apply(const TraceEvent& event)
+{
+	if (event.flags & TRACE_FAILED) return;
+
+	int pid = event.pid;
+	std::unordered_map<int, PageState>::iterator it;
+
+	switch (event.type) {
+	case TRACE_PIN:
+		Pin(pid, true);
+		break;
+
+	case TRACE_NEW:
+		Pin(pid, false);
+		break;
+
+	case TRACE_UNPIN:
+		it = pages.find(pid);
+		if (it == pages.end() || it->second.pinCount == 0) break;
+		if (event.flags & TRACE_DIRTY) it->second.dirty = true;
+		if (--it->second.pinCount == 0) replacer->AddFrame(pid);
+		break;
+
+	case TRACE_FREE:
+	case TRACE_FLUSH:
+		if (pages.find(pid) != pages.end()) Drop(pid);
+		break;
+
+	case TRACE_FLUSH_ALL:
+		while (!pages.empty())
+			Drop(pages.begin()->first);
+		break;
+	}
+}
+
+//--------------------------------------------------------------------
+// CacheSim::Pin
+//
+// Input    : pid     - the page pinned
+//            counted - whether this is a PinPage request (a NewPage
+//                      pin is not)
+// Purpose  : Pin a page, evicting a victim if the page is not resident
+//            and every frame is taken.  A dirty victim is an eviction
+//            write.  If every page is pinned the pin fails.
+//--------------------------------------------------------------------
+void CacheSim::Pin(int pid, bool counted)
+{
+	if (counted) numPins++;
+
+	std::unordered_map<int, PageState>::iterator it = pages.find(pid);
+	if (it != pages.end()) {
+		if (counted) numHits++;
+		it->second.pinCount++;
+		replacer->RemoveFrame(pid);
+		return;
+	}
+
+	if ((int)pages.size() >= numFrames) {
+		int victim = replacer->PickVictim();
+		std::unordered_map<int, PageState>::iterator v = pages.find(victim);
+		if (victim == INVALID_PAGE || v == pages.end()) {
+			if (counted) numFailedPins++;
+			return;
+		}
+		if (v->second.dirty) numEvictionWrites++;
+		pages.erase(v);
+	}
+
+	PageState state;
+	state.pinCount = 1;
+	state.dirty = false;
+	pages[pid] = state;
+	replacer->RemoveFrame(pid);
+}
+
+// Take a page out of the pool without counting an eviction.
+void CacheSim::Drop(int pid)
+{
+	replacer->DropFrame(pid);
+	pages.erase(pid);
+}
+
+//--------------------------------------------------------------------
+// Belady
+//--------------------------------------------------------------------
+const long long Belady::NO_NEXT_USE = 0x7fffffffffffffffLL;
+
+Belady::Belady()
+{
+}
+
+Belady::~Belady()
+{
+}
+
+int Belady::PickVictim()
+{
+	if (candidates.empty()) return INVALID_PAGE;
+
+	Order::iterator last = candidates.end();
+	--last;
+	int victim = last->second;
+	candidates.erase(last);
+	return victim;
+}
+
+void Belady::AddFrame(int f)
+{
+	std::unordered_map<int, long long>::const_iterator it = nextUse.find(f);
+	long long next = (it == nextUse.end()) ? NO_NEXT_USE : it->second;
+	candidates.insert(std::make_pair(next, f));
+}
+
+void Belady::RemoveFrame(int f)
+{
+	std::unordered_map<int, long long>::const_iterator it = nextUse.find(f);
+	long long next = (it == nextUse.end()) ? NO_NEXT_USE : it->second;
+	candidates.erase(std::make_pair(next, f));
+}
+
+// Called before the pin, while the page is not a candidate (or is about
+// to stop being one), so the candidate set never holds a stale key.
+void Belady::SetNextUse(int pid, long long next)
+{
+	RemoveFrame(pid);
+	nextUse[pid] = next;
+}
+
+void Belady::FindNextUses(const std::vector<TraceEvent>& events, std::vector<long long>& next)
+{
+	next.assign(events.size(), NO_NEXT_USE);
+
+	std::unordered_map<int, long long> later;	// page -> its next pin so far
+	for (long long i = (long long)events.size() - 1; i >= 0; i--) {
+		const TraceEvent& e = events[i];
+		if ((e.type != TRACE_PIN && e.type != TRACE_NEW) || (e.flags & TRACE_FAILED))
+			continue;
+
+		std::unordered_map<int, long long>::iterator it = later.find(e.pid);
+		if (it != later.end()) {
+			next[i] = it->second;
+			it->second = i;
+		}
+		else {
+			later[e.pid] = i;
+		}
+	}
+}
@@ -0,0 +1,145 @@
+#include <string.h>
+
+#include "checksum.h"
+
+// The hardware path needs the SSE4.2 crc32 instruction; it is compiled in on
+// x86 with MSVC, GCC or Clang, and picked at run time only if the CPU
+// reports SSE4.2.  The software path is slicing-by-8: eight 256-entry
+// tables, consuming eight input bytes per step.
+
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#   include <intrin.h>
+#   include <nmmintrin.h>
+#   define CRC32C_HAVE_HW 1
+#   define CRC32C_TARGET
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__i386__) || defined(__x86_64__))
+#   include <cpuid.h>
+#   include <nmmintrin.h>
+#   define CRC32C_HAVE_HW 1
+#   define CRC32C_TARGET __attribute__((target("sse4.2")))
+#else
+#   define CRC32C_HAVE_HW 0
+#endif
+
+static const unsigned int crc32c_poly = 0x82f63b78;   // reflected
+
+static unsigned int crc_table[8][256];
+
+static bool BuildTables()
+{
+	for (unsigned int n = 0; n < 256; n++) {
+		unsigned int crc = n;
+		for (int k = 0; k < 8; k++)
+			crc = (crc & 1) ? (crc >> 1) ^ crc32c_poly : crc >> 1;
+		crc_table[0][n] = crc;
+	}
+	for (unsigned int n = 0; n < 256; n++) {
+		unsigned int crc = crc_table[0][n];
+		for (int t = 1; t < 8; t++) {
+			crc = crc_table[0][crc & 0xff] ^ (crc >> 8);
+			crc_table[t][n] = crc;
+		}
+	}
+	return true;
+}
+
+static bool crc_table_ready = BuildTables();
+
+unsigned int Crc32cSoftware( const void* data, size_t len )
+{
+	if (!crc_table_ready)
+		BuildTables();
+
+	const unsigned char* p = (const unsigned char*)data;
+	unsigned int crc = 0xffffffff;
+
+	while (len >= 8) {
+		unsigned int lo, hi;
+		memcpy(&lo, p, 4);
+		memcpy(&hi, p + 4, 4);
+		lo ^= crc;
+		crc = crc_table[7][lo & 0xff] ^ crc_table[6][(lo >> 8) & 0xff]
+		    ^ crc_table[5][(lo >> 16) & 0xff] ^ crc_table[4][lo >> 24]
+		    ^ crc_table[3][hi & 0xff] ^ crc_table[2][(hi >> 8) & 0xff]
+		    ^ crc_table[1][(hi >> 16) & 0xff] ^ crc_table[0][hi >> 24];
+		p += 8;
+		len -= 8;
+	}
+	while (len--)
+		crc = crc_table[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+
+	return crc ^ 0xffffffff;
+}
+
+#if CRC32C_HAVE_HW
+
+static bool CpuHasSse42()
+{
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] & (1 << 20)) != 0;
+#else
+	unsigned int eax, ebx, ecx, edx;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+		return false;
+	return (ecx & bit_SSE4_2) != 0;
+#endif
+}
+
+CRC32C_TARGET
+static unsigned int Crc32cHardwareImpl( const void* data, size_t len )
+{
+	const unsigned char* p = (const unsigned char*)data;
+
+#if defined(_M_X64) || defined(__x86_64__)
+	unsigned long long crc = 0xffffffff;
+	while (len >= 8) {
+		unsigned long long v;
+		memcpy(&v, p, 8);
+		crc = _mm_crc32_u64(crc, v);
+		p += 8;
+		len -= 8;
+	}
+	unsigned int crc32 = (unsigned int)crc;
+#else
+	unsigned int crc32 = 0xffffffff;
+	while (len >= 4) {
+		unsigned int v;
+		memcpy(&v, p, 4);
+		crc32 = _mm_crc32_u32(crc32, v);
+		p += 4;
+		len -= 4;
+	}
+#endif
+	while (len--)
+		crc32 = _mm_crc32_u8(crc32, *p++);
+
+	return crc32 ^ 0xffffffff;
+}
+
+static const bool use_hw = CpuHasSse42();
+
+bool Crc32cHardware()
+{
+	return use_hw;
+}
+
+unsigned int Crc32c( const void* data, size_t len )
+{
+	return use_hw ? Crc32cHardwareImpl(data, len) : Crc32cSoftware(data, len);
+}
+
+#else
+
+bool Crc32cHardware()
+{
+	return false;
+}
+
+unsigned int Crc32c( const void* data, size_t len )
+{
+	return Crc32cSoftware(data, len);
+}
+
+#endif
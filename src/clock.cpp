@@ -0,0 +1,97 @@
+#include "clock.h"
+
+
+// SCHEMA FOR THE CLOCK POLICY
+// ring holds the unpinned pages in clock order and where maps a page to its
+// entry.  hand (and lead) point into ring, or at ring.end() only while the
+// ring is empty.  New pages go in just behind the evicting hand, so they
+// are the last it reaches.
+
+Clock::Clock(int hands, int gap) {
+	this->hands = hands;
+	this->gap = gap;
+	hand = ring.end();
+	lead = ring.end();
+	leadPlaced = false;
+	handSteps = 0;
+}
+
+Clock::~Clock() {
+}
+
+// Move an iterator one step around the ring.
+void Clock::Advance(Ring::iterator& it) {
+	++it;
+	if (it == ring.end()) it = ring.begin();
+}
+
+int Clock::PickVictim() {
+	if (ring.empty()) return INVALID_PAGE;
+
+	if (hands == 2 && !leadPlaced) {
+		int distance = (gap > 0) ? gap : (int)ring.size() / 2;
+		lead = hand;
+		for (int i = 0; i < distance; i++)
+			Advance(lead);
+		leadPlaced = true;
+	}
+
+	// Each step, the leading hand (if any) clears one bit and the
+	// evicting hand looks at one page.  Within two turns some bit is clear.
+	for (;;) {
+		if (hands == 2) {
+			lead->referenced = false;
+			Advance(lead);
+		}
+		if (!hand->referenced) break;
+		hand->referenced = false;
+		Advance(hand);
+		handSteps++;
+	}
+
+	int victim = hand->pid;
+	RemoveFrame(victim);
+	return victim;
+}
+
+void Clock::AddFrame(int f) {
+	std::unordered_map<int, Ring::iterator>::iterator found = where.find(f);
+	if (found != where.end()) {
+		found->second->referenced = true;
+		return;
+	}
+
+	Entry e;
+	e.pid = f;
+	e.referenced = true;
+	where[f] = ring.insert(hand, e);
+	if (hand == ring.end()) hand = ring.begin();
+	if (lead == ring.end()) lead = hand;
+}
+
+void Clock::RemoveFrame(int f) {
+	std::unordered_map<int, Ring::iterator>::iterator found = where.find(f);
+	if (found == where.end()) return;
+
+	Ring::iterator it = found->second;
+	if (hand == it) Advance(hand);
+	if (lead == it) Advance(lead);
+	ring.erase(it);
+	where.erase(found);
+
+	if (ring.empty()) {
+		hand = ring.end();
+		lead = ring.end();
+		leadPlaced = false;
+	}
+}
+
+void Clock::GetStats(ReplacerStats& stats) const {
+	long referenced = 0;
+	for (Ring::const_iterator it = ring.begin(); it != ring.end(); ++it)
+		if (it->referenced) referenced++;
+
+	stats.push_back(std::make_pair(std::string("candidates"), (double)ring.size()));
+	stats.push_back(std::make_pair(std::string("referenced"), (double)referenced));
+	stats.push_back(std::make_pair(std::string("hand_steps"), (double)handSteps));
+}
@@ -0,0 +1,137 @@
+#include <string.h>
+#include <iostream>
+
+using namespace std;
+
+#include "compressed_cache.h"
+#include "page_codec.h"
+
+
+// SCHEMA FOR THE COMPRESSED CACHE
+// entries is the list of cached pages, least recently used at the head;
+// index maps a page id to its entry.  Put and a successful Lookup move a
+// page to the tail.  bytesUsed counts each entry's data plus a fixed
+// allowance for the list and hash nodes.
+
+static const size_t entryOverhead = 64;
+
+CompressedCache::CompressedCache(size_t budgetBytes) {
+	budget = budgetBytes;
+	bytesUsed = 0;
+}
+
+CompressedCache::~CompressedCache() {
+}
+
+size_t CompressedCache::Footprint(const Entry& e) {
+	return e.data.size() + entryOverhead;
+}
+
+void CompressedCache::Erase(EntryList::iterator it) {
+	bytesUsed -= Footprint(*it);
+	index.erase(it->pid);
+	entries.erase(it);
+}
+
+bool CompressedCache::Lookup(PageID pid, Page* page) {
+	numLookups++;
+
+	std::unordered_map<PageID, EntryList::iterator>::iterator found = index.find(pid);
+	if (found == index.end()) return false;
+
+	EntryList::iterator it = found->second;
+	if (it->data.size() == MINIBASE_PAGESIZE) {
+		memcpy((char*)page, &it->data[0], MINIBASE_PAGESIZE);
+	} else if (PageDecompress(&it->data[0], (int)it->data.size(), (char*)page,
+	                          MINIBASE_PAGESIZE) != MINIBASE_PAGESIZE) {
+		Erase(it);
+		return false;
+	}
+
+	entries.splice(entries.end(), entries, it);
+	numHits++;
+	return true;
+}
+
+bool CompressedCache::Contains(PageID pid) {
+	return index.find(pid) != index.end();
+}
+
+//--------------------------------------------------------------------
+// CompressedCache::Put
+//
+// Input    : pid, page - a clean page leaving the buffer pool
+// PostCond : The page is the newest entry, unless its image alone is
+//            bigger than the budget.  Older entries are dropped until
+//            the cache is within budget again.
+//--------------------------------------------------------------------
+void CompressedCache::Put(PageID pid, const Page* page) {
+	Invalidate(pid);
+
+	char packed[MINIBASE_PAGESIZE];
+	int length = PageCompress((const char*)page, MINIBASE_PAGESIZE, packed, MINIBASE_PAGESIZE - 1);
+
+	Entry e;
+	e.pid = pid;
+	if (length > 0)
+		e.data.assign(packed, packed + length);
+	else
+		e.data.assign((const char*)page, (const char*)page + MINIBASE_PAGESIZE);
+
+	size_t need = Footprint(e);
+	if (need > budget) {
+		numDeclined++;
+		return;
+	}
+
+	while (bytesUsed + need > budget) {
+		Erase(entries.begin());
+		numEvictions++;
+	}
+
+	entries.push_back(Entry());
+	entries.back().pid = pid;
+	entries.back().data.swap(e.data);
+	index[pid] = --entries.end();
+	bytesUsed += need;
+	numPuts++;
+}
+
+void CompressedCache::Invalidate(PageID first, int count) {
+	if ((size_t)count <= index.size()) {
+		for (int i = 0; i < count; i++) {
+			std::unordered_map<PageID, EntryList::iterator>::iterator found = index.find(first + i);
+			if (found != index.end())
+				Erase(found->second);
+		}
+		return;
+	}
+
+	for (EntryList::iterator it = entries.begin(); it != entries.end(); ) {
+		EntryList::iterator next = it;
+		++next;
+		if (it->pid >= first && it->pid - first < count)
+			Erase(it);
+		it = next;
+	}
+}
+
+size_t CompressedCache::GetBytesUsed() const {
+	return bytesUsed;
+}
+
+unsigned CompressedCache::GetNumPages() const {
+	return (unsigned)entries.size();
+}
+
+void CompressedCache::PrintStat() {
+	cout<<"**Compressed Cache Statistics**"<<endl;
+	cout<<"Pages Cached: "<<entries.size()<<" in "<<bytesUsed/1024
+		<<" KB of "<<budget/1024<<" KB"<<endl;
+	cout<<"Number of Lookups: "<<numLookups<<endl;
+	cout<<"Number of Hits: "<<numHits<<endl;
+	cout<<"Hit Ratio: "<<(numLookups > 0 ? (double)numHits / numLookups : 0)<<endl;
+	cout<<"Pages Inserted: "<<numPuts<<endl;
+	cout<<"Pages Too Big for the Budget: "<<numDeclined<<endl;
+	cout<<"Pages Dropped for Space: "<<numEvictions<<endl;
+}
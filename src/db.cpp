@@ -5,12 +5,16 @@
 
 //#include <unistd.h>
 #include <stdio.h>
-#include <fcntl.h>
-#include <io.h>
 #include <iomanip>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
 
 #include "db.h"
 #include "bufmgr.h"
+#include "page_codec.h"
+#include "delay_storage.h"
 
 static const int bits_per_page = MAX_SPACE * 8;
 
@@ -23,10 +27,37 @@ static const char* dbErrMsgs[] = {
     "File not found" ,          // FILE_NOT_FOUND
     "File name too long",       // FILE_NAME_TOO_LONG
     "Negative run size",        // NEG_RUN_SIZE
+    "Bad device model",         // BAD_DEVICE_MODEL
 };
 
 static error_string_table dbTable( DBMGR, dbErrMsgs );
 
+  // Each DB gets a serial number so that a thread's cached extent-cache
+  // pointer can tell whether it still belongs to the open database.
+static unsigned next_db_serial = 0;
+
+static const unsigned default_extent_cache_size = 64;
+
+  // Granularity of extents in a compressed database file.
+static const int compress_unit = 256;
+
+  // The run-length bucket of n > 0: floor(log2(n)).
+static int run_bucket( long long n )
+{
+    int b = 0;
+    while ( n > 1 && b < DBIOStats::RUN_BUCKETS - 1 ) {
+        n >>= 1;
+        b++;
+    }
+    return b;
+}
+
+static double seconds_since( std::chrono::steady_clock::time_point start )
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start ).count();
+}
+
 
 // Member functions for class DB
 
@@ -34,9 +65,11 @@ static error_string_table dbTable( DBMGR, dbErrMsgs );
 // Constructor for DB
 // This function creates a database with the specified number of pages
 // where the pagesize is default.
-// It creates a UNIX file with the proper size. 
+// It creates the storage (see DBOptions) with the proper size, or for a
+// compressed database an empty one that grows as pages are written.
 
-DB::DB( const char* fname, unsigned num_pgs, Status& status )
+DB::DB( const char* fname, unsigned num_pgs, Status& status,
+        const DBOptions& options )
 {
 
 #ifdef DEBUG 
@@ -46,22 +79,56 @@ DB::DB( const char* fname, unsigned num_pgs, Status& status )
 
     name = strcpy(new char[strlen(fname)+1],fname);
     num_pages = (num_pgs > 2) ? num_pgs : 2;
+    alloc_policy = NEXT_FIT;
+    alloc_cursor = 0;
+    extent_cache_size = default_extent_cache_size;
+    serial = ++next_db_serial;
+    compressed = options.compress;
+    file_units = 0;
+    ResetStat();
 
     // Create the file; fail if it's already there; open it in read/write
     // mode.
 	// but for this assignment, can overwrite previous minibase.db (remove O_EXCL)
-    fd = _open( name, O_RDWR | O_CREAT | O_TEMPORARY | O_BINARY, 0666 );
-
-    if ( fd < 0 ) {
-        status = MINIBASE_FIRST_ERROR( DBMGR, UNIX_ERROR );
-        return;
+    storage = Storage::Create( options.storage );
+    if ( options.device ) {
+        DelayStorage* device = DelayStorage::Create( options.device, storage );
+        if ( device == NULL ) {
+            status = MINIBASE_FIRST_ERROR( DBMGR, BAD_DEVICE_MODEL );
+            return;
+        }
+        storage = device;
     }
+    status = storage->Open( name, compressed ? STORE_NEW : STORE_TEMPORARY );
+    if ( status != OK )
+        return;
 
 
-    // Make the file num_pages pages long, filled with zeroes.
-    char zero = 0;
-    _lseek( fd, (num_pages*MINIBASE_PAGESIZE)-1, SEEK_SET );
-    _write( fd, &zero, 1 );
+    // Make the file num_pages pages long, filled with zeroes.  A compressed
+    // database starts out empty instead: every page reads as zeroes until
+    // it is first written.  Its file is kept when it is closed, and its
+    // empty page map is saved at once, so that it can be reopened from
+    // here on; a page map left behind by an earlier database of the same
+    // name is replaced, or removed if this one is not compressed.
+    if ( compressed ) {
+        page_extent never_written = { 0, 0, 0 };
+        page_map.assign( num_pages, never_written );
+        extent_saved.assign( num_pages, false );
+        if ( storage->IsPersistent() ) {
+            std::lock_guard<std::mutex> guard( io_lock );
+            status = save_page_map();
+            if ( status != OK )
+                return;
+        }
+    } else {
+        char* map_name = page_map_name();
+        remove( map_name );
+        delete [] map_name;
+
+        status = storage->Allocate( (long long)num_pages*MINIBASE_PAGESIZE );
+        if ( status != OK )
+            return;
+    }
 
 
       // Initialize space map and directory pages.
@@ -83,7 +150,9 @@ DB::DB( const char* fname, unsigned num_pgs, Status& status )
     }
 
 	fp->num_db_pages = num_pages;
-	init_dir_page( &fp->dir, sizeof *fp );
+	fp->free_dir_page = 0;
+	init_dir_page( &fp->dir, offsetof(first_page, dir)
+	                         + offsetof(directory_page, entries) );
     
 	s = MINIBASE_BM->UnpinPage( 0 , true );
     if ( s != OK ) {
@@ -96,6 +165,10 @@ DB::DB( const char* fname, unsigned num_pgs, Status& status )
     // 0 and 1 and as many additional pages for the space map as are needed.
     unsigned num_map_pages = (num_pages + bits_per_page - 1) / bits_per_page;
     status = set_bits( 0, 1 + num_map_pages, 1 );
+    if ( status != OK )
+        return;
+
+    status = build_extent_index();
 }
 
 // ********************************************************
@@ -111,14 +184,24 @@ DB::DB(const char* fname, Status& status)
 #endif
 
     name = strcpy(new char[strlen(fname)+1],fname);
+    alloc_policy = NEXT_FIT;
+    alloc_cursor = 0;
+    extent_cache_size = default_extent_cache_size;
+    serial = ++next_db_serial;
+    compressed = false;
+    file_units = 0;
+    ResetStat();
 
     // Open the file in both input and output mode.
-    fd = ::open( name, O_RDWR );
+    storage = new FileStorage;
+    status = storage->Open( name, STORE_EXISTING );
+    if ( status != OK )
+        return;
 
-    if ( fd < 0 ) {
-        status = MINIBASE_FIRST_ERROR( DBMGR, UNIX_ERROR );
+    // A compressed database needs its page map before page 0 can be read.
+    status = load_page_map();
+    if ( status != OK )
         return;
-    }
 
     MINIBASE_DB = this; //set the global variable to be this.
 
@@ -148,7 +231,11 @@ DB::DB(const char* fname, Status& status)
         return;
     }
 
-    status = OK;
+    status = build_extent_index();
+    if ( status != OK )
+        return;
+
+    status = load_directory();
 }
 
 // ****************************************************************
@@ -160,9 +247,15 @@ DB::~DB()
 #ifdef DEBUG
     cout<< "Closing database " << name << endl;
 #endif
-    _close( fd );
-    fd = -1;
+    if ( compressed && storage->IsPersistent() ) {
+        std::lock_guard<std::mutex> guard( io_lock );
+        save_page_map();
+    }
+    delete storage;
     free( name );
+
+    for ( unsigned i=0; i < extent_caches.size(); ++i )
+        delete extent_caches[i];
 }
 
 // *****************************************************
@@ -176,9 +269,14 @@ Status DB::Destroy()
     cout << "Destroying the database" << endl;
 #endif
 
-    _close( fd );
-    fd = -1;
-    unlink( name );
+    storage->Close();
+    if ( storage->IsPersistent() )
+        remove( name );
+
+    char* map_name = page_map_name();
+    remove( map_name );
+    delete [] map_name;
+    compressed = false;     // Nothing left to save on close.
     
     return OK;
 }
@@ -204,13 +302,62 @@ int DB::GetPageSize() const
     return MINIBASE_PAGESIZE;
 }
 
+// ********************************************************
+
+int DB::GetNumFreePages() const
+{
+    return free_extents.GetNumFreePages();
+}
+
+// ********************************************************
+
+int DB::GetNumFreeExtents() const
+{
+    return free_extents.GetNumExtents();
+}
+
+// ********************************************************
+
+int DB::GetLargestFreeRun() const
+{
+    return free_extents.GetLargestRun();
+}
+
+// ********************************************************
+
+bool DB::IsCompressed() const
+{
+    return compressed;
+}
+
+// ********************************************************
+
+void DB::SetAllocPolicy(AllocPolicy policy)
+{
+    std::lock_guard<std::mutex> guard( space_lock );
+    alloc_policy = policy;
+}
+
+// ********************************************************
+
+void DB::SetExtentCacheSize(unsigned pages)
+{
+    std::lock_guard<std::mutex> guard( space_lock );
+    extent_cache_size = pages;
+}
+
 // ********************************************************
 // This function allocates a run of pages.
+// Single pages come from the calling thread's extent cache when caching is
+// on, so a bulk loader only takes space_lock once every extent_cache_size
+// pages.  Everything else is chosen from the free-extent index according
+// to alloc_policy; no space-map page is read, only the pages of the run
+// itself are flipped in the bitmap.
 
 Status DB::AllocatePage(PageID& start_page_num, int run_size_int)
 {
 #ifdef DEBUG
-    cout << "Allocating a run of "<< run_size << " pages." << endl;
+    cout << "Allocating a run of "<< run_size_int << " pages." << endl;
 #endif
 
     if ( run_size_int < 0 ) { 
@@ -219,62 +366,111 @@ Status DB::AllocatePage(PageID& start_page_num, int run_size_int)
     }
 
     unsigned run_size = run_size_int;
-    unsigned num_map_pages = (num_pages + bits_per_page - 1) / bits_per_page;
-    unsigned current_run_start = 0, current_run_length = 0;
 
+    if ( run_size == 1 && extent_cache_size > 0 ) {
+        extent_cache* cache = my_extent_cache();
+
+        if ( cache->left == 0 ) {
+              // Refill with a whole extent, or fall back to a single page
+              // when the database has no run that long left.  The index is
+              // asked first, so that a full database posts no DB_FULL for
+              // an allocation that then succeeds.
+            std::lock_guard<std::mutex> guard( space_lock );
+            if ( free_extents.FindRun( extent_cache_size, alloc_policy, alloc_cursor ) != INVALID_PAGE
+                 && allocate_run( cache->next, extent_cache_size ) == OK )
+                cache->left = extent_cache_size;
+            else
+                return allocate_run( start_page_num, 1 );
+        }
 
-    // This loop goes over each page in the space map.
-    Status status;
-    for( unsigned i=0; i < num_map_pages; ++i ) {
+        start_page_num = cache->next++;
+        cache->left--;
+        return OK;
+    }
 
-        PageID pgid = 1 + i;    // The space map starts at page #1.
-          // Pin the space-map page.
-        char* pg;
-        status = MINIBASE_BM->PinPage( pgid, (Page*&)pg );
-        if ( status != OK )
-            return MINIBASE_CHAIN_ERROR( DBMGR, status );
+    std::lock_guard<std::mutex> guard( space_lock );
+    return allocate_run( start_page_num, run_size );
+}
 
+// ********************************************************
+// Take a run from the free-extent index and mark it in the space map.
+// The caller holds space_lock.
 
-          // How many bits should we examine on this page?
-        unsigned num_bits_this_page = num_pages - i*bits_per_page;
-        if ( num_bits_this_page > bits_per_page )
-            num_bits_this_page = bits_per_page;
+Status DB::allocate_run( PageID& start_page_num, unsigned run_size )
+{
+    PageID start = free_extents.FindRun( run_size, alloc_policy, alloc_cursor );
+    if ( start == INVALID_PAGE )
+        return MINIBASE_FIRST_ERROR( DBMGR, DB_FULL );
 
+    Status status = set_bits( start, run_size, 1 );
+    if ( status != OK )
+        return status;
 
-          // Walk the page looking for a sequence of 0 bits of the appropriate
-          // length.  The outer loop steps through the page's bytes, the inner
-          // one steps through each byte's bits.
-        for ( ; num_bits_this_page > 0 && current_run_length < run_size; ++pg )
-            for ( unsigned mask=1;
-				(mask < 256) && (num_bits_this_page > 0) && (current_run_length < run_size);
-				mask <<= 1, --num_bits_this_page )
-			{
-				if ( *pg & mask ) 
-				{
-					current_run_start += current_run_length + 1;
-					current_run_length = 0;
-				} 
-				else
-					++current_run_length;
-			}
+    free_extents.MarkUsed( start, run_size );
+    alloc_cursor = start + run_size;
+    if ( alloc_cursor >= (PageID) num_pages )
+        alloc_cursor = 0;
 
-          // Unpin the space-map page.
-        status = MINIBASE_BM->UnpinPage( pgid );
-        if ( status != OK )
-            return MINIBASE_CHAIN_ERROR( DBMGR, status );
+    start_page_num = start;
+#ifdef DEBUG
+    cout<<"Page allocated in get_free_pages:: "<< start_page_num << endl;
+#endif
+    return OK;
+}
+
+// ********************************************************
+// Find or create the calling thread's extent cache.  A thread keeps one
+// cache pointer; if it was made for another (or a closed) database, the
+// thread's cache in this one is looked up, and made only if there is
+// none, so a thread moving between databases keeps one reservation in
+// each.  The DB owns the caches so that ReleaseExtentCaches can reach the
+// pages of threads that have exited.
+
+DB::extent_cache* DB::my_extent_cache()
+{
+    static thread_local unsigned owner = 0;
+    static thread_local extent_cache* cache = 0;
+
+    if ( owner != serial ) {
+        std::lock_guard<std::mutex> guard( space_lock );
+        std::thread::id me = std::this_thread::get_id();
+
+        cache = 0;
+        for ( unsigned i=0; i < extent_caches.size() && !cache; ++i )
+            if ( extent_caches[i]->thread == me )
+                cache = extent_caches[i];
+
+        if ( !cache ) {
+            cache = new extent_cache;
+            cache->thread = me;
+            cache->next = INVALID_PAGE;
+            cache->left = 0;
+            extent_caches.push_back( cache );
+        }
+        owner = serial;
     }
+    return cache;
+}
+
+// ********************************************************
 
+Status DB::ReleaseExtentCaches()
+{
+    std::lock_guard<std::mutex> guard( space_lock );
 
-    if ( current_run_length >= run_size ) {
+    for ( unsigned i=0; i < extent_caches.size(); ++i ) {
+        extent_cache* cache = extent_caches[i];
+        if ( cache->left == 0 )
+            continue;
 
-        start_page_num = current_run_start;
-#ifdef DEBUG
-        cout<<"Page allocated in get_free_pages:: "<< start_page_num << endl;
-#endif
-        return set_bits( start_page_num, run_size, 1 );
-    }
+        Status status = set_bits( cache->next, cache->left, 0 );
+        if ( status != OK )
+            return status;
 
-    return MINIBASE_FIRST_ERROR( DBMGR, DB_FULL );
+        free_extents.MarkFree( cache->next, cache->left );
+        cache->left = 0;
+    }
+    return OK;
 }
 
 // **********************************************************
@@ -293,13 +489,27 @@ Status DB::DeallocatePage(PageID start_page_num, int run_size)
       return MINIBASE_FIRST_ERROR ( DBMGR, NEG_RUN_SIZE);
     }
 
-    return set_bits( start_page_num, run_size, 0 );
+    std::lock_guard<std::mutex> guard( space_lock );
+
+    Status status = set_bits( start_page_num, run_size, 0 );
+    if ( status != OK )
+        return status;
+
+    free_extents.MarkFree( start_page_num, run_size );
+
+      // The stored images of freed pages are garbage; give their space back.
+    if ( compressed )
+        free_compressed( start_page_num, run_size );
+
+    return OK;
 }
 
 // ***********************************************************
 // This function adds a record containing the file name and the first page
 // of the file to the directory maintained in the header pages of the 
 // database.
+// Duplicates are caught by file_index, and the new entry goes into the
+// first page on the free-slot list, so no directory page is searched.
 
 Status DB::AddFileEntry(const char* fname, PageID start_page_num)
 {
@@ -315,84 +525,82 @@ Status DB::AddFileEntry(const char* fname, PageID start_page_num)
         return MINIBASE_FIRST_ERROR( DBMGR, BAD_PAGE_NO );
 
 
+    std::lock_guard<std::mutex> guard( dir_lock );
+
       // Does the file already exist?
-    PageID tmp;
-    if ( GetFileEntry(fname,tmp) == OK )
+    if ( file_index.find(fname) != file_index.end() )
         return MINIBASE_FIRST_ERROR( DBMGR, DUPLICATE_ENTRY );
 
-    char    *pg = 0;
     Status   status;
+    PageGuard first, header;
+    first_page* fp = 0;
     directory_page* dp = 0;
-    bool found = false;
-    unsigned free_slot = 0;
-    PageID hpid, nexthpid = 0;
-
-    do {
-        hpid = nexthpid;
-          // Pin the header page.
-        status = MINIBASE_BM->PinPage( hpid, (Page*&)pg );
-        if ( status != OK )
-            return MINIBASE_CHAIN_ERROR( DBMGR, status );
-
-          // This complication is because the first page has a different
-          // structure from that of subsequent pages.
-        dp = (hpid == 0)? &((first_page*)pg)->dir : (directory_page*)pg;
-        nexthpid = dp->next_page;
+    PageID hpid;
 
-        unsigned entry = 0;
-        while ( (entry < dp->num_entries)
-              && (dp->entries[entry].pagenum != INVALID_PAGE))
-            ++entry;
+      // Pin page 0 for the head of the free-slot list.
+    status = MINIBASE_BM->PinPage( 0, first, PIN_WRITE );
+    if ( status != OK )
+        return MINIBASE_CHAIN_ERROR( DBMGR, status );
+    fp = (first_page*)first.GetPage();
 
-        if ( entry < dp->num_entries ) {
-            free_slot = entry;
-            found = true;
-          } else if ( nexthpid != INVALID_PAGE ) {
+    hpid = fp->free_dir_page;
 
-              // We only unpin if we're going to continue looping.
-            status = MINIBASE_BM->UnpinPage( hpid );
-            if ( status != OK )
-                return MINIBASE_CHAIN_ERROR( DBMGR, status );
-          }
-    } while ( nexthpid != INVALID_PAGE && !found );
+      // Every directory page is full: link a new one in after page 0.
+    if ( hpid == INVALID_PAGE ) {
+        status = AllocatePage( hpid );
+        if ( status != OK )
+            return status;
 
-    
-         // Have to add a new header page if possible.
-    if ( !found ) {
-        status = AllocatePage( nexthpid );
+        status = MINIBASE_BM->PinPage( hpid, header, PIN_WRITE, true /*empty*/ );
         if ( status != OK ) {
-            MINIBASE_BM->UnpinPage( hpid );
-            return status;
+            DeallocatePage( hpid );
+            return MINIBASE_CHAIN_ERROR( DBMGR, status );
         }
 
-          // Set the next-page pointer on the previous directory page.
-        dp->next_page = nexthpid;
-        status = MINIBASE_BM->UnpinPage( hpid , true );
+        dp = (directory_page*)header.GetPage();
+        init_dir_page( dp, offsetof(directory_page, entries) );
+        dp->next_page = fp->dir.next_page;
+        fp->dir.next_page = hpid;
+        fp->free_dir_page = hpid;
+    } else if ( hpid == 0 ) {
+          // Page 0 is latched already; a second guard on it would wait on
+          // the first.
+        dp = &fp->dir;
+    } else {
+        status = MINIBASE_BM->PinPage( hpid, header, PIN_WRITE );
         if ( status != OK )
             return MINIBASE_CHAIN_ERROR( DBMGR, status );
+        dp = dir_page_of( hpid, (char*)header.GetPage() );
+    }
 
 
-          // Pin the newly-allocated directory page.
-        hpid = nexthpid;
-        status = MINIBASE_BM->PinPage( hpid, (Page*&)pg, true /*empty*/ );
-        if ( status != OK )
-            return MINIBASE_CHAIN_ERROR( DBMGR, status );
+      // At this point, "hpid" has the page id of the header page with a free
+      // slot and "dp" has its directory_page pointer.  Both it and page 0
+      // are pinned.
 
-        dp = (directory_page*)pg;
-        init_dir_page( dp, sizeof(directory_page) );
-        free_slot = 0;
-    }
+    unsigned slot;
+    find_in_dir_page( dp, fname, slot );
 
+      // Open a gap at the sorted position.
+    memmove( &dp->entries[slot+1], &dp->entries[slot],
+             (dp->num_used - slot) * sizeof(file_entry) );
+    dp->entries[slot].pagenum = start_page_num;
+    strcpy( dp->entries[slot].fname, fname );
 
-      // At this point, "hpid" has the page id of the header page with the free
-      // slot; "pg" points to the pinned page; "dp" has the directory_page
-      // pointer; "free_slot" is the entry number in the directory where we're
-      // going to put the new file entry.
+      // The page is full now: take it off the free-slot list.
+    if ( ++dp->num_used == dp->num_entries ) {
+        fp->free_dir_page = dp->next_free;
+        dp->next_free = INVALID_PAGE;
+    }
 
-    dp->entries[free_slot].pagenum = start_page_num;
-    strcpy( dp->entries[free_slot].fname, fname );
+    dir_location loc = { start_page_num, hpid };
+    file_index[fname] = loc;
 
-    status = MINIBASE_BM->UnpinPage( hpid , true );
+    status = header.Release();
+    if ( status != OK )
+        return MINIBASE_CHAIN_ERROR( DBMGR, status );
+
+    status = first.Release();
     if ( status != OK )
         status = MINIBASE_CHAIN_ERROR( DBMGR, status );
 
@@ -403,6 +611,8 @@ Status DB::AddFileEntry(const char* fname, PageID start_page_num)
 // This function deletes the file entry corresponding to the specified
 // file from the directory maintained in the header pages of the 
 // database.
+// file_index says which directory page holds the entry, so only that page
+// is bisected.
 
 Status DB::DeleteFileEntry(const char* fname)
 {
@@ -410,59 +620,67 @@ Status DB::DeleteFileEntry(const char* fname)
     cout << "Deleting the file entry for " << fname << endl;
 #endif
 
-    char* pg = 0;
+    std::lock_guard<std::mutex> guard( dir_lock );
+    std::unordered_map<std::string, dir_location>::iterator it
+        = file_index.find( fname );
+
+    if ( it == file_index.end() )   // Entry not found - nothing deleted
+        return MINIBASE_FIRST_ERROR( DBMGR, FILE_NOT_FOUND );
+
     Status status;
+    PageGuard first, header;
+    first_page* fp = 0;
     directory_page* dp = 0;
-    bool found = false;
-    unsigned slot = 0;
-    PageID hpid, nexthpid = 0;
+    PageID hpid = it->second.dir_page;
 
-    do {
-        hpid = nexthpid;
-          // Pin the header page.
-        status = MINIBASE_BM->PinPage( hpid, (Page*&)pg );
+      // Pin page 0, in case the free-slot list changes, and then the
+      // header page, as AddFileEntry does: two directory changes then
+      // never wait on each other's latches.
+    status = MINIBASE_BM->PinPage( 0, first, PIN_WRITE );
+    if ( status != OK )
+        return MINIBASE_CHAIN_ERROR( DBMGR, status );
+    fp = (first_page*)first.GetPage();
+
+    if ( hpid == 0 )
+        dp = &fp->dir;
+    else {
+        status = MINIBASE_BM->PinPage( hpid, header, PIN_WRITE );
         if ( status != OK )
             return MINIBASE_CHAIN_ERROR( DBMGR, status );
+        dp = dir_page_of( hpid, (char*)header.GetPage() );
+    }
 
-          // This complication is because the first page has a different
-          // structure from that of subsequent pages.
-        dp = (hpid == 0)? &((first_page*)pg)->dir : (directory_page*)pg;
-        nexthpid = dp->next_page;
-
-        unsigned entry = 0;
-        while ((entry < dp->num_entries)
-               && ((dp->entries[entry].pagenum == INVALID_PAGE)
-                  || (strcmp(fname,dp->entries[entry].fname) != 0)) )
-            ++entry;
-
-        if ( entry < dp->num_entries ) {
-            slot = entry;
-            found = true;
-          } else {
-            status = MINIBASE_BM->UnpinPage( hpid );
-            if ( status != OK )
-                return MINIBASE_CHAIN_ERROR( DBMGR, status );
-          }
-    } while ( nexthpid != INVALID_PAGE && !found );
-
-
-    if ( !found )   // Entry not found - nothing deleted
+    unsigned slot;
+    if ( !find_in_dir_page( dp, fname, slot ) )
         return MINIBASE_FIRST_ERROR( DBMGR, FILE_NOT_FOUND );
 
+      // A full page gets a free slot: put it back on the free-slot list.
+    if ( dp->num_used == dp->num_entries ) {
+        dp->next_free = fp->free_dir_page;
+        fp->free_dir_page = hpid;
+    }
 
-      // Have to delete record at hpnum:slot
-    dp->entries[slot].pagenum = INVALID_PAGE;
+      // Have to delete record at hpnum:slot; close the gap.
+    dp->num_used--;
+    memmove( &dp->entries[slot], &dp->entries[slot+1],
+             (dp->num_used - slot) * sizeof(file_entry) );
+    dp->entries[dp->num_used].pagenum = INVALID_PAGE;
+    file_index.erase( it );
 
-    status = MINIBASE_BM->UnpinPage( hpid , true );
+    status = header.Release();
     if ( status != OK )
-        status = MINIBASE_CHAIN_ERROR( DBMGR, status );
+        return MINIBASE_CHAIN_ERROR( DBMGR, status );
+
+    status = first.Release();
+    if ( status != OK )
+        return MINIBASE_CHAIN_ERROR( DBMGR, status );
 
     return OK;
 }
 
 // ***************************************************************
 // This function gets the start page number for the specified file.
-// This is done by looking up the directory stored in the header pages.
+// This is a lookup in file_index; no header page is read.
 
 Status DB::GetFileEntry(const char* fname, PageID& start_page)
 {
@@ -470,48 +688,86 @@ Status DB::GetFileEntry(const char* fname, PageID& start_page)
     cout << "Getting the file entry for " << fname << endl;
 #endif
 
-    char* pg = 0;
+    std::lock_guard<std::mutex> guard( dir_lock );
+    std::unordered_map<std::string, dir_location>::const_iterator it
+        = file_index.find( fname );
+
+    if ( it == file_index.end() )   // Entry not found - don't post error, just fail.
+        return FAIL;
+
+    start_page = it->second.start_page;
+    return OK;
+}
+
+// ***************************************************************
+// This function walks the chain of directory pages once and loads every
+// entry into file_index.
+
+Status DB::load_directory()
+{
+    PageGuard header;
     Status status;
     directory_page* dp = 0;
-    bool found = false;
-    unsigned slot = 0;
     PageID hpid, nexthpid = 0;
 
+    file_index.clear();
+
     do {
         hpid = nexthpid;
           // Pin the header page.
-        status = MINIBASE_BM->PinPage( hpid, (Page*&)pg );
+        status = MINIBASE_BM->PinPage( hpid, header );
         if ( status != OK )
             return MINIBASE_CHAIN_ERROR( DBMGR, status );
 
-          // This complication is because the first page has a different
-          // structure from that of subsequent pages.
-        dp = (hpid == 0)? &((first_page*)pg)->dir : (directory_page*)pg;
+        dp = dir_page_of( hpid, (char*)header.GetPage() );
         nexthpid = dp->next_page;
 
-        unsigned entry = 0;
-        while ((entry < dp->num_entries)
-              && ((dp->entries[entry].pagenum == INVALID_PAGE)
-                 || (strcmp(fname,dp->entries[entry].fname) != 0)) )
-            ++entry;
-
-        if ( entry < dp->num_entries ) {
-            slot = entry;
-            found = true;
+        for ( unsigned entry=0; entry < dp->num_used; ++entry ) {
+            dir_location loc = { dp->entries[entry].pagenum, hpid };
+            file_index[dp->entries[entry].fname] = loc;
         }
 
-        status = MINIBASE_BM->UnpinPage( hpid );
+        status = header.Release();
         if ( status != OK )
             return MINIBASE_CHAIN_ERROR( DBMGR, status );
 
-    } while ((nexthpid != INVALID_PAGE) && !found );
+    } while ( nexthpid != INVALID_PAGE );
 
+    return OK;
+}
 
-    if ( !found )   // Entry not found - don't post error, just fail.
-        return FAIL;
+// ***************************************************************
+// Binary search of one directory page's sorted entries.
 
-    start_page = dp->entries[slot].pagenum;
-    return OK;
+bool DB::find_in_dir_page( const directory_page* dp, const char* fname,
+                           unsigned& slot )
+{
+    unsigned lo = 0, hi = dp->num_used;
+
+    while ( lo < hi ) {
+        unsigned mid = lo + (hi - lo) / 2;
+        int cmp = strcmp( dp->entries[mid].fname, fname );
+        if ( cmp == 0 ) {
+            slot = mid;
+            return true;
+        }
+        if ( cmp < 0 )
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    slot = lo;
+    return false;
+}
+
+// ***************************************************************
+// This complication is because the first page has a different
+// structure from that of subsequent pages.
+
+DB::directory_page* DB::dir_page_of( PageID hpid, char* pg )
+{
+    return (hpid == 0)? &((first_page*)pg)->dir : (directory_page*)pg;
 }
 
 // **************************************************************
@@ -530,15 +786,18 @@ Status DB::ReadPage(PageID pageno, Page* pageptr)
     if ((pageno < 0) || (pageno >= (int) num_pages))
         return MINIBASE_FIRST_ERROR( DBMGR, BAD_PAGE_NO );
 
-    // Seek to the correct page
-    if (_lseek( fd, (long)pageno*MINIBASE_PAGESIZE, SEEK_SET ) < 0 )
-        return MINIBASE_FIRST_ERROR( DBMGR, UNIX_ERROR );
-	
-	// Read the appropriate number of bytes.
-    if (_read( fd, pageptr, MINIBASE_PAGESIZE ) != MINIBASE_PAGESIZE )
-        return MINIBASE_FIRST_ERROR( DBMGR, FILE_IO_ERROR );
-
-    return OK;
+    unsigned long long start = LatencyStats::Now();
+    unsigned bytes = MINIBASE_PAGESIZE;
+    Status status;
+    if ( compressed )
+        status = read_compressed( pageno, pageptr, bytes );
+    else
+        status = storage->Read( (long long)pageno*MINIBASE_PAGESIZE, pageptr,
+                                MINIBASE_PAGESIZE );
+
+    if ( status == OK )
+        count_io( read_counts, LAT_DB_READ, pageno, bytes, start );
+    return status;
 }
 
 // ******************************************************
@@ -556,27 +815,423 @@ Status DB::WritePage(PageID pageno, Page* pageptr)
         return MINIBASE_FIRST_ERROR( DBMGR, BAD_PAGE_NO );
     }
 
-      // Seek to the correct page
-    if (_lseek( fd, (long)pageno*MINIBASE_PAGESIZE, SEEK_SET ) < 0 )
-        return MINIBASE_FIRST_ERROR( DBMGR, UNIX_ERROR );
+    unsigned long long start = LatencyStats::Now();
+    unsigned bytes = MINIBASE_PAGESIZE;
+    Status status;
+    if ( compressed )
+        status = write_compressed( pageno, pageptr, bytes );
+    else
+        status = storage->Write( (long long)pageno*MINIBASE_PAGESIZE, pageptr,
+                                 MINIBASE_PAGESIZE );
+
+    if ( status == OK )
+        count_io( write_counts, LAT_DB_WRITE, pageno, bytes, start );
+    return status;
+}
+
+// ******************************************************
+// A page that follows the last one extends its run; any other ends the
+// run and starts a new one.
+
+void DB::count_io( io_counts& counts, LatencyOp op, PageID pageno,
+                   unsigned bytes, unsigned long long start )
+{
+    io_latency.Record( op, start );
+
+    std::lock_guard<std::mutex> guard( stat_lock );
+    counts.calls++;
+    counts.bytes += bytes;
+    if ( counts.last != INVALID_PAGE && pageno == counts.last + 1 ) {
+        counts.sequential++;
+        counts.run++;
+    } else {
+        if ( counts.run > 0 )
+            counts.runs[run_bucket( counts.run )]++;
+        counts.run = 1;
+    }
+    counts.last = pageno;
+}
+
+// ******************************************************
+// The pages of a compressed database are no use without the page map that
+// says where they are, so its map is saved too; save_page_map makes the
+// pages durable first.  Writes wait until it is done.
+
+Status DB::Sync()
+{
+    if ( !compressed || !storage->IsPersistent() )
+        return storage->Sync();
+
+    std::lock_guard<std::mutex> guard( io_lock );
+    return save_page_map();
+}
+
+// ******************************************************
+// Read a page of a compressed database: find its extent in page_map, read
+// the stored bytes and decompress them into the page.
+
+Status DB::read_compressed( PageID pageno, Page* pageptr, unsigned& bytes )
+{
+    std::lock_guard<std::mutex> guard( io_lock );
+    const page_extent& ext = page_map[pageno];
+
+    bytes = ext.units ? ext.length : 0;
+    if ( ext.units == 0 ) {
+        memset( (char*)pageptr, 0, MINIBASE_PAGESIZE );
+        return OK;
+    }
+
+    long long offset = (long long)ext.unit*compress_unit;
+    if ( ext.length == MINIBASE_PAGESIZE )
+        return storage->Read( offset, pageptr, MINIBASE_PAGESIZE );
+
+    char stored[MINIBASE_PAGESIZE];
+    Status s = storage->Read( offset, stored, ext.length );
+    if ( s != OK )
+        return s;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int length = PageDecompress( stored, ext.length, (char*)pageptr,
+                                 MINIBASE_PAGESIZE );
+    decompress_secs += seconds_since( start );
+    pages_decompressed++;
+
+    if ( length != MINIBASE_PAGESIZE )
+        return MINIBASE_FIRST_ERROR( DBMGR, FILE_IO_ERROR );
+
+    return OK;
+}
+
+// ******************************************************
+// Write a page of a compressed database.  The page keeps its extent if the
+// new image needs the same number of units and the saved page map does not
+// point at it; otherwise it moves to a new extent (see move_extent).  A
+// page that would not save at least one unit is stored raw.
+
+Status DB::write_compressed( PageID pageno, Page* pageptr, unsigned& bytes )
+{
+    char packed[MINIBASE_PAGESIZE];
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int length = PageCompress( (const char*)pageptr, MINIBASE_PAGESIZE, packed,
+                               MINIBASE_PAGESIZE - compress_unit );
+    double secs = seconds_since( start );
+
+    const char* image = packed;
+    if ( length == 0 ) {
+        image = (const char*)pageptr;
+        length = MINIBASE_PAGESIZE;
+    }
+    unsigned short units = (unsigned short)((length + compress_unit - 1) / compress_unit);
+
+    std::lock_guard<std::mutex> guard( io_lock );
+    page_extent& ext = page_map[pageno];
+
+    if ( ext.units != units || extent_saved[pageno] )
+        move_extent( pageno, units );
+    ext.length = (unsigned short)length;
+
+    compress_secs += secs;
+    if ( image == packed )
+        pages_compressed++;
+    else
+        pages_stored_raw++;
+    bytes_in += MINIBASE_PAGESIZE;
+    bytes_stored += length;
+
+    bytes = length;
+    return storage->Write( (long long)ext.unit*compress_unit, image, length );
+}
+
+// ******************************************************
+// Give a page a new extent of the given number of units: the smallest hole
+// that fits, or else the end of the file.  Its old extent is free at once,
+// unless the saved page map points at it.  io_lock must be held.
+
+void DB::move_extent( PageID pageno, unsigned short units )
+{
+    page_extent& ext = page_map[pageno];
+
+    if ( ext.units != 0 ) {
+        if ( extent_saved[pageno] )
+            saved_frees.push_back( ext );
+        else
+            free_units.MarkFree( ext.unit, ext.units );
+    }
+    extent_saved[pageno] = false;
+
+    if ( units == 0 ) {
+        ext.units = 0;
+        ext.length = 0;
+        return;
+    }
+
+    PageID at = free_units.FindRun( units, BEST_FIT );
+    if ( at == INVALID_PAGE ) {
+        at = file_units;
+        file_units += units;
+    } else
+        free_units.MarkUsed( at, units );
+
+    ext.unit = at;
+    ext.units = units;
+}
+
+// ******************************************************
+// Forget the stored images of a run of deallocated pages.
+
+void DB::free_compressed( PageID start_page_num, unsigned run_size )
+{
+    std::lock_guard<std::mutex> guard( io_lock );
+
+    for ( unsigned i=0; i < run_size; ++i )
+        move_extent( start_page_num + i, 0 );
+}
+
+// ******************************************************
+// The page map file: a header, then one page_extent per page.
+
+struct page_map_header {
+    char     magic[4];          // "MBPM"
+    unsigned num_pages;
+    unsigned file_units;
+};
+
+char* DB::page_map_name() const
+{
+    char* map_name = new char[strlen(name) + sizeof(".pagemap")];
+    strcpy( map_name, name );
+    strcat( map_name, ".pagemap" );
+    return map_name;
+}
+
+// ******************************************************
+// Load the page map if there is one, making this a compressed database.
+// The holes in the file are whatever units no page's extent covers.
+
+Status DB::load_page_map()
+{
+    char* map_name = page_map_name();
+    FILE* f = fopen( map_name, "rb" );
+    delete [] map_name;
+
+    if ( f == NULL )
+        return OK;      // Not a compressed database.
+
+    page_map_header hdr;
+    if ( fread( &hdr, sizeof hdr, 1, f ) != 1
+         || memcmp( hdr.magic, "MBPM", 4 ) != 0 ) {
+        fclose( f );
+        return MINIBASE_FIRST_ERROR( DBMGR, FILE_IO_ERROR );
+    }
 
-      // Write the appropriate number of bytes.
-    if (_write( fd, pageptr, MINIBASE_PAGESIZE ) != MINIBASE_PAGESIZE )
+    page_map.resize( hdr.num_pages );
+    if ( hdr.num_pages > 0
+         && fread( &page_map[0], sizeof(page_extent), hdr.num_pages, f ) != hdr.num_pages ) {
+        fclose( f );
         return MINIBASE_FIRST_ERROR( DBMGR, FILE_IO_ERROR );
+    }
+    fclose( f );
+
+    compressed = true;
+    extent_saved.assign( hdr.num_pages, true );
+    file_units = hdr.file_units;
+    free_units.Clear();
+    free_units.MarkFree( 0, file_units );
+    for ( unsigned i=0; i < page_map.size(); ++i )
+        if ( page_map[i].units != 0 )
+            free_units.MarkUsed( page_map[i].unit, page_map[i].units );
+
+    return OK;
+}
+
+// ******************************************************
+// Save the page map so that a crash at any point leaves a usable one: the
+// pages it points at are made durable first, and it is written to a new
+// file that then replaces the old map.  The extents only the old map
+// pointed at are free once that is done.  io_lock must be held.
+
+Status DB::save_page_map()
+{
+    Status status = storage->Sync();
+    if ( status != OK )
+        return status;
+
+    char* map_name = page_map_name();
+    std::string temp_name = std::string( map_name ) + ".new";
+
+    page_map_header hdr;
+    memcpy( hdr.magic, "MBPM", 4 );
+    hdr.num_pages = (unsigned)page_map.size();
+    hdr.file_units = file_units;
+
+    FileStorage map_file;
+    status = map_file.Open( temp_name.c_str(), STORE_NEW );
+    if ( status == OK )
+        status = map_file.Write( 0, &hdr, sizeof hdr );
+    if ( status == OK && hdr.num_pages > 0 )
+        status = map_file.Write( sizeof hdr, &page_map[0],
+                                 hdr.num_pages*sizeof(page_extent) );
+    if ( status == OK )
+        status = map_file.Sync();
+    map_file.Close();
+    if ( status == OK )
+        status = FileStorage::Replace( temp_name.c_str(), map_name );
+    delete [] map_name;
+
+    if ( status != OK ) {
+        remove( temp_name.c_str() );
+        return MINIBASE_CHAIN_ERROR( DBMGR, status );
+    }
+
+    for ( unsigned i=0; i < saved_frees.size(); ++i )
+        free_units.MarkFree( saved_frees[i].unit, saved_frees[i].units );
+    saved_frees.clear();
+    for ( unsigned i=0; i < page_map.size(); ++i )
+        extent_saved[i] = page_map[i].units != 0;
 
     return OK;
 }
 
+// ******************************************************
+
+void DB::ResetStat()
+{
+    pages_compressed = 0;
+    pages_stored_raw = 0;
+    pages_decompressed = 0;
+    bytes_in = 0;
+    bytes_stored = 0;
+    compress_secs = 0;
+    decompress_secs = 0;
+
+    std::lock_guard<std::mutex> guard( stat_lock );
+    io_counts* both[2] = { &read_counts, &write_counts };
+    for ( int i=0; i < 2; ++i ) {
+        io_counts& c = *both[i];
+        c.calls = c.bytes = c.sequential = 0;
+        c.last = INVALID_PAGE;
+        c.run = 0;
+        for ( int b=0; b < DBIOStats::RUN_BUCKETS; ++b )
+            c.runs[b] = 0;
+    }
+    io_latency.Reset();
+}
+
+// ******************************************************
+// The run in progress is counted as if it had ended.
+
+void DB::GetIOStats( DBIOStats& stats )
+{
+    {
+        std::lock_guard<std::mutex> guard( stat_lock );
+        const io_counts* from[2] = { &read_counts, &write_counts };
+        DBIOStats::Counts* to[2] = { &stats.reads, &stats.writes };
+        for ( int i=0; i < 2; ++i ) {
+            to[i]->calls = from[i]->calls;
+            to[i]->bytes = from[i]->bytes;
+            to[i]->sequential = from[i]->sequential;
+            for ( int b=0; b < DBIOStats::RUN_BUCKETS; ++b )
+                to[i]->runs[b] = from[i]->runs[b];
+            if ( from[i]->run > 0 )
+                to[i]->runs[run_bucket( from[i]->run )]++;
+        }
+    }
+    stats.reads.latency = io_latency.GetSummary( LAT_DB_READ );
+    stats.writes.latency = io_latency.GetSummary( LAT_DB_WRITE );
+}
+
+// ******************************************************
+
+void DB::PrintStat()
+{
+    cout<<"**DB Statistics**"<<endl;
+
+    DBIOStats io;
+    GetIOStats( io );
+    const char* names[2] = { "Read", "Written" };
+    const DBIOStats::Counts* counts[2] = { &io.reads, &io.writes };
+    for ( int i=0; i < 2; ++i ) {
+        const DBIOStats::Counts& c = *counts[i];
+        long long runs = 0;
+        for ( int b=0; b < DBIOStats::RUN_BUCKETS; ++b )
+            runs += c.runs[b];
+        cout<<"Pages "<<names[i]<<": "<<c.calls<<" ("<<c.sequential<<" sequential, "
+            <<c.bytes/1024<<" KB), mean run "<<(runs > 0 ? (double)c.calls / runs : 0)
+            <<" pages, p50 "<<(long long)c.latency.p50<<" ns, p99 "
+            <<(long long)c.latency.p99<<" ns"<<endl;
+    }
+
+    if ( !compressed ) {
+        cout<<"Storage: uncompressed"<<endl;
+        return;
+    }
+
+    long pages_written = pages_compressed + pages_stored_raw;
+    cout<<"Storage: compressed, "<<file_units*compress_unit/1024
+        <<" KB file for "<<num_pages*MINIBASE_PAGESIZE/1024<<" KB of pages"<<endl;
+    cout<<"Pages Written Compressed: "<<pages_compressed<<endl;
+    cout<<"Pages Written Raw (incompressible): "<<pages_stored_raw<<endl;
+    cout<<"Compression Ratio: "
+        <<(bytes_stored > 0 ? bytes_in / bytes_stored : 0)<<endl;
+    cout<<"Compress Time per Page (us): "
+        <<(pages_written > 0 ? compress_secs * 1e6 / pages_written : 0)<<endl;
+    cout<<"Pages Read Compressed: "<<pages_decompressed<<endl;
+    cout<<"Decompress Time per Page (us): "
+        <<(pages_decompressed > 0 ? decompress_secs * 1e6 / pages_decompressed : 0)<<endl;
+}
+
+// *******************************************************
+// Set bits [first_bit, last_bit] (inclusive) of one space-map page to the
+// given value.  The whole 64-bit words inside the range are filled with a
+// single memset; only the (at most two) words at its edges need a mask.
+// Map words are read little-endian, so bit n of the word is bit n%8 of
+// byte n/8, matching the byte-wise layout used everywhere else.
+
+static void set_bit_range( char* map, unsigned first_bit, unsigned last_bit,
+                           int bit )
+{
+    unsigned first_word = first_bit / 64;
+    unsigned last_word  = last_bit / 64;
+
+    uint64_t head_mask = ~(uint64_t)0 << (first_bit % 64);
+    uint64_t tail_mask = ~(uint64_t)0 >> (63 - last_bit % 64);
+
+    if ( first_word == last_word )
+        head_mask &= tail_mask;
+
+    uint64_t word;
+    memcpy( &word, map + first_word*8, sizeof word );
+    word = bit ? (word | head_mask) : (word & ~head_mask);
+    memcpy( map + first_word*8, &word, sizeof word );
+
+    if ( first_word == last_word )
+        return;
+
+    if ( last_word > first_word + 1 )
+        memset( map + (first_word+1)*8, bit ? 0xff : 0,
+                (last_word - first_word - 1) * 8 );
+
+    memcpy( &word, map + last_word*8, sizeof word );
+    word = bit ? (word | tail_mask) : (word & ~tail_mask);
+    memcpy( map + last_word*8, &word, sizeof word );
+}
+
 // *******************************************************
 // The following function sets a given number of page bits in the
-// space map to the given bit value.  This function is used both
+// space map to the given value.  This function is used both
 // for allocating and deallocating pages in the space map.
+// Each space-map page the run touches is pinned once and unpinned dirty
+// once, however long the run is.
 
 Status DB::set_bits( PageID start_page, unsigned run_size, int bit )
 {
     if ((start_page < 0) || (start_page+run_size > num_pages))
         return MINIBASE_FIRST_ERROR( DBMGR, BAD_PAGE_NO );
 
+    if ( run_size == 0 )
+        return OK;
+
 #ifdef DEBUG
     printf("set_bits:: space_map_before \n");
     dump_space_map();
@@ -595,41 +1250,22 @@ Status DB::set_bits( PageID start_page, unsigned run_size, int bit )
         Status status;
 
           // Pin the space-map page.
-        char* pg;
-        status = MINIBASE_BM->PinPage( pgid, (Page*&)pg );
+        PageGuard map;
+        status = MINIBASE_BM->PinPage( pgid, map, PIN_WRITE );
         if ( status != OK )
             return MINIBASE_CHAIN_ERROR( DBMGR, status );
 
 
           // Locate the piece of the run that fits on this page.
-        unsigned first_byte_no = first_bit_no / 8;
-        unsigned first_bit_offset = first_bit_no % 8;
         unsigned last_bit_no = first_bit_no + run_size - 1;
-
-        if ( last_bit_no >= bits_per_page )
+        if ( last_bit_no >= (unsigned) bits_per_page )
             last_bit_no = bits_per_page - 1;
-        unsigned last_byte_no = last_bit_no / 8;
-
-          // Find the start of this page's piece of the run.
-        char* p   = pg + first_byte_no;
-        char* end = pg + last_byte_no;
 
-          // This loop actually flips the bits on the current page.
-        for ( ; p <= end; ++p, first_bit_offset=0 ) {
-
-            unsigned max_bits_this_byte = 8 - first_bit_offset;
-            unsigned num_bits_this_byte = (run_size > max_bits_this_byte?
-                                           max_bits_this_byte : run_size);
-            unsigned mask = ((1 << num_bits_this_byte) - 1) << first_bit_offset;
-            if ( bit ) 
-                *p |= mask;
-            else
-                *p &= ~mask;
-            run_size -= num_bits_this_byte;
-        }
+        set_bit_range( (char*)map.GetPage(), first_bit_no, last_bit_no, bit );
+        run_size -= last_bit_no - first_bit_no + 1;
 
           // Unpin the space-map page.
-        status = MINIBASE_BM->UnpinPage(pgid, true);
+        status = map.Release();
         if ( status != OK )
             return MINIBASE_CHAIN_ERROR( DBMGR, status );
     }
@@ -649,13 +1285,69 @@ Status DB::set_bits( PageID start_page, unsigned run_size, int bit )
 void DB::init_dir_page( directory_page* dp, unsigned used_bytes )
 {
     dp->next_page = INVALID_PAGE;
+    dp->next_free = INVALID_PAGE;
+    dp->num_used = 0;
     dp->num_entries = (MAX_SPACE - used_bytes) / sizeof(file_entry);
-	dp->entries = (file_entry *)malloc(sizeof(file_entry)*dp->num_entries);
 
     for ( unsigned index=0; index < dp->num_entries; ++index )
         dp->entries[index].pagenum = INVALID_PAGE;
 }
 
+// *******************************************************
+// Rebuild the free-extent index by walking the space map once and
+// recording every maximal run of 0 bits.
+
+Status DB::build_extent_index()
+{
+    unsigned num_map_pages = (num_pages + bits_per_page - 1) / bits_per_page;
+    PageID page_no = 0;
+    PageID run_start = INVALID_PAGE;
+
+    free_extents.Clear();
+
+      // This loop goes over each page in the space map.
+    for( unsigned i=0; i < num_map_pages; ++i ) {
+        PageID pgid = 1 + i;    // The space map starts at page #1.
+
+          // Pin the space-map page.
+        PageGuard map;
+        Status status;
+        status = MINIBASE_BM->PinPage( pgid, map );
+        if ( status != OK )
+            return MINIBASE_CHAIN_ERROR( DBMGR, status );
+        char* pg = (char*)map.GetPage();
+
+          // How many bits should we examine on this page?
+        unsigned num_bits_this_page = num_pages - i*bits_per_page;
+        if ( num_bits_this_page > bits_per_page )
+            num_bits_this_page = bits_per_page;
+
+        for ( ; num_bits_this_page > 0; ++pg )
+            for ( unsigned mask=1;
+                  mask < 256 && num_bits_this_page > 0;
+                  mask <<= 1, --num_bits_this_page, ++page_no ) {
+
+                if ( *pg & mask ) {
+                    if ( run_start != INVALID_PAGE )
+                        free_extents.MarkFree( run_start, page_no - run_start );
+                    run_start = INVALID_PAGE;
+                }
+                else if ( run_start == INVALID_PAGE )
+                    run_start = page_no;
+            }
+
+          // Unpin the space-map page.
+        status = map.Release();
+        if ( status != OK )
+            return MINIBASE_CHAIN_ERROR( DBMGR, status );
+    }
+
+    if ( run_start != INVALID_PAGE )
+        free_extents.MarkFree( run_start, page_no - run_start );
+
+    return OK;
+}
+
 // *******************************************************
 
 Status DB::dump_space_map()
@@ -668,11 +1360,12 @@ Status DB::dump_space_map()
         PageID pgid = 1 + i;    // The space map starts at page #1.
 
           // Pin the space-map page.
-        char* pg;
+        PageGuard map;
         Status status;
-        status = MINIBASE_BM->PinPage( pgid, (Page*&)pg );
+        status = MINIBASE_BM->PinPage( pgid, map );
         if ( status != OK )
             return MINIBASE_CHAIN_ERROR( DBMGR, status );
+        char* pg = (char*)map.GetPage();
 
 
           // How many bits should we examine on this page?
@@ -703,7 +1396,7 @@ Status DB::dump_space_map()
 
 
           // Unpin the space-map page.
-        status = MINIBASE_BM->UnpinPage( pgid );
+        status = map.Release();
         if ( status != OK )
             return MINIBASE_CHAIN_ERROR( DBMGR, status );
     }
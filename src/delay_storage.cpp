@@ -0,0 +1,206 @@
+#include <math.h>
+#include <string>
+#include <thread>
+
+#include "delay_storage.h"
+#include "replacer_registry.h"
+
+struct DevicePreset {
+    const char* name;
+    DeviceModel model;
+    const char* description;
+};
+
+// Rough figures for common devices.  The disk averages about 8 ms of seek
+// and 4 ms of rotation on a random access.
+static const DevicePreset presets[] = {
+    { "hdd", {  100,  100, 0.1,  150,  1, 15, 1, 7200 }, "7200 rpm disk, one request at a time" },
+    { "ssd", {   90,   30, 0.3, 2000, 32,  0, 0,    0 }, "NVMe flash" },
+    { "net", {  600,  800, 0.5,  250, 16,  0, 0,    0 }, "network block volume" },
+    { "ram", {    0,    0,   0,    0,  1,  0, 0,    0 }, "no delay; only the queue is modelled" },
+};
+
+static const int numPresets = sizeof(presets) / sizeof(presets[0]);
+
+DelayStorage* DelayStorage::Create( const char* spec, Storage* inner )
+{
+	std::string text(spec ? spec : "");
+	size_t colon = text.find(':');
+	std::string name = text.substr(0, colon);
+
+	int p = 0;
+	while (p < numPresets && name != presets[p].name) p++;
+	if (p == numPresets) return NULL;
+
+	ReplacerParams params;
+	if (colon != std::string::npos && !params.Parse(text.substr(colon + 1))) return NULL;
+
+	DeviceModel m = presets[p].model;
+	bool ok = true;
+	m.readUs = params.GetDouble("read_us", m.readUs, ok);
+	m.writeUs = params.GetDouble("write_us", m.writeUs, ok);
+	m.jitter = params.GetDouble("jitter", m.jitter, ok);
+	m.mbps = params.GetDouble("mbps", m.mbps, ok);
+	m.queueDepth = params.GetInt("qd", m.queueDepth, ok);
+	m.seekMs = params.GetDouble("seek_ms", m.seekMs, ok);
+	m.trackSeekMs = params.GetDouble("track_ms", m.trackSeekMs, ok);
+	m.rpm = params.GetDouble("rpm", m.rpm, ok);
+
+	if (!ok || params.FirstUnused() != NULL || m.readUs < 0 || m.writeUs < 0 || m.jitter < 0
+		|| m.mbps < 0 || m.queueDepth < 1 || m.seekMs < 0 || m.trackSeekMs < 0
+		|| m.trackSeekMs > m.seekMs || m.rpm < 0)
+		return NULL;
+
+	return new DelayStorage(m, inner);
+}
+
+void DelayStorage::List( std::ostream& out )
+{
+	for (int p = 0; p < numPresets; p++)
+		out << "  " << presets[p].name << "\t" << presets[p].description << "\n";
+	out << "Parameters: read_us, write_us (median service time), jitter (lognormal sigma),\n"
+		<< "  mbps (0: unlimited), qd (queue depth), seek_ms, track_ms (full-stroke and\n"
+		<< "  shortest seek; 0: no head), rpm (0: no spindle).  Example: hdd:rpm=5400\n";
+}
+
+DelayStorage::DelayStorage( const DeviceModel& model, Storage* inner )
+	: model(model), inner(inner), slotFree(model.queueDepth)
+{
+	head = 0;
+	span = 0;
+	random = 0x9E3779B97F4A7C15ULL;
+	delaySecs = 0;
+}
+
+DelayStorage::~DelayStorage()
+{
+	delete inner;
+}
+
+Status DelayStorage::Open( const char* name, StorageMode mode ) { return inner->Open(name, mode); }
+void DelayStorage::Close() { inner->Close(); }
+bool DelayStorage::IsPersistent() const { return inner->IsPersistent(); }
+
+Status DelayStorage::Read( long long offset, void* buf, unsigned length )
+{
+	Clock::time_point done = Schedule(offset, length, model.readUs);
+	Status status = inner->Read(offset, buf, length);
+	WaitUntil(done);
+	return status;
+}
+
+Status DelayStorage::Write( long long offset, const void* buf, unsigned length )
+{
+	Clock::time_point done = Schedule(offset, length, model.writeUs);
+	Status status = inner->Write(offset, buf, length);
+	WaitUntil(done);
+	return status;
+}
+
+// A sync finishes when every request already queued has.
+Status DelayStorage::Sync()
+{
+	Clock::time_point done = Clock::now();
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		for (size_t i = 0; i < slotFree.size(); i++)
+			if (slotFree[i] > done) done = slotFree[i];
+	}
+	WaitUntil(done);
+	return inner->Sync();
+}
+
+// Setting the size up is free, but tells the seek model how far the head
+// can travel.
+Status DelayStorage::Allocate( long long size )
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		if (size > span) span = size;
+	}
+	return inner->Allocate(size);
+}
+
+double DelayStorage::GetDelaySeconds()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return delaySecs;
+}
+
+//--------------------------------------------------------------------
+// DelayStorage::Schedule
+//
+// Input    : offset, length - the request
+//            medianUs       - its median service time
+// Purpose  : Give the request the slot that is idle first, and book the
+//            slot and the bus for as long as the model says it takes.
+//            The seek is track + (full - track) * sqrt(distance / span),
+//            which grows like a real arm's; the rotation is uniform over
+//            one turn.
+// Return   : when the request finishes.
+//--------------------------------------------------------------------
+DelayStorage::Clock::time_point DelayStorage::Schedule( long long offset, unsigned length, double medianUs )
+{
+	Clock::time_point now = Clock::now();
+	std::lock_guard<std::mutex> guard(lock);
+
+	double us = medianUs;
+	if (model.jitter > 0) us *= exp(model.jitter * NextNormal());
+
+	if (offset != head) {
+		if (model.seekMs > 0) {
+			if (offset + length > span) span = offset + length;
+			double distance = (double)(offset > head ? offset - head : head - offset);
+			us += 1000 * (model.trackSeekMs
+			              + (model.seekMs - model.trackSeekMs) * sqrt(distance / span));
+		}
+		if (model.rpm > 0) us += NextDouble() * 60e6 / model.rpm;
+	}
+	head = offset + length;
+
+	size_t slot = 0;
+	for (size_t i = 1; i < slotFree.size(); i++)
+		if (slotFree[i] < slotFree[slot]) slot = i;
+
+	Clock::time_point done = (slotFree[slot] > now) ? slotFree[slot] : now;
+	done += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::micro>(us));
+
+	if (model.mbps > 0) {
+		if (busFree > done) done = busFree;
+		done += std::chrono::duration_cast<Clock::duration>(
+			std::chrono::duration<double, std::micro>(length / model.mbps));
+		busFree = done;
+	}
+
+	slotFree[slot] = done;
+	delaySecs += std::chrono::duration<double>(done - now).count();
+	return done;
+}
+
+void DelayStorage::WaitUntil( Clock::time_point done )
+{
+	const Clock::duration spin = std::chrono::microseconds(100);
+
+	Clock::time_point now = Clock::now();
+	if (done - now > spin)
+		std::this_thread::sleep_until(done - spin);
+	while (Clock::now() < done)
+		std::this_thread::yield();
+}
+
+// xorshift64*, in [0, 1).
+double DelayStorage::NextDouble()
+{
+	random ^= random >> 12;
+	random ^= random << 25;
+	random ^= random >> 27;
+	return ((random * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Box-Muller.
+double DelayStorage::NextNormal()
+{
+	double u = NextDouble();
+	if (u < 1e-300) u = 1e-300;
+	return sqrt(-2 * log(u)) * cos(6.283185307179586 * NextDouble());
+}
@@ -0,0 +1,223 @@
+#include <algorithm>
+
+#include "extent_index.h"
+
+
+// SCHEMA FOR THE FREE-EXTENT INDEX
+// Every free extent appears exactly once in byStart, once in bySize and as
+// the leaf of its start page in the segment tree.  Extents never overlap or
+// touch: MarkFree coalesces neighbours, so each entry is a maximal run of
+// free pages.
+
+ExtentIndex::ExtentIndex() {
+	numFreePages = 0;
+	leaves = 0;
+}
+
+ExtentIndex::~ExtentIndex() {
+	Clear();
+}
+
+void ExtentIndex::Clear() {
+	byStart.clear();
+	bySize.clear();
+	longest.clear();
+	leaves = 0;
+	numFreePages = 0;
+}
+
+//--------------------------------------------------------------------
+// ExtentIndex::Grow
+//
+// Input    : pages - a page count the tree must cover
+// Purpose  : Double the tree's leaves until there are at least pages,
+//            and rebuild it from byStart.  The file only grows, so this
+//            happens a few times over the life of a DB.
+//--------------------------------------------------------------------
+void ExtentIndex::Grow(PageID pages) {
+	unsigned size = leaves ? leaves : 1;
+	while (size < (unsigned)pages)
+		size *= 2;
+
+	leaves = size;
+	longest.assign(2 * leaves, 0);
+	for (StartMap::const_iterator it = byStart.begin(); it != byStart.end(); ++it)
+		longest[leaves + it->first] = it->second;
+	for (unsigned node = leaves - 1; node >= 1; node--)
+		longest[node] = std::max(longest[2 * node], longest[2 * node + 1]);
+}
+
+// Set the leaf of start and the maxima above it, stopping at the first
+// one that does not change.
+void ExtentIndex::SetLength(PageID start, unsigned runSize) {
+	if ((unsigned)start >= leaves) {
+		Grow(start + 1);
+		return;
+	}
+
+	unsigned node = leaves + start;
+	longest[node] = runSize;
+	for (node /= 2; node >= 1; node /= 2) {
+		unsigned most = std::max(longest[2 * node], longest[2 * node + 1]);
+		if (longest[node] == most) break;
+		longest[node] = most;
+	}
+}
+
+void ExtentIndex::Insert(PageID start, unsigned runSize) {
+	byStart[start] = runSize;
+	bySize.insert(std::make_pair(runSize, start));
+	SetLength(start, runSize);
+	numFreePages += runSize;
+}
+
+void ExtentIndex::Erase(StartMap::iterator it) {
+	bySize.erase(std::make_pair(it->second, it->first));
+	numFreePages -= it->second;
+	PageID start = it->first;
+	byStart.erase(it);
+	SetLength(start, 0);
+}
+
+//--------------------------------------------------------------------
+// ExtentIndex::MarkFree
+//
+// Input    : start, runSize - the run of pages that became free
+// PostCond : The run, merged with any extent it overlaps or touches,
+//            is in the index as a single extent.
+//--------------------------------------------------------------------
+void ExtentIndex::MarkFree(PageID start, unsigned runSize) {
+	if (runSize == 0) return;
+
+	PageID end = start + runSize;
+
+	// Merge with the extent that starts before us if it reaches us.
+	StartMap::iterator it = byStart.upper_bound(start);
+	if (it != byStart.begin()) {
+		StartMap::iterator prev = it;
+		--prev;
+		PageID prevEnd = prev->first + prev->second;
+		if (prevEnd >= start) {
+			start = prev->first;
+			if (prevEnd > end) end = prevEnd;
+			Erase(prev);
+		}
+	}
+
+	// Swallow every extent that starts inside or right after us.
+	while (it != byStart.end() && it->first <= end) {
+		PageID itEnd = it->first + it->second;
+		if (itEnd > end) end = itEnd;
+		StartMap::iterator next = it;
+		++next;
+		Erase(it);
+		it = next;
+	}
+
+	Insert(start, end - start);
+}
+
+//--------------------------------------------------------------------
+// ExtentIndex::MarkUsed
+//
+// Input    : start, runSize - the run of pages that became allocated
+// PostCond : No extent in the index overlaps the run.  The parts of
+//            extents left on either side of it remain free.
+//--------------------------------------------------------------------
+void ExtentIndex::MarkUsed(PageID start, unsigned runSize) {
+	if (runSize == 0) return;
+
+	PageID end = start + runSize;
+
+	StartMap::iterator it = byStart.upper_bound(start);
+	if (it != byStart.begin()) {
+		--it;
+		if (it->first + (PageID)it->second <= start)
+			++it;
+	}
+
+	while (it != byStart.end() && it->first < end) {
+		PageID extStart = it->first;
+		PageID extEnd = it->first + it->second;
+		StartMap::iterator next = it;
+		++next;
+		Erase(it);
+		if (extStart < start) Insert(extStart, start - extStart);
+		if (extEnd > end) Insert(end, extEnd - end);
+		it = next;
+	}
+}
+
+//--------------------------------------------------------------------
+// ExtentIndex::FindRun
+//
+// Input    : runSize - number of contiguous pages wanted
+//            policy  - FIRST_FIT, BEST_FIT or NEXT_FIT
+//            cursor  - where NEXT_FIT starts looking
+// Purpose  : Pick a free extent of at least runSize pages.
+// Return   : the first page of the chosen extent, INVALID_PAGE if no
+//            extent is big enough.
+// Note     : Best-fit is a single lower_bound on bySize.  First-fit and
+//            next-fit are FindFirstFrom, from page 0 or from the cursor.
+//            Next-fit may return the cursor itself, inside an extent.
+//--------------------------------------------------------------------
+PageID ExtentIndex::FindRun(unsigned runSize, AllocPolicy policy, PageID cursor) const {
+	if (runSize == 0) runSize = 1;
+
+	if (policy == BEST_FIT) {
+		SizeSet::const_iterator it = bySize.lower_bound(std::make_pair(runSize, (PageID)INVALID_PAGE));
+		return (it == bySize.end()) ? INVALID_PAGE : it->second;
+	}
+
+	if (policy == NEXT_FIT && cursor > 0) {
+		PageID start = FindFirstFrom(runSize, cursor);
+		if (start != INVALID_PAGE) return start;
+	}
+
+	return FindFirstFrom(runSize, 0);
+}
+
+//--------------------------------------------------------------------
+// ExtentIndex::FindFirstFrom
+//
+// Return   : the lowest page at or after from where runSize free pages
+//            start, INVALID_PAGE if none.  That is from itself if the
+//            extent holding it has runSize pages left from there, and
+//            otherwise the first extent starting after from that is
+//            long enough.
+//--------------------------------------------------------------------
+PageID ExtentIndex::FindFirstFrom(unsigned runSize, PageID from) const {
+	StartMap::const_iterator it = byStart.upper_bound(from);
+	if (it != byStart.begin()) {
+		--it;
+		if (it->first + (long long)it->second - from >= runSize)
+			return from;
+	}
+
+	if (leaves == 0) return INVALID_PAGE;
+	return FirstFit(1, 0, leaves, from, runSize);
+}
+
+// The first leaf in [lo, hi), the span of node, at or after from whose
+// extent holds runSize pages.  A subtree is entered only if its longest
+// extent is long enough, so the walk visits O(log leaves) nodes.
+PageID ExtentIndex::FirstFit(unsigned node, PageID lo, PageID hi, PageID from, unsigned runSize) const {
+	if (hi <= from || longest[node] < runSize) return INVALID_PAGE;
+	if (node >= leaves) return lo;
+
+	PageID mid = lo + (hi - lo) / 2;
+	PageID found = FirstFit(2 * node, lo, mid, from, runSize);
+	return (found != INVALID_PAGE) ? found : FirstFit(2 * node + 1, mid, hi, from, runSize);
+}
+
+unsigned ExtentIndex::GetNumFreePages() const {
+	return numFreePages;
+}
+
+unsigned ExtentIndex::GetNumExtents() const {
+	return (unsigned)byStart.size();
+}
+
+unsigned ExtentIndex::GetLargestRun() const {
+	return bySize.empty() ? 0 : bySize.rbegin()->first;
+}
@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+
+using namespace std;
+
+#include "file_cache.h"
+#include "bufmgr.h"
+
+
+// SCHEMA FOR THE FILE CACHE
+// Slot s is bytes [s*MINIBASE_PAGESIZE, (s+1)*MINIBASE_PAGESIZE) of the
+// file.  index and slotPage are inverses over the occupied slots; the other
+// slots are on freeSlots.  Only when freeSlots is empty does the CLOCK hand
+// sweep for a victim, clearing reference bits as it goes.
+
+FileCache::FileCache(const char* path, unsigned numSlots, Status& status) {
+	this->path = new char[strlen(path) + 1];
+	strcpy(this->path, path);
+	this->numSlots = numSlots;
+	admitAll = false;
+
+	slotPage.assign(numSlots, INVALID_PAGE);
+	referenced.assign(numSlots, 0);
+	for (unsigned s = numSlots; s > 0; s--)
+		freeSlots.push_back(s - 1);
+	hand = 0;
+	offerSeq = 0;
+
+	isOpen = (file.Open(path, STORE_TEMPORARY) == OK);
+	status = isOpen ? OK : MINIBASE_FIRST_ERROR(BUFMGR, CACHE_FILE_ERROR);
+}
+
+FileCache::~FileCache() {
+	delete [] path;
+}
+
+void FileCache::SetAdmitAll(bool on) {
+	admitAll = on;
+}
+
+unsigned FileCache::GetNumPages() const {
+	return (unsigned)index.size();
+}
+
+bool FileCache::Lookup(PageID pid, Page* page) {
+	numLookups++;
+
+	std::unordered_map<PageID, unsigned>::iterator found = index.find(pid);
+	if (found == index.end()) return false;
+
+	unsigned slot = found->second;
+	if (file.Read((long long)slot * MINIBASE_PAGESIZE, page, MINIBASE_PAGESIZE) != OK) {
+		Drop(slot);
+		return false;
+	}
+
+	referenced[slot] = 1;
+	numHits++;
+	return true;
+}
+
+bool FileCache::Contains(PageID pid) {
+	return index.find(pid) != index.end();
+}
+
+//--------------------------------------------------------------------
+// FileCache::Put
+//
+// Input    : pid, page - a clean page leaving the buffer pool
+// PostCond : If admitted, the page is in a slot of the file, evicting
+//            another page if there was no free slot.  A page that
+//            cannot be written is not cached.
+//--------------------------------------------------------------------
+void FileCache::Put(PageID pid, const Page* page) {
+	Invalidate(pid);
+
+	if (numSlots == 0 || !isOpen) return;
+	if (!Admit(pid)) {
+		numDeclined++;
+		return;
+	}
+
+	unsigned slot = FindSlot();
+	if (file.Write((long long)slot * MINIBASE_PAGESIZE, page, MINIBASE_PAGESIZE) != OK) {
+		freeSlots.push_back(slot);
+		return;
+	}
+
+	slotPage[slot] = pid;
+	referenced[slot] = 0;
+	index[pid] = slot;
+	numPuts++;
+}
+
+void FileCache::Invalidate(PageID first, int count) {
+	if ((size_t)count <= index.size()) {
+		for (int i = 0; i < count; i++) {
+			std::unordered_map<PageID, unsigned>::iterator found = index.find(first + i);
+			if (found != index.end())
+				Drop(found->second);
+		}
+		return;
+	}
+
+	for (unsigned slot = 0; slot < numSlots; slot++) {
+		PageID pid = slotPage[slot];
+		if (pid != INVALID_PAGE && pid >= first && pid - first < count)
+			Drop(slot);
+	}
+}
+
+//--------------------------------------------------------------------
+// FileCache::Admit
+//
+// Return   : true if pid should be written to the file: always when
+//            admitAll is set, else if pid was offered (and declined)
+//            within the last numSlots offers.  A declined page is
+//            remembered as offered.
+//--------------------------------------------------------------------
+bool FileCache::Admit(PageID pid) {
+	if (admitAll) return true;
+
+	std::unordered_map<PageID, unsigned long>::iterator seen = recentOffers.find(pid);
+	if (seen != recentOffers.end()) {
+		recentOffers.erase(seen);
+		return true;
+	}
+
+	recentOffers[pid] = ++offerSeq;
+	offerOrder.push_back(std::make_pair(pid, offerSeq));
+	while (offerOrder.size() > numSlots) {
+		std::unordered_map<PageID, unsigned long>::iterator old = recentOffers.find(offerOrder.front().first);
+		if (old != recentOffers.end() && old->second == offerOrder.front().second)
+			recentOffers.erase(old);
+		offerOrder.pop_front();
+	}
+	return false;
+}
+
+// Take a free slot, or evict the first unreferenced page under the hand.
+unsigned FileCache::FindSlot() {
+	if (freeSlots.empty()) {
+		while (referenced[hand]) {
+			referenced[hand] = 0;
+			hand = (hand + 1) % numSlots;
+		}
+		Drop(hand);
+		numEvictions++;
+		hand = (hand + 1) % numSlots;
+	}
+
+	unsigned slot = freeSlots.back();
+	freeSlots.pop_back();
+	return slot;
+}
+
+void FileCache::Drop(unsigned slot) {
+	index.erase(slotPage[slot]);
+	slotPage[slot] = INVALID_PAGE;
+	referenced[slot] = 0;
+	freeSlots.push_back(slot);
+}
+
+void FileCache::PrintStat() {
+	cout<<"**File Cache Statistics**"<<endl;
+	cout<<"Cache File: "<<path<<endl;
+	cout<<"Pages Cached: "<<index.size()<<" of "<<numSlots<<endl;
+	cout<<"Number of Lookups: "<<numLookups<<endl;
+	cout<<"Number of Hits: "<<numHits<<endl;
+	cout<<"Hit Ratio: "<<(numLookups > 0 ? (double)numHits / numLookups : 0)<<endl;
+	cout<<"Pages Admitted: "<<numPuts<<endl;
+	cout<<"Pages Declined by Admission: "<<numDeclined<<endl;
+	cout<<"Pages Evicted for Space: "<<numEvictions<<endl;
+}
@@ -1,67 +1,56 @@
-#include "frame.h"
-
-Frame::Frame() {
-	pid = INVALID_PAGE;
-	data = new Page();
-	pinCount = 0;
-	dirty = false;
-}
-
-Frame::~Frame() {
-	delete data;
-}
-
-void Frame::Pin() {
-	pinCount++;
-}
+#include <stdlib.h>
+#include <new>
 
-void Frame::Unpin() {
-	pinCount--;
-}
+#ifdef _WIN32
+#   include <malloc.h>
+#endif
 
-int Frame::GetPinCount() {
-	return pinCount;
-}
+#include "frame.h"
+#include "checksum.h"
 
-void Frame::EmptyIt() {
-    pid = INVALID_PAGE;
-    pinCount = 0;
-    dirty = false;
-	// Do we need to wipe the data?
-}
+bool FrameBase::checksums = true;
 
-void Frame::DirtyIt() {
-	dirty = true;
+void FrameBase::SetChecksums(bool on) {
+	checksums = on;
 }
 
-void Frame::SetPageID(PageID pid) {
-	this->pid = pid;
+void FrameBase::StampChecksum(char* data, int size) {
+	unsigned int crc = Crc32c(data, size - PAGE_TRAILER_SIZE);
+	memcpy(data + size - PAGE_TRAILER_SIZE, &crc, sizeof crc);
 }
 
-bool Frame::IsDirty() {
-	return dirty;
-}
+// Only on a mismatch do we look for the all-zero page that the file was
+// created with.
+bool FrameBase::ChecksumOK(const char* data, int size) {
+	unsigned int stored;
+	memcpy(&stored, data + size - PAGE_TRAILER_SIZE, sizeof stored);
+	if (stored == Crc32c(data, size - PAGE_TRAILER_SIZE))
+		return true;
 
-bool Frame::IsValid() {
-    return (pid != INVALID_PAGE);
-}
-    
-Status Frame::Write() {
-   return MINIBASE_DB->WritePage(pid, data);
-}
+	if (stored != 0)
+		return false;
 
-Status Frame::Read(PageID pid){ 
-   return MINIBASE_DB->ReadPage(pid, data);
-}
-    
-bool Frame::NotPinned() {
-	return pinCount == 0;
+	for (int i = 0; i < size - PAGE_TRAILER_SIZE; i++)
+		if (data[i] != 0)
+			return false;
+	return true;
 }
 
-PageID Frame::GetPageID() { 
-	return pid;
+char* FrameBase::AllocateData(int size) {
+#ifdef _WIN32
+	void* p = _aligned_malloc(size, DirectStorage::BLOCK_SIZE);
+#else
+	void* p = NULL;
+	if (posix_memalign(&p, DirectStorage::BLOCK_SIZE, size) != 0) p = NULL;
+#endif
+	if (p == NULL) throw std::bad_alloc();
+	return (char*)p;
 }
 
-Page *Frame::GetPage(){
-	return data;
+void FrameBase::FreeData(char* data) {
+#ifdef _WIN32
+	_aligned_free(data);
+#else
+	free(data);
+#endif
 }
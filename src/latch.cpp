@@ -0,0 +1,80 @@
+#include <thread>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#   include <immintrin.h>
+#   define LATCH_PAUSE() _mm_pause()
+#else
+#   define LATCH_PAUSE() std::this_thread::yield()
+#endif
+
+#include "latch.h"
+
+// About as long as a short critical section, such as a page being read or
+// a few bytes of it changed, takes; a holder that stays longer than that
+// is usually doing I/O, and the waiter might as well sleep.
+static const int SPIN_LIMIT = 100;
+
+bool Latch::TryUpgrade()
+{
+	unsigned s = state.load(std::memory_order_relaxed);
+	while ((s & (EXCLUSIVE | READERS)) == 1)
+		if (state.compare_exchange_weak(s, (unsigned)EXCLUSIVE, std::memory_order_acquire))
+			return true;
+	return false;
+}
+
+// Parked writers still bar new readers, so WRITER_WAITING is kept; the
+// parked readers are woken in case it is not set.
+void Latch::Downgrade()
+{
+	unsigned s = state.load(std::memory_order_relaxed);
+	while (!state.compare_exchange_weak(s, (s & WRITER_WAITING) | 1, std::memory_order_release))
+		;
+	WakeParked();
+}
+
+//--------------------------------------------------------------------
+// Latch::Wait
+//
+// Input    : exclusive - the mode wanted
+// Purpose  : Take the latch after a first try has failed.  Spin for a
+//            while; then count this thread in parked and sleep on
+//            parkCond until the latch is taken.  A parked writer sets
+//            WRITER_WAITING, which keeps new readers out until a writer
+//            gets the latch.
+//
+//            No wakeup is lost: a release changes state and then reads
+//            parked, and this thread counts itself in parked and then
+//            reads state, so either the release sees it parked and
+//            notifies under parkLock, which waits for this thread to be
+//            asleep, or this thread sees the latch free.
+//--------------------------------------------------------------------
+void Latch::Wait(bool exclusive)
+{
+	for (int spin = 0; spin < SPIN_LIMIT; spin++) {
+		LATCH_PAUSE();
+		if (exclusive ? TryLockExclusive() : TryLockShared())
+			return;
+	}
+
+	std::unique_lock<std::mutex> lock(parkLock);
+	parked.fetch_add(1);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	for (;;) {
+		if (exclusive) {
+			if (TryLockExclusive()) break;
+			state.fetch_or((unsigned)WRITER_WAITING);
+			if (TryLockExclusive()) break;
+		}
+		else if (TryLockShared())
+			break;
+		parkCond.wait(lock);
+	}
+	parked.fetch_sub(1);
+}
+
+void Latch::WakeAll()
+{
+	std::lock_guard<std::mutex> lock(parkLock);
+	parkCond.notify_all();
+}
@@ -0,0 +1,239 @@
+#include <chrono>
+#include <iomanip>
+
+using namespace std;
+
+#include "latency_stats.h"
+
+
+// SCHEMA FOR THE LATENCY HISTOGRAMS
+// A value v below 2*HALF goes to bucket v.  Above that, with m the index of
+// v's top bit and shift = m - (LINEAR_BITS-1), it goes to bucket
+// shift*HALF + (v >> shift); (v >> shift) is in [HALF, 2*HALF), so the
+// buckets of consecutive powers of two follow each other.
+//
+// Each thread finds its shard through a thread_local cache tagged with the
+// LatencyStats' serial number, as DB does for its extent caches.  On a
+// cache miss the thread looks for the shard it made before, so a thread
+// that alternates between two pools does not keep making new ones.
+
+static unsigned next_latency_serial = 0;
+
+static double SecondsNow()
+{
+	return std::chrono::duration<double>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+LatencyStats::LatencyStats()
+{
+	serial = ++next_latency_serial;
+	startTicks = Now();
+	startSeconds = SecondsNow();
+}
+
+LatencyStats::~LatencyStats()
+{
+	for (unsigned i = 0; i < shards.size(); i++)
+		delete shards[i];
+}
+
+int LatencyStats::Bucket(unsigned long long v)
+{
+	if (v < 2 * HALF) return (int)v;
+
+#if defined(_MSC_VER) && defined(_M_X64)
+	unsigned long index;
+	_BitScanReverse64(&index, v);
+	int m = (int)index;
+#elif defined(__GNUC__) || defined(__clang__)
+	int m = 63 - __builtin_clzll(v);
+#else
+	int m = 0;
+	for (unsigned long long t = v; t >>= 1; )
+		m++;
+#endif
+	int shift = m - (LINEAR_BITS - 1);
+	int bucket = shift * HALF + (int)(v >> shift);
+	return (bucket < NUM_BUCKETS) ? bucket : NUM_BUCKETS - 1;
+}
+
+unsigned long long LatencyStats::BucketLow(int bucket)
+{
+	if (bucket < 2 * HALF) return bucket;
+
+	int shift = bucket / HALF - 1;
+	return (unsigned long long)(bucket - shift * HALF) << shift;
+}
+
+LatencyStats::Shard* LatencyStats::MyShard()
+{
+	static thread_local unsigned owner = 0;
+	static thread_local Shard* shard = 0;
+
+	if (owner != serial) {
+		std::lock_guard<std::mutex> guard(shardLock);
+		std::thread::id me = std::this_thread::get_id();
+
+		shard = 0;
+		for (unsigned i = 0; i < shards.size() && !shard; i++)
+			if (shards[i]->owner == me)
+				shard = shards[i];
+
+		if (!shard) {
+			shard = new Shard;
+			shard->owner = me;
+			for (int op = 0; op < NUM_LATENCY_OPS; op++) {
+				for (int b = 0; b < NUM_BUCKETS; b++)
+					shard->counts[op][b].store(0, std::memory_order_relaxed);
+				shard->sums[op].store(0, std::memory_order_relaxed);
+			}
+			shards.push_back(shard);
+		}
+		owner = serial;
+	}
+	return shard;
+}
+
+// Only the owning thread writes a shard, so a relaxed load and store is
+// enough and costs no more than a plain increment.
+void LatencyStats::Record(LatencyOp op, unsigned long long start, unsigned weight)
+{
+	unsigned long long ticks = Now() - start;
+	Shard* shard = MyShard();
+
+	std::atomic<unsigned long long>& count = shard->counts[op][Bucket(ticks)];
+	count.store(count.load(std::memory_order_relaxed) + weight, std::memory_order_relaxed);
+	std::atomic<unsigned long long>& sum = shard->sums[op];
+	sum.store(sum.load(std::memory_order_relaxed) + ticks * weight, std::memory_order_relaxed);
+}
+
+void LatencyStats::Merge(LatencyOp op, std::vector<unsigned long long>& counts)
+{
+	counts.assign(NUM_BUCKETS, 0);
+	std::lock_guard<std::mutex> guard(shardLock);
+	for (unsigned i = 0; i < shards.size(); i++)
+		for (int b = 0; b < NUM_BUCKETS; b++)
+			counts[b] += shards[i]->counts[op][b].load(std::memory_order_relaxed);
+}
+
+// The tick rate, measured over the life of this object (at least 1 ms).
+double LatencyStats::NsPerTick()
+{
+#if LATENCY_HAVE_TSC
+	double seconds;
+	unsigned long long ticks;
+	do {
+		seconds = SecondsNow() - startSeconds;
+		ticks = Now() - startTicks;
+	} while (seconds < 0.001);
+	return seconds * 1e9 / ticks;
+#else
+	return 1.0;
+#endif
+}
+
+unsigned long long LatencyStats::GetCount(LatencyOp op)
+{
+	std::vector<unsigned long long> counts;
+	Merge(op, counts);
+
+	unsigned long long total = 0;
+	for (int b = 0; b < NUM_BUCKETS; b++)
+		total += counts[b];
+	return total;
+}
+
+double LatencyStats::GetMean(LatencyOp op)
+{
+	unsigned long long count = GetCount(op);
+	if (count == 0) return 0;
+
+	unsigned long long sum = 0;
+	{
+		std::lock_guard<std::mutex> guard(shardLock);
+		for (unsigned i = 0; i < shards.size(); i++)
+			sum += shards[i]->sums[op].load(std::memory_order_relaxed);
+	}
+	return (double)sum / count * NsPerTick();
+}
+
+//--------------------------------------------------------------------
+// LatencyStats::GetPercentile
+//
+// Return   : the lowest value of the bucket holding the ceil(q*count)-th
+//            smallest sample, in nanoseconds; 0 if there are none.
+//--------------------------------------------------------------------
+double LatencyStats::GetPercentile(LatencyOp op, double q)
+{
+	std::vector<unsigned long long> counts;
+	Merge(op, counts);
+
+	unsigned long long total = 0;
+	for (int b = 0; b < NUM_BUCKETS; b++)
+		total += counts[b];
+	if (total == 0) return 0;
+
+	unsigned long long rank = (unsigned long long)(q * total + 0.999999);
+	if (rank < 1) rank = 1;
+
+	unsigned long long seen = 0;
+	int b = 0;
+	for ( ; b < NUM_BUCKETS - 1; b++) {
+		seen += counts[b];
+		if (seen >= rank) break;
+	}
+	return BucketLow(b) * NsPerTick();
+}
+
+void LatencyStats::Reset()
+{
+	std::lock_guard<std::mutex> guard(shardLock);
+	for (unsigned i = 0; i < shards.size(); i++)
+		for (int op = 0; op < NUM_LATENCY_OPS; op++) {
+			for (int b = 0; b < NUM_BUCKETS; b++)
+				shards[i]->counts[op][b].store(0, std::memory_order_relaxed);
+			shards[i]->sums[op].store(0, std::memory_order_relaxed);
+		}
+}
+
+LatencySummary LatencyStats::GetSummary(LatencyOp op)
+{
+	LatencySummary l;
+	l.count = GetCount(op);
+	l.mean = GetMean(op);
+	l.p50 = GetPercentile(op, 0.5);
+	l.p99 = GetPercentile(op, 0.99);
+	l.p999 = GetPercentile(op, 0.999);
+	l.max = GetPercentile(op, 1.0);
+	return l;
+}
+
+const char* LatencyStats::OpName(LatencyOp op)
+{
+	static const char* names[NUM_LATENCY_OPS] = {
+		"pin hit", "pin miss", "eviction", "dirty write", "DB read", "DB write",
+	};
+	return names[op];
+}
+
+void LatencyStats::Print(std::ostream& out)
+{
+	out << "Latency (ns)    " << setw(10) << "count" << setw(10) << "mean"
+		<< setw(10) << "p50" << setw(10) << "p99" << setw(10) << "p999"
+		<< setw(10) << "max" << endl;
+
+	ios::fmtflags flags = out.flags();
+	streamsize precision = out.precision();
+	out << fixed << setprecision(0);
+	for (int i = 0; i < NUM_LATENCY_OPS; i++) {
+		LatencyOp op = (LatencyOp)i;
+		out << "  " << left << setw(14) << OpName(op) << right
+			<< setw(10) << GetCount(op) << setw(10) << GetMean(op)
+			<< setw(10) << GetPercentile(op, 0.5) << setw(10) << GetPercentile(op, 0.99)
+			<< setw(10) << GetPercentile(op, 0.999) << setw(10) << GetPercentile(op, 1.0)
+			<< endl;
+	}
+	out.flags(flags);
+	out.precision(precision);
+}
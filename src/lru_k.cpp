@@ -0,0 +1,93 @@
+#include "lru_k.h"
+
+
+// SCHEMA FOR THE LRU-K POLICY
+// histories has an entry for every candidate and for up to `retain` other
+// pages.  candidates orders the unpinned pages by Key, so the victim is
+// always the first.  retired lists, oldest first, the pages that left the
+// pool with their history kept, each with the time it left; an entry is
+// stale if the history's retiredAt no longer matches it, because the page
+// came back since, and is skipped when trimming.
+
+LRUK::LRUK(int k, int retain) {
+	this->k = k;
+	this->retain = retain;
+	now = 0;
+	retirements = 0;
+}
+
+LRUK::~LRUK() {
+}
+
+std::pair<std::pair<long, long>, int> LRUK::Key(int pid, const History& h, int k) {
+	long kth = ((int)h.uses.size() < k) ? -1 : h.uses.front();
+	return std::make_pair(std::make_pair(kth, h.uses.back()), pid);
+}
+
+int LRUK::PickVictim() {
+	if (candidates.empty()) return INVALID_PAGE;
+
+	int victim = candidates.begin()->second;
+	DropFrame(victim);
+	return victim;
+}
+
+void LRUK::AddFrame(int f) {
+	History& h = histories[f];
+	if (h.candidate)
+		candidates.erase(h.pos);
+	h.retiredAt = 0;
+
+	h.uses.push_back(++now);
+	if ((int)h.uses.size() > k)
+		h.uses.pop_front();
+
+	h.pos = candidates.insert(Key(f, h, k)).first;
+	h.candidate = true;
+}
+
+// The page is pinned, so it is back in the pool if it had left.
+void LRUK::RemoveFrame(int f) {
+	std::unordered_map<int, History>::iterator found = histories.find(f);
+	if (found == histories.end()) return;
+
+	History& h = found->second;
+	if (h.candidate) candidates.erase(h.pos);
+	h.candidate = false;
+	h.retiredAt = 0;
+}
+
+void LRUK::DropFrame(int f) {
+	std::unordered_map<int, History>::iterator found = histories.find(f);
+	if (found == histories.end()) return;
+
+	RemoveFrame(f);
+	Retire(f);
+}
+
+// Keep the history of a page that left the pool, dropping the oldest kept
+// histories beyond `retain`.  Stale entries count against retain too, so
+// retired stays bounded however often pages come back.
+void LRUK::Retire(int pid) {
+	histories[pid].retiredAt = ++retirements;
+	retired.push_back(std::make_pair(pid, retirements));
+	while ((int)retired.size() > retain) {
+		std::pair<int, long> old = retired.front();
+		retired.pop_front();
+
+		std::unordered_map<int, History>::iterator found = histories.find(old.first);
+		if (found != histories.end() && found->second.retiredAt == old.second)
+			histories.erase(found);
+	}
+}
+
+void LRUK::GetStats(ReplacerStats& stats) const {
+	// Candidates with fewer than K uses sort first, with a key of -1.
+	long belowK = 0;
+	for (Order::const_iterator it = candidates.begin(); it != candidates.end() && it->first.first < 0; ++it)
+		belowK++;
+
+	stats.push_back(std::make_pair(std::string("candidates"), (double)candidates.size()));
+	stats.push_back(std::make_pair(std::string("candidates_below_k"), (double)belowK));
+	stats.push_back(std::make_pair(std::string("histories"), (double)histories.size()));
+}
@@ -15,8 +15,8 @@ int main (int argc, char **argv)
 
 	int bufSize = NUMBUF;
 
-	const char* replacement_policies[] = {"LRU", "MRU"};
-	int numPolicies = 2;
+	const char* replacement_policies[] = {"LRU", "MRU", "Clock", "LRU-K:k=2"};
+	int numPolicies = 4;
 
 	for (int i = 0; i < numPolicies; i++) {
 		cout << "Running the Buffer Manager with " 
@@ -44,4 +44,4 @@ int main (int argc, char **argv)
 	}
 	getch();
 	return 0;
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+#include <algorithm>
+
+#include "mrc.h"
+
+
+// SCHEMA FOR THE MISS-RATIO CURVE
+// pages holds every sampled page with the time of its last reference;
+// the tree counts pages by that time, so the reuse distance of a page is
+// the number of pages whose time is later than its own.  Times come from
+// clock and run up to the size of the tree; when they reach it, Renumber
+// packs the live times into 1..pages.size().
+//
+// A reference seen at rate r stands for 1/r references, so it adds 1/r to
+// the histogram at its distance scaled by 1/r (or to coldWeight the first
+// time a page is seen).  The rate only goes down, and earlier references
+// keep the weight they were given.
+//
+// A sampled distance d stands for distances d/r up to (d+1)/r, so it is
+// put at the middle of that range.
+
+MissRatioCurve::MissRatioCurve(double rate, int maxSamples)
+{
+	if (!(rate > 0) || rate > 1) rate = 1;
+	threshold = (unsigned)(rate * HASH_RANGE);
+	if (threshold == 0) threshold = 1;
+
+	this->maxSamples = (maxSamples > 0) ? maxSamples : 1;
+	tree.assign(4 * (size_t)this->maxSamples + 1, 0);
+	clock = 0;
+	Reset();
+}
+
+void MissRatioCurve::Reset()
+{
+	for (int b = 0; b < LatencyStats::NUM_BUCKETS; b++)
+		histogram[b] = 0;
+	coldWeight = 0;
+	totalWeight = 0;
+}
+
+//--------------------------------------------------------------------
+// MissRatioCurve::Sample
+//
+// Input    : pid, hash - a sampled page and its hash
+// Purpose  : Record the page's reuse distance and make it the most
+//            recently used page.  If that leaves more than maxSamples
+//            pages, lower the threshold to drop the largest hash.
+//--------------------------------------------------------------------
+void MissRatioCurve::Sample(int pid, unsigned hash)
+{
+	if (clock + 1 >= tree.size()) Renumber();
+
+	double weight = (double)HASH_RANGE / threshold;
+
+	std::unordered_map<int, Sampled>::iterator it = pages.find(pid);
+	if (it != pages.end()) {
+		int distance = (int)pages.size() - TreeCount(it->second.time);
+		histogram[LatencyStats::Bucket((unsigned long long)((distance + 0.5) * weight))] += weight;
+		TreeAdd(it->second.time, -1);
+	}
+	else {
+		coldWeight += weight;
+		Sampled s;
+		s.hash = hash;
+		it = pages.insert(std::make_pair(pid, s)).first;
+		byHash.insert(std::make_pair(hash, pid));
+	}
+	totalWeight += weight;
+
+	it->second.time = ++clock;
+	TreeAdd(clock, 1);
+
+	if ((int)pages.size() > maxSamples) {
+		threshold = byHash.rbegin()->first;
+		while (!byHash.empty() && byHash.rbegin()->first >= threshold)
+			Drop(byHash.rbegin()->second);
+	}
+}
+
+void MissRatioCurve::Drop(int pid)
+{
+	std::unordered_map<int, Sampled>::iterator it = pages.find(pid);
+	TreeAdd(it->second.time, -1);
+	byHash.erase(std::make_pair(it->second.hash, pid));
+	pages.erase(it);
+}
+
+void MissRatioCurve::Renumber()
+{
+	std::vector< std::pair<unsigned long long, int> > order;
+	for (std::unordered_map<int, Sampled>::const_iterator it = pages.begin(); it != pages.end(); ++it)
+		order.push_back(std::make_pair(it->second.time, it->first));
+	std::sort(order.begin(), order.end());
+
+	std::fill(tree.begin(), tree.end(), 0);
+	clock = 0;
+	for (size_t i = 0; i < order.size(); i++) {
+		pages[order[i].second].time = ++clock;
+		TreeAdd(clock, 1);
+	}
+}
+
+void MissRatioCurve::TreeAdd(unsigned long long time, int delta)
+{
+	for (size_t i = (size_t)time; i < tree.size(); i += i & (0 - i))
+		tree[i] += delta;
+}
+
+int MissRatioCurve::TreeCount(unsigned long long time) const
+{
+	int count = 0;
+	for (size_t i = (size_t)time; i > 0; i -= i & (0 - i))
+		count += tree[i];
+	return count;
+}
+
+//--------------------------------------------------------------------
+// MissRatioCurve::PredictHitRatio
+//
+// Return   : the weight of references whose scaled reuse distance is
+//            below numFrames, as a share of all references.  The bucket
+//            holding numFrames is counted in proportion.
+//--------------------------------------------------------------------
+double MissRatioCurve::PredictHitRatio(int numFrames) const
+{
+	if (totalWeight == 0 || numFrames <= 0) return 0;
+
+	double hits = 0;
+	for (int b = 0; b < LatencyStats::NUM_BUCKETS; b++) {
+		double low = (double)LatencyStats::BucketLow(b);
+		double high = (b + 1 < LatencyStats::NUM_BUCKETS) ? (double)LatencyStats::BucketLow(b + 1) : low * 2;
+		if (low >= numFrames) break;
+		if (high <= numFrames) hits += histogram[b];
+		else hits += histogram[b] * (numFrames - low) / (high - low);
+	}
+	return hits / totalWeight;
+}
@@ -8,6 +8,7 @@
 #endif
 
 #include "page.h"
+#include "frame.h"
 
 // Methods of the class Page
 //***********************************************************
@@ -31,3 +32,19 @@ Page::~Page()
 }
 
 //************************************************************
+
+// Compute the page checksum and store it in the trailer
+void Page::StampChecksum()
+{
+    FrameBase::StampChecksum( (char*)this, MINIBASE_PAGESIZE );
+}
+
+//************************************************************
+
+// Check the page against its trailer.
+bool Page::ChecksumOK() const
+{
+    return FrameBase::ChecksumOK( (const char*)this, MINIBASE_PAGESIZE );
+}
+
+//************************************************************
@@ -0,0 +1,188 @@
+#include <string.h>
+
+#include "page_codec.h"
+
+// LZ4 block format, as produced here:
+//
+//   sequence := token [literal-length bytes] literals offset [match-length bytes]
+//
+// The token's high nibble is the literal count and its low nibble the match
+// length minus 4; a nibble of 15 is continued by bytes of 255 plus a final
+// byte.  The offset is two bytes, little-endian.  The last sequence has
+// literals only.  As in LZ4, matches stop 5 bytes before the end and may not
+// start in the last 12 bytes, which keeps the decoder simple.
+
+static const int minMatch = 4;
+static const int lastLiterals = 5;
+static const int matchFindLimit = 12;
+static const int hashBits = 12;
+static const int wildCopy = 16;
+
+static inline unsigned int Read32( const unsigned char* p )
+{
+	unsigned int v;
+	memcpy(&v, p, sizeof v);
+	return v;
+}
+
+static inline unsigned long long Read64( const unsigned char* p )
+{
+	unsigned long long v;
+	memcpy(&v, p, sizeof v);
+	return v;
+}
+
+static inline unsigned int Hash( unsigned int v )
+{
+	return (v * 2654435761u) >> (32 - hashBits);
+}
+
+// Append a length continuation (the part beyond the nibble's 15).
+static inline bool PutLength( unsigned char*& op, const unsigned char* oend, int len )
+{
+	for ( ; len >= 255; len -= 255) {
+		if (op >= oend) return false;
+		*op++ = 255;
+	}
+	if (op >= oend) return false;
+	*op++ = (unsigned char)len;
+	return true;
+}
+
+int PageCompress( const char* src, int srcLen, char* dst, int dstCapacity )
+{
+	const unsigned char* base = (const unsigned char*)src;
+	const unsigned char* ip = base;
+	const unsigned char* anchor = base;
+	const unsigned char* iend = base + srcLen;
+	const unsigned char* mflimit = iend - matchFindLimit;
+	const unsigned char* matchlimit = iend - lastLiterals;
+	unsigned char* op = (unsigned char*)dst;
+	unsigned char* oend = op + dstCapacity;
+
+	int table[1 << hashBits];
+	for (int i = 0; i < (1 << hashBits); i++)
+		table[i] = -1;
+
+	while (ip < mflimit) {
+		unsigned int h = Hash(Read32(ip));
+		int candidate = table[h];
+		table[h] = (int)(ip - base);
+
+		if (candidate < 0 || Read32(base + candidate) != Read32(ip)) {
+			ip++;
+			continue;
+		}
+
+		const unsigned char* ref = base + candidate;
+		// Extend the match eight bytes at a time, then bytewise.
+		int matchLen = minMatch;
+		while (ip + matchLen + 8 <= matchlimit
+		       && Read64(ref + matchLen) == Read64(ip + matchLen))
+			matchLen += 8;
+		while (ip + matchLen < matchlimit && ref[matchLen] == ip[matchLen])
+			matchLen++;
+
+		int litLen = (int)(ip - anchor);
+		if (op + 1 + litLen + 2 > oend) return 0;
+
+		unsigned char* token = op++;
+		*token = (unsigned char)(((litLen < 15 ? litLen : 15) << 4)
+		                         | (matchLen - minMatch < 15 ? matchLen - minMatch : 15));
+		if (litLen >= 15 && !PutLength(op, oend, litLen - 15)) return 0;
+		if (op + litLen + 2 > oend) return 0;
+		memcpy(op, anchor, litLen);
+		op += litLen;
+
+		int offset = (int)(ip - ref);
+		*op++ = (unsigned char)(offset & 0xff);
+		*op++ = (unsigned char)(offset >> 8);
+		if (matchLen - minMatch >= 15 && !PutLength(op, oend, matchLen - minMatch - 15)) return 0;
+
+		ip += matchLen;
+		anchor = ip;
+	}
+
+	// The trailing literals.
+	int litLen = (int)(iend - anchor);
+	if (op + 1 > oend) return 0;
+	*op++ = (unsigned char)((litLen < 15 ? litLen : 15) << 4);
+	if (litLen >= 15 && !PutLength(op, oend, litLen - 15)) return 0;
+	if (op + litLen > oend) return 0;
+	memcpy(op, anchor, litLen);
+	op += litLen;
+
+	return (int)(op - (unsigned char*)dst);
+}
+
+int PageDecompress( const char* src, int srcLen, char* dst, int dstLen )
+{
+	const unsigned char* ip = (const unsigned char*)src;
+	const unsigned char* iend = ip + srcLen;
+	unsigned char* op = (unsigned char*)dst;
+	unsigned char* oend = op + dstLen;
+
+	while (ip < iend) {
+		unsigned int token = *ip++;
+
+		int litLen = token >> 4;
+		if (litLen == 15) {
+			unsigned int b;
+			do {
+				if (ip >= iend) return -1;
+				b = *ip++;
+				litLen += b;
+			} while (b == 255);
+		}
+		if (litLen > iend - ip || litLen > oend - op) return -1;
+		if (litLen <= wildCopy && iend - ip >= wildCopy && oend - op >= wildCopy)
+			memcpy(op, ip, wildCopy);	// Short run: one fixed-size copy.
+		else
+			memcpy(op, ip, litLen);
+		ip += litLen;
+		op += litLen;
+
+		if (ip == iend) break;      // The last sequence has no match.
+
+		if (iend - ip < 2) return -1;
+		int offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (offset == 0 || offset > op - (unsigned char*)dst) return -1;
+
+		int matchLen = token & 15;
+		if (matchLen == 15) {
+			unsigned int b;
+			do {
+				if (ip >= iend) return -1;
+				b = *ip++;
+				matchLen += b;
+			} while (b == 255);
+		}
+		matchLen += minMatch;
+		if (matchLen > oend - op) return -1;
+
+		// The match may overlap the bytes it produces.  A run of one byte
+		// is a memset; otherwise copy in pieces of at most offset bytes,
+		// each of which reads only bytes already written.  Pieces are a
+		// fixed wildCopy bytes when that fits, even if it writes past the
+		// match; later sequences overwrite the excess.
+		const unsigned char* ref = op - offset;
+		if (offset >= wildCopy && oend - op >= matchLen + wildCopy) {
+			for (int i = 0; i < matchLen; i += wildCopy)
+				memcpy(op + i, ref + i, wildCopy);
+			op += matchLen;
+		} else if (offset == 1) {
+			memset(op, op[-1], matchLen);
+			op += matchLen;
+		} else {
+			while (matchLen > 0) {
+				int n = (matchLen < offset) ? matchLen : offset;
+				memcpy(op, op - offset, n);
+				op += n;
+				matchLen -= n;
+			}
+		}
+	}
+
+	return (op == oend) ? dstLen : -1;
+}
@@ -0,0 +1,67 @@
+#include "page_guard.h"
+#include "bufmgr.h"
+
+PageGuard::PageGuard(PageGuard&& other)
+{
+	mgr = other.mgr;
+	frame = other.frame;
+	pid = other.pid;
+	page = other.page;
+	latch = other.latch;
+	intent = other.intent;
+	dirty = other.dirty;
+	other.mgr = NULL;
+}
+
+PageGuard& PageGuard::operator=(PageGuard&& other)
+{
+	if (this != &other) {
+		Release();
+		mgr = other.mgr;
+		frame = other.frame;
+		pid = other.pid;
+		page = other.page;
+		latch = other.latch;
+		intent = other.intent;
+		dirty = other.dirty;
+		other.mgr = NULL;
+	}
+	return *this;
+}
+
+bool PageGuard::Upgrade()
+{
+	dirty = true;
+	if (mgr == NULL || intent == PIN_WRITE) {
+		intent = PIN_WRITE;
+		return true;
+	}
+
+	intent = PIN_WRITE;
+	if (latch->TryUpgrade()) return true;
+	latch->UnlockShared();
+	latch->LockExclusive();
+	return false;
+}
+
+void PageGuard::Downgrade()
+{
+	if (mgr != NULL && intent == PIN_WRITE) latch->Downgrade();
+	intent = PIN_READ;
+}
+
+// The latch is let go before the pin, so that the frame cannot be given
+// to another page while it is still latched.
+Status PageGuard::Release()
+{
+	if (mgr == NULL) return OK;
+
+	if (intent == PIN_WRITE) latch->UnlockExclusive();
+	else latch->UnlockShared();
+
+	BufMgr* from = mgr;
+	mgr = NULL;
+	page = NULL;
+	latch = NULL;
+	return from->UnpinFrame(frame, pid, dirty);
+}
@@ -0,0 +1,61 @@
+#include "page_table.h"
+
+
+// SCHEMA FOR THE PAGE TABLE
+// A page is in the first empty-or-its-own slot at or after Home(pid),
+// wrapping around: no empty slot lies between a page's home and its slot.
+// Erase keeps that true by moving later pages of the same cluster back
+// into the hole, rather than leaving a tombstone.
+
+PageTable::PageTable() {
+	Reset(0);
+}
+
+void PageTable::Reset(int n) {
+	unsigned bits = 1;
+	while ((1u << bits) < 2 * (unsigned)n) bits++;
+
+	Slot empty = { INVALID_PAGE, INVALID_FRAME };
+	slots.assign(1u << bits, empty);
+	shift = 32 - bits;
+	count = 0;
+}
+
+void PageTable::Insert(PageID pid, int frame) {
+	unsigned i = Home(pid);
+	while (slots[i].pid != INVALID_PAGE)
+		i = Next(i);
+	slots[i].pid = pid;
+	slots[i].frame = frame;
+	count++;
+}
+
+//--------------------------------------------------------------------
+// PageTable::Erase
+//
+// Input    : pid - a page in the table
+// Purpose  : Empty pid's slot, then walk the rest of its cluster.  A page
+//            whose home is not cyclically in (hole, its slot] could no
+//            longer be found past the hole, so it moves into the hole,
+//            which moves to where it was.
+//--------------------------------------------------------------------
+void PageTable::Erase(PageID pid) {
+	unsigned hole = Home(pid);
+	while (slots[hole].pid != pid) {
+		if (slots[hole].pid == INVALID_PAGE) return;
+		hole = Next(hole);
+	}
+	slots[hole].pid = INVALID_PAGE;
+	count--;
+
+	for (unsigned i = Next(hole); slots[i].pid != INVALID_PAGE; i = Next(i)) {
+		unsigned home = Home(slots[i].pid);
+		bool reachable = (hole < i) ? (hole < home && home <= i)
+		                            : (hole < home || home <= i);
+		if (reachable) continue;
+
+		slots[hole] = slots[i];
+		slots[i].pid = INVALID_PAGE;
+		hole = i;
+	}
+}
@@ -1,4 +1,6 @@
 #include "replacer.h"
 
 Replacer::Replacer() { }
-Replacer::~Replacer() { }
\ No newline at end of file
+void Replacer::DropFrame(int frameId) { RemoveFrame(frameId); }
+void Replacer::GetStats(ReplacerStats&) const { }
+Replacer::~Replacer() { }
\ No newline at end of file
@@ -0,0 +1,205 @@
+#include <ctype.h>
+#include <stdlib.h>
+#include <iostream>
+
+using namespace std;
+
+#include "replacer_registry.h"
+#include "bufmgr.h"
+#include "lru.h"
+#include "mru.h"
+#include "clock.h"
+#include "lru_k.h"
+
+struct RegistryEntry {
+	ReplacerFactory factory;
+	std::string     description;
+};
+
+typedef std::map<std::string, RegistryEntry> RegistryMap;
+
+static std::string Lower(const std::string& s)
+{
+	std::string out(s);
+	for (size_t i = 0; i < out.size(); i++)
+		out[i] = (char)tolower((unsigned char)out[i]);
+	return out;
+}
+
+//--------------------------------------------------------------------
+// ReplacerParams
+//--------------------------------------------------------------------
+bool ReplacerParams::Parse(const std::string& text)
+{
+	size_t start = 0;
+	while (start < text.size()) {
+		size_t end = text.find(',', start);
+		if (end == std::string::npos) end = text.size();
+
+		std::string item = text.substr(start, end - start);
+		size_t eq = item.find('=');
+		if (eq == 0 || eq == std::string::npos || eq + 1 == item.size())
+			return false;
+		values[Lower(item.substr(0, eq))] = item.substr(eq + 1);
+
+		start = end + 1;
+	}
+	return true;
+}
+
+int ReplacerParams::GetInt(const char* name, int def, bool& ok)
+{
+	used.insert(name);
+	std::map<std::string, std::string>::const_iterator it = values.find(name);
+	if (it == values.end()) return def;
+
+	char* end;
+	long v = strtol(it->second.c_str(), &end, 10);
+	if (*end != '\0') {
+		ok = false;
+		return def;
+	}
+	return (int)v;
+}
+
+double ReplacerParams::GetDouble(const char* name, double def, bool& ok)
+{
+	used.insert(name);
+	std::map<std::string, std::string>::const_iterator it = values.find(name);
+	if (it == values.end()) return def;
+
+	char* end;
+	double v = strtod(it->second.c_str(), &end);
+	if (*end != '\0') {
+		ok = false;
+		return def;
+	}
+	return v;
+}
+
+const char* ReplacerParams::FirstUnused() const
+{
+	for (std::map<std::string, std::string>::const_iterator it = values.begin(); it != values.end(); ++it)
+		if (used.find(it->first) == used.end())
+			return it->first.c_str();
+	return NULL;
+}
+
+//--------------------------------------------------------------------
+// The built-in policies
+//--------------------------------------------------------------------
+static Replacer* MakeLRU(ReplacerParams&)
+{
+	return new LRU();
+}
+
+static Replacer* MakeMRU(ReplacerParams&)
+{
+	return new MRU();
+}
+
+static Replacer* MakeClock(ReplacerParams& params)
+{
+	bool ok = true;
+	int hands = params.GetInt("hands", 1, ok);
+	int gap = params.GetInt("gap", 0, ok);
+	if (!ok || hands < 1 || hands > 2 || gap < 0) return NULL;
+	return new Clock(hands, gap);
+}
+
+static Replacer* MakeLRUK(ReplacerParams& params)
+{
+	bool ok = true;
+	int k = params.GetInt("k", 2, ok);
+	int retain = params.GetInt("retain", 4096, ok);
+	if (!ok || k < 1 || retain < 0) return NULL;
+	return new LRUK(k, retain);
+}
+
+// The registry, built on first use so that registration from other static
+// initializers is safe.
+static RegistryMap& Registry()
+{
+	static RegistryMap registry;
+	if (registry.empty()) {
+		RegistryEntry e;
+		e.factory = MakeLRU;   e.description = "least recently used";
+		registry["lru"] = e;
+		e.factory = MakeMRU;   e.description = "most recently used";
+		registry["mru"] = e;
+		e.factory = MakeClock; e.description = "CLOCK; hands=1|2, gap=<pages> (0: half the ring)";
+		registry["clock"] = e;
+		e.factory = MakeLRUK;  e.description = "LRU-K; k=<uses> (2), retain=<histories> (4096)";
+		registry["lru-k"] = e;
+	}
+	return registry;
+}
+
+//--------------------------------------------------------------------
+// ReplacerRegistry
+//--------------------------------------------------------------------
+bool ReplacerRegistry::Register(const char* name, ReplacerFactory factory,
+                                const char* description)
+{
+	RegistryMap& registry = Registry();
+	std::string key = Lower(name);
+	if (registry.find(key) != registry.end()) return false;
+
+	RegistryEntry e;
+	e.factory = factory;
+	e.description = description;
+	registry[key] = e;
+	return true;
+}
+
+//--------------------------------------------------------------------
+// ReplacerRegistry::Create
+//
+// Input    : spec - "name" or "name:param=value,..."
+// Output   : status - OK, or UNKNOWN_REPLACER / BAD_REPLACER_PARAM
+// Return   : a new replacer, NULL on error.
+//--------------------------------------------------------------------
+Replacer* ReplacerRegistry::Create(const char* spec, Status& status)
+{
+	std::string text(spec ? spec : "");
+	size_t colon = text.find(':');
+	std::string name = Lower(text.substr(0, colon));
+
+	RegistryMap& registry = Registry();
+	RegistryMap::const_iterator it = registry.find(name);
+	if (it == registry.end()) {
+		status = MINIBASE_FIRST_ERROR(BUFMGR, UNKNOWN_REPLACER);
+		return NULL;
+	}
+
+	ReplacerParams params;
+	if (colon != std::string::npos && !params.Parse(text.substr(colon + 1))) {
+		status = MINIBASE_FIRST_ERROR(BUFMGR, BAD_REPLACER_PARAM);
+		return NULL;
+	}
+
+	Replacer* r = it->second.factory(params);
+	if (r == NULL || params.FirstUnused() != NULL) {
+		delete r;
+		status = MINIBASE_FIRST_ERROR(BUFMGR, BAD_REPLACER_PARAM);
+		return NULL;
+	}
+
+	status = OK;
+	return r;
+}
+
+void ReplacerRegistry::List(std::ostream& out)
+{
+	RegistryMap& registry = Registry();
+	for (RegistryMap::const_iterator it = registry.begin(); it != registry.end(); ++it)
+		out << "  " << it->first << "\t" << it->second.description << endl;
+}
+
+void ReplacerRegistry::GetNames(std::vector<std::string>& names)
+{
+	names.clear();
+	RegistryMap& registry = Registry();
+	for (RegistryMap::const_iterator it = registry.begin(); it != registry.end(); ++it)
+		names.push_back(it->first);
+}
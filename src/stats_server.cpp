@@ -0,0 +1,217 @@
+#include <sstream>
+#include <string.h>
+
+#ifdef _WIN32
+#   include <winsock2.h>
+#   include <ws2tcpip.h>
+#   pragma comment(lib, "ws2_32.lib")
+#   define CloseSocket closesocket
+#else
+#   include <arpa/inet.h>
+#   include <netinet/in.h>
+#   include <sys/select.h>
+#   include <sys/socket.h>
+#   include <sys/time.h>
+#   include <unistd.h>
+#   define CloseSocket close
+#endif
+
+// A client that hangs up early must not raise SIGPIPE.
+#ifdef MSG_NOSIGNAL
+#   define SEND_FLAGS MSG_NOSIGNAL
+#else
+#   define SEND_FLAGS 0
+#endif
+
+using namespace std;
+
+#include "stats_server.h"
+#include "frame.h"
+
+
+// SCHEMA FOR THE STATS SERVER
+// One thread accepts and answers connections one at a time; a scraper
+// asks every few seconds, so there is nothing to gain from more.  It waits
+// in select with a short timeout so that Stop is noticed without closing
+// the socket under it.  Each answer is the whole document and closes the
+// connection.
+
+enum {
+	POLL_MS = 200,			// how often the server checks for Stop
+	RECV_TIMEOUT_MS = 1000,	// a client that sends nothing is dropped
+	MAX_REQUEST = 4096
+};
+
+StatsServer::StatsServer()
+{
+	listener = -1;
+	port = 0;
+	running = false;
+	stopping = false;
+}
+
+StatsServer::~StatsServer()
+{
+	Stop();
+}
+
+//--------------------------------------------------------------------
+// StatsServer::Start
+//
+// Input    : port - the TCP port to listen on, 0 for any free port
+// Purpose  : Bind 127.0.0.1:port and start answering requests.
+// Return   : OK, or STATS_SERVER_ERROR if the server is already
+//            running or the socket cannot be set up.
+//--------------------------------------------------------------------
+Status StatsServer::Start(int port)
+{
+	if (running) return MINIBASE_FIRST_ERROR(BUFMGR, STATS_SERVER_ERROR);
+
+#ifdef _WIN32
+	WSADATA wsa;
+	if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0)
+		return MINIBASE_FIRST_ERROR(BUFMGR, STATS_SERVER_ERROR);
+#endif
+
+	intptr_t s = (intptr_t)socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (s == -1) {
+#ifdef _WIN32
+		WSACleanup();
+#endif
+		return MINIBASE_FIRST_ERROR(BUFMGR, STATS_SERVER_ERROR);
+	}
+
+	int on = 1;
+	setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*)&on, sizeof(on));
+
+	sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = htons((unsigned short)port);
+
+	socklen_t len = sizeof(addr);
+	if (bind(s, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(s, 8) != 0
+	    || getsockname(s, (sockaddr*)&addr, &len) != 0) {
+		CloseSocket(s);
+#ifdef _WIN32
+		WSACleanup();
+#endif
+		return MINIBASE_FIRST_ERROR(BUFMGR, STATS_SERVER_ERROR);
+	}
+
+	listener = s;
+	this->port = ntohs(addr.sin_port);
+	stopping = false;
+	running = true;
+	worker = std::thread(&StatsServer::Serve, this);
+	return OK;
+}
+
+void StatsServer::Stop()
+{
+	if (!running) return;
+
+	stopping = true;
+	worker.join();
+	CloseSocket(listener);
+	listener = -1;
+	running = false;
+#ifdef _WIN32
+	WSACleanup();
+#endif
+}
+
+void StatsServer::Publish(const BufStats& stats)
+{
+	ostringstream j, p;
+	stats.WriteJson(j);
+	stats.WritePrometheus(p);
+
+	std::lock_guard<std::mutex> guard(docLock);
+	json = j.str();
+	prometheus = p.str();
+}
+
+void StatsServer::Serve()
+{
+	while (!stopping) {
+		fd_set ready;
+		FD_ZERO(&ready);
+		FD_SET(listener, &ready);
+		timeval timeout;
+		timeout.tv_sec = 0;
+		timeout.tv_usec = POLL_MS * 1000;
+
+		if (select((int)listener + 1, &ready, NULL, NULL, &timeout) <= 0) continue;
+
+		intptr_t client = (intptr_t)accept(listener, NULL, NULL);
+		if (client == -1) continue;
+		Answer(client);
+		CloseSocket(client);
+	}
+}
+
+//--------------------------------------------------------------------
+// StatsServer::Answer
+//
+// Input    : client - a connected socket
+// Purpose  : Read one request and send the document it names.  Only
+//            the request line is looked at; anything but GET /metrics
+//            or GET /stats gets a 404.
+//--------------------------------------------------------------------
+void StatsServer::Answer(intptr_t client)
+{
+#ifdef _WIN32
+	DWORD wait = RECV_TIMEOUT_MS;
+#else
+	timeval wait;
+	wait.tv_sec = RECV_TIMEOUT_MS / 1000;
+	wait.tv_usec = (RECV_TIMEOUT_MS % 1000) * 1000;
+#endif
+	setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, (const char*)&wait, sizeof(wait));
+
+	string request;
+	char buf[512];
+	while (request.find("\r\n\r\n") == string::npos && request.size() < MAX_REQUEST) {
+		int n = (int)recv(client, buf, sizeof(buf), 0);
+		if (n <= 0) break;
+		request.append(buf, n);
+	}
+
+	string line = request.substr(0, request.find("\r\n"));
+	string path;
+	if (line.compare(0, 4, "GET ") == 0)
+		path = line.substr(4, line.find(' ', 4) - 4);
+	path = path.substr(0, path.find('?'));
+
+	string status = "200 OK", type, body;
+	if (path == "/metrics") {
+		type = "text/plain; version=0.0.4";
+		std::lock_guard<std::mutex> guard(docLock);
+		body = prometheus;
+	}
+	else if (path == "/stats") {
+		type = "application/json";
+		std::lock_guard<std::mutex> guard(docLock);
+		body = json;
+	}
+	else {
+		status = "404 Not Found";
+		type = "text/plain";
+		body = "Try /metrics or /stats\n";
+	}
+
+	ostringstream response;
+	response << "HTTP/1.0 " << status << "\r\n"
+		<< "Content-Type: " << type << "\r\n"
+		<< "Content-Length: " << body.size() << "\r\n"
+		<< "Connection: close\r\n\r\n" << body;
+
+	string out = response.str();
+	for (size_t sent = 0; sent < out.size(); ) {
+		int n = (int)send(client, out.data() + sent, (int)(out.size() - sent), SEND_FLAGS);
+		if (n <= 0) break;
+		sent += n;
+	}
+}
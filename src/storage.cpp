@@ -0,0 +1,466 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <string>
+
+#ifdef _WIN32
+#   include <io.h>
+#   include <windows.h>
+#else
+#   include <unistd.h>
+#endif
+
+#include "storage.h"
+#include "db.h"
+
+static long long RoundDown( long long offset )
+{
+	return offset & ~(long long)(DirectStorage::BLOCK_SIZE - 1);
+}
+
+static long long RoundUp( long long offset )
+{
+	return RoundDown(offset + DirectStorage::BLOCK_SIZE - 1);
+}
+
+static bool IsAligned( long long offset, const void* buf, unsigned length )
+{
+	return ((offset | (long long)length | (long long)(size_t)buf)
+	        & (DirectStorage::BLOCK_SIZE - 1)) == 0;
+}
+
+Storage* Storage::Create( StorageKind kind )
+{
+	switch (kind) {
+	case DIRECT_STORAGE: return new DirectStorage;
+	case MEMORY_STORAGE: return new MemoryStorage;
+	default:             return new FileStorage;
+	}
+}
+
+bool Storage::ParseKind( const char* name, StorageKind& kind )
+{
+	if (strcmp(name, "file") == 0) kind = FILE_STORAGE;
+	else if (strcmp(name, "direct") == 0) kind = DIRECT_STORAGE;
+	else if (strcmp(name, "memory") == 0) kind = MEMORY_STORAGE;
+	else return false;
+	return true;
+}
+
+
+// FileStorage
+
+//--------------------------------------------------------------------
+// FileStorage::Open
+//
+// Input    : name - the file
+//            mode - whether to open the file or create it, and whether
+//                   to keep a created file
+// Purpose  : Open the file for reading and writing.  A created file is
+//            truncated.  A temporary one is opened O_TEMPORARY on
+//            Windows; elsewhere its name is removed at once, and the file
+//            goes when fd is closed.
+// Return   : OK, or UNIX_ERROR if the file cannot be opened.
+//--------------------------------------------------------------------
+Status FileStorage::Open( const char* name, StorageMode mode )
+{
+	Close();
+
+#ifdef _WIN32
+	int flags = O_RDWR | O_BINARY;
+	if (mode != STORE_EXISTING) flags |= O_CREAT | O_TRUNC;
+	if (mode == STORE_TEMPORARY) flags |= O_TEMPORARY;
+	fd = _open(name, flags, _S_IREAD | _S_IWRITE);
+#else
+	int flags = O_RDWR;
+	if (mode != STORE_EXISTING) flags |= O_CREAT | O_TRUNC;
+	fd = open(name, flags, 0666);
+	if (fd >= 0 && mode == STORE_TEMPORARY)
+		unlink(name);
+#endif
+
+	return (fd < 0) ? MINIBASE_FIRST_ERROR(DBMGR, UNIX_ERROR) : OK;
+}
+
+void FileStorage::Close()
+{
+#ifdef _WIN32
+	if (fd >= 0) _close(fd);
+#else
+	if (fd >= 0) close(fd);
+#endif
+	fd = -1;
+}
+
+long long FileStorage::ReadAt( void* buf, unsigned length, long long offset )
+{
+	unsigned done = 0;
+
+#ifdef _WIN32
+	std::lock_guard<std::mutex> guard(seekLock);
+	if (_lseeki64(fd, (__int64)offset, SEEK_SET) < 0)
+		return -1;
+	while (done < length) {
+		int n = _read(fd, (char*)buf + done, length - done);
+		if (n < 0) return -1;
+		if (n == 0) break;
+		done += n;
+	}
+#else
+	while (done < length) {
+		ssize_t n = pread(fd, (char*)buf + done, length - done, (off_t)(offset + done));
+		if (n < 0 && errno == EINTR) continue;
+		if (n < 0) return -1;
+		if (n == 0) break;
+		done += (unsigned)n;
+	}
+#endif
+
+	return done;
+}
+
+bool FileStorage::WriteAt( const void* buf, unsigned length, long long offset )
+{
+	unsigned done = 0;
+
+#ifdef _WIN32
+	std::lock_guard<std::mutex> guard(seekLock);
+	if (_lseeki64(fd, (__int64)offset, SEEK_SET) < 0)
+		return false;
+	while (done < length) {
+		int n = _write(fd, (const char*)buf + done, length - done);
+		if (n <= 0) return false;
+		done += n;
+	}
+#else
+	while (done < length) {
+		ssize_t n = pwrite(fd, (const char*)buf + done, length - done, (off_t)(offset + done));
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) return false;
+		done += (unsigned)n;
+	}
+#endif
+
+	return true;
+}
+
+long long FileStorage::Size()
+{
+#ifdef _WIN32
+	return _filelengthi64(fd);
+#else
+	struct stat st;
+	return (fstat(fd, &st) == 0) ? (long long)st.st_size : -1;
+#endif
+}
+
+Status FileStorage::Read( long long offset, void* buf, unsigned length )
+{
+	long long got = ReadAt(buf, length, offset);
+	if (got < 0)
+		return MINIBASE_FIRST_ERROR(DBMGR, UNIX_ERROR);
+	if (got < length)
+		return MINIBASE_FIRST_ERROR(DBMGR, FILE_IO_ERROR);
+	return OK;
+}
+
+Status FileStorage::Write( long long offset, const void* buf, unsigned length )
+{
+	if (!WriteAt(buf, length, offset))
+		return MINIBASE_FIRST_ERROR(DBMGR, FILE_IO_ERROR);
+	return OK;
+}
+
+Status FileStorage::Sync()
+{
+#ifdef _WIN32
+	if (_commit(fd) != 0)
+#elif defined(__APPLE__)
+	if (fcntl(fd, F_FULLFSYNC) != 0 && fsync(fd) != 0)
+#else
+	if (fsync(fd) != 0)
+#endif
+		return MINIBASE_FIRST_ERROR(DBMGR, FILE_IO_ERROR);
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// FileStorage::Allocate
+//
+// Input    : size - the length the file must have, in bytes
+// Purpose  : Grow the file.  Where posix_fallocate is there the blocks are
+//            reserved as well, so that a later write cannot fail for want
+//            of space; a file system that cannot do that, or a platform
+//            without it, just gets the new length, and the bytes read as
+//            zeroes until they are written.  Windows writes the last byte.
+//--------------------------------------------------------------------
+Status FileStorage::Allocate( long long size )
+{
+	long long end = Size();
+	if (end < 0)
+		return MINIBASE_FIRST_ERROR(DBMGR, UNIX_ERROR);
+	if (end >= size)
+		return OK;
+
+#ifdef _WIN32
+	char zero = 0;
+	if (!WriteAt(&zero, 1, size - 1))
+		return MINIBASE_FIRST_ERROR(DBMGR, FILE_IO_ERROR);
+#else
+#ifdef __linux__
+	int error = posix_fallocate(fd, (off_t)end, (off_t)(size - end));
+	if (error == 0)
+		return OK;
+	if (error != EINVAL && error != EOPNOTSUPP)
+		return MINIBASE_FIRST_ERROR(DBMGR, FILE_IO_ERROR);
+#endif
+	if (ftruncate(fd, (off_t)size) != 0)
+		return MINIBASE_FIRST_ERROR(DBMGR, FILE_IO_ERROR);
+#endif
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// FileStorage::Replace
+//
+// Input    : from, to - the file names
+// Purpose  : rename replaces the target in one step on POSIX systems, and
+//            the directory is synced so that the new name survives a
+//            crash.  On Windows rename fails if the target is there;
+//            MoveFileEx is the one that replaces, and write-through makes
+//            it durable.
+//--------------------------------------------------------------------
+Status FileStorage::Replace( const char* from, const char* to )
+{
+#ifdef _WIN32
+	if (!MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+		return MINIBASE_FIRST_ERROR(DBMGR, UNIX_ERROR);
+#else
+	if (rename(from, to) != 0)
+		return MINIBASE_FIRST_ERROR(DBMGR, UNIX_ERROR);
+
+	const char* slash = strrchr(to, '/');
+	std::string dir = slash ? std::string(to, slash - to + 1) : std::string(".");
+	int dirfd = open(dir.c_str(), O_RDONLY);
+	if (dirfd < 0)
+		return MINIBASE_FIRST_ERROR(DBMGR, UNIX_ERROR);
+	int synced = fsync(dirfd);
+	close(dirfd);
+	if (synced != 0)
+		return MINIBASE_FIRST_ERROR(DBMGR, FILE_IO_ERROR);
+#endif
+	return OK;
+}
+
+
+// DirectStorage
+
+DirectStorage::~DirectStorage()
+{
+#ifdef _WIN32
+	_aligned_free(block);
+#else
+	free(block);
+#endif
+}
+
+//--------------------------------------------------------------------
+// DirectStorage::Open
+//
+// Input    : name - the file
+//            mode - as for FileStorage::Open
+// Purpose  : Open the file so that reads and writes bypass the OS page
+//            cache: FILE_FLAG_NO_BUFFERING on Windows, O_DIRECT where
+//            there is one, F_NOCACHE on macOS.  Where the platform has
+//            none of these the file is opened as an ordinary one.
+// Return   : OK, or UNIX_ERROR if the file cannot be opened.  Some file
+//            systems, tmpfs among them, refuse O_DIRECT; that is an error
+//            too.
+//--------------------------------------------------------------------
+Status DirectStorage::Open( const char* name, StorageMode mode )
+{
+	Close();
+
+#ifdef _WIN32
+	DWORD flags = FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH;
+	if (mode == STORE_TEMPORARY) flags |= FILE_FLAG_DELETE_ON_CLOSE;
+	HANDLE h = CreateFileA(name, GENERIC_READ | GENERIC_WRITE,
+	                       FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+	                       (mode == STORE_EXISTING) ? OPEN_EXISTING : CREATE_ALWAYS,
+	                       flags, NULL);
+	if (h == INVALID_HANDLE_VALUE)
+		return MINIBASE_FIRST_ERROR(DBMGR, UNIX_ERROR);
+	fd = _open_osfhandle((intptr_t)h, 0);
+	if (fd < 0) {
+		CloseHandle(h);
+		return MINIBASE_FIRST_ERROR(DBMGR, UNIX_ERROR);
+	}
+#else
+	int flags = O_RDWR;
+	if (mode != STORE_EXISTING) flags |= O_CREAT | O_TRUNC;
+#ifdef O_DIRECT
+	flags |= O_DIRECT;
+#endif
+	fd = open(name, flags, 0666);
+	if (fd < 0)
+		return MINIBASE_FIRST_ERROR(DBMGR, UNIX_ERROR);
+	if (mode == STORE_TEMPORARY)
+		unlink(name);
+#ifdef F_NOCACHE
+	fcntl(fd, F_NOCACHE, 1);
+#endif
+#endif
+
+	return OK;
+}
+
+bool DirectStorage::Reserve( unsigned length )
+{
+	if (length <= blockSize) return true;
+
+#ifdef _WIN32
+	_aligned_free(block);
+	block = (char*)_aligned_malloc(length, BLOCK_SIZE);
+#else
+	free(block);
+	void* p = NULL;
+	block = (posix_memalign(&p, BLOCK_SIZE, length) == 0) ? (char*)p : NULL;
+#endif
+	blockSize = block ? length : 0;
+	return block != NULL;
+}
+
+Status DirectStorage::Read( long long offset, void* buf, unsigned length )
+{
+	if (IsAligned(offset, buf, length))
+		return FileStorage::Read(offset, buf, length);
+
+	std::lock_guard<std::mutex> guard(blockLock);
+
+	long long start = RoundDown(offset);
+	unsigned span = (unsigned)(RoundUp(offset + length) - start);
+	if (!Reserve(span))
+		return MINIBASE_FIRST_ERROR(DBMGR, FILE_IO_ERROR);
+
+	long long got = ReadAt(block, span, start);
+	if (got < 0)
+		return MINIBASE_FIRST_ERROR(DBMGR, UNIX_ERROR);
+	if (start + got < offset + length)
+		return MINIBASE_FIRST_ERROR(DBMGR, FILE_IO_ERROR);
+
+	memcpy(buf, block + (offset - start), length);
+	return OK;
+}
+
+//--------------------------------------------------------------------
+// DirectStorage::Write
+//
+// Input    : offset, buf, length - the bytes to write
+// Purpose  : Write whole blocks.  If the range does not start and end on
+//            a block boundary, the blocks it touches are read first so
+//            that the bytes around it are kept; past the end of the file
+//            they are zeroes.
+//--------------------------------------------------------------------
+Status DirectStorage::Write( long long offset, const void* buf, unsigned length )
+{
+	if (IsAligned(offset, buf, length))
+		return FileStorage::Write(offset, buf, length);
+
+	std::lock_guard<std::mutex> guard(blockLock);
+
+	long long start = RoundDown(offset);
+	unsigned span = (unsigned)(RoundUp(offset + length) - start);
+	if (!Reserve(span))
+		return MINIBASE_FIRST_ERROR(DBMGR, FILE_IO_ERROR);
+
+	if (start != offset || span != length) {
+		long long got = ReadAt(block, span, start);
+		if (got < 0)
+			return MINIBASE_FIRST_ERROR(DBMGR, UNIX_ERROR);
+		memset(block + got, 0, span - (unsigned)got);
+	}
+
+	memcpy(block + (offset - start), buf, length);
+	if (!WriteAt(block, span, start))
+		return MINIBASE_FIRST_ERROR(DBMGR, FILE_IO_ERROR);
+	return OK;
+}
+
+// The file only ever grows by whole blocks.  Changing its length is not a
+// transfer, so elsewhere it is as for an ordinary file; Windows has to
+// write a block of zeroes at the end.
+Status DirectStorage::Allocate( long long size )
+{
+	size = RoundUp(size);
+
+#ifdef _WIN32
+	long long end = Size();
+	if (end < 0)
+		return MINIBASE_FIRST_ERROR(DBMGR, UNIX_ERROR);
+	if (end >= size)
+		return OK;
+
+	std::lock_guard<std::mutex> guard(blockLock);
+
+	if (!Reserve(BLOCK_SIZE))
+		return MINIBASE_FIRST_ERROR(DBMGR, FILE_IO_ERROR);
+	memset(block, 0, BLOCK_SIZE);
+	if (!WriteAt(block, BLOCK_SIZE, size - BLOCK_SIZE))
+		return MINIBASE_FIRST_ERROR(DBMGR, FILE_IO_ERROR);
+	return OK;
+#else
+	return FileStorage::Allocate(size);
+#endif
+}
+
+
+// MemoryStorage
+
+// There is nothing to open: a memory store only exists while it is open.
+Status MemoryStorage::Open( const char*, StorageMode mode )
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	bytes.clear();
+	return (mode != STORE_EXISTING) ? OK : MINIBASE_FIRST_ERROR(DBMGR, FILE_NOT_FOUND);
+}
+
+void MemoryStorage::Close()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	std::vector<char>().swap(bytes);
+}
+
+Status MemoryStorage::Read( long long offset, void* buf, unsigned length )
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	if (offset < 0 || offset + length > (long long)bytes.size())
+		return MINIBASE_FIRST_ERROR(DBMGR, FILE_IO_ERROR);
+	memcpy(buf, &bytes[(size_t)offset], length);
+	return OK;
+}
+
+Status MemoryStorage::Write( long long offset, const void* buf, unsigned length )
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	if (offset < 0)
+		return MINIBASE_FIRST_ERROR(DBMGR, FILE_IO_ERROR);
+	if (offset + length > (long long)bytes.size())
+		bytes.resize((size_t)(offset + length));
+	memcpy(&bytes[(size_t)offset], buf, length);
+	return OK;
+}
+
+Status MemoryStorage::Allocate( long long size )
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	if (size > (long long)bytes.size())
+		bytes.resize((size_t)size);
+	return OK;
+}
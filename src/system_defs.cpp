@@ -22,7 +22,8 @@ ostream& operator<< (ostream& out, const struct RecordID rid)
 
 SystemDefs::SystemDefs( Status& status, const char* dbname, const char* logname,
                         unsigned num_pgs, unsigned logsize,
-                        unsigned bufpoolsize, const char* replacement_policy )
+                        unsigned bufpoolsize, const char* replacement_policy,
+                        const DBOptions* db_options )
 {
     char *real_logname;
     char *real_dbname;
@@ -35,11 +36,13 @@ SystemDefs::SystemDefs( Status& status, const char* dbname, const char* logname,
 
 
     init( status, real_dbname,real_logname, num_pgs, logsize,
-          bufpoolsize? bufpoolsize : NUMBUF, replacement_policy? replacement_policy : "Clock" );
+          bufpoolsize? bufpoolsize : NUMBUF, replacement_policy? replacement_policy : "Clock",
+          db_options );
 }
 
 SystemDefs::SystemDefs( Status& status, const char* dbname, unsigned num_pgs,
-                        unsigned bufpoolsize, const char* replacement_policy )
+                        unsigned bufpoolsize, const char* replacement_policy,
+                        const DBOptions* db_options )
 {   
 	char *logname;
     char *real_dbname;
@@ -53,12 +56,14 @@ SystemDefs::SystemDefs( Status& status, const char* dbname, unsigned num_pgs,
 
     init( status, real_dbname, logname, num_pgs, num_pgs? 3*num_pgs : 500,
           bufpoolsize? bufpoolsize : NUMBUF,
-          replacement_policy? replacement_policy : "Clock" );
+          replacement_policy? replacement_policy : "Clock",
+          db_options );
 }
 
 void SystemDefs::init( Status& status, const char* dbname, const char* logname,
                        unsigned num_pgs, unsigned ,
-                       unsigned bufpoolsize, const char* replacement_policy )
+                       unsigned bufpoolsize, const char* replacement_policy,
+                       const DBOptions* db_options )
 {
     status = OK;
     char* BufMgrAddress;
@@ -77,7 +82,12 @@ void SystemDefs::init( Status& status, const char* dbname, const char* logname,
           // this needs to be changed later to merely the buffer pool.
 
         BufMgrAddress = GlobalShMemMgr->malloc(sizeof(BufMgr));
-        GlobalBufMgr = new(BufMgrAddress) BufMgr(bufpoolsize, replacement_policy);
+        GlobalBufMgr = new(BufMgrAddress) BufMgr(bufpoolsize, replacement_policy, status);
+        if (status != OK) {
+            cerr << "Error setting replacement policy " << replacement_policy << endl;
+            minibase_errors.show_errors();
+            return;
+        }
 
         GlobalDBName = GlobalShMemMgr->malloc(strlen(dbname)+1);
         strcpy(GlobalDBName,dbname);
@@ -95,7 +105,8 @@ void SystemDefs::init( Status& status, const char* dbname, const char* logname,
             return;
         }
     } else {
-        GlobalDB = new DB(dbname,num_pgs,status);
+        GlobalDB = new DB(dbname,num_pgs,status,
+                          db_options? *db_options : DBOptions());
         if (status != OK) {
             cerr << "Error creating Database " << dbname << endl;
             minibase_errors.show_errors();
@@ -120,6 +131,11 @@ SystemDefs::~SystemDefs()
       /* The buffer manager needs the GlobalDb to still exist when it is
          deleted. */
 
+      /* Unused pages reserved by per-thread extent caches go back to the
+         space map while the buffer manager can still write it. */
+    if (GlobalDB != NULL)
+        GlobalDB->ReleaseExtentCaches();
+
     delete GlobalBufMgr;   GlobalBufMgr = NULL;
     delete GlobalDBName; GlobalDBName = NULL;
     delete GlobalLogName; GlobalLogName = NULL;
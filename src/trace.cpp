@@ -0,0 +1,71 @@
+#include <string.h>
+#include <algorithm>
+
+#include "trace.h"
+
+
+static bool EarlierEvent(const TraceEvent& a, const TraceEvent& b)
+{
+	return a.time < b.time;
+}
+
+TraceReader::TraceReader()
+{
+	file = NULL;
+	memset(&header, 0, sizeof(header));
+}
+
+TraceReader::~TraceReader()
+{
+	Close();
+}
+
+bool TraceReader::Open(const char* path)
+{
+	Close();
+
+	file = fopen(path, "rb");
+	if (!file) return false;
+
+	if (fread(&header, sizeof(header), 1, file) != 1
+	    || memcmp(header.magic, TRACE_MAGIC, 4) != 0
+	    || header.version != TRACE_VERSION
+	    || header.eventSize != sizeof(TraceEvent)) {
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void TraceReader::Close()
+{
+	if (file) fclose(file);
+	file = NULL;
+}
+
+bool TraceReader::Next(TraceEvent& event)
+{
+	return file && fread(&event, sizeof(event), 1, file) == 1;
+}
+
+void TraceReader::ReadAll(std::vector<TraceEvent>& events)
+{
+	events.clear();
+	TraceEvent event;
+	while (Next(event))
+		events.push_back(event);
+	std::stable_sort(events.begin(), events.end(), EarlierEvent);
+}
+
+double TraceReader::ToNs(const TraceEvent& event) const
+{
+	return (double)(long long)(event.time - header.startTicks) * header.nsPerTick;
+}
+
+const char* TraceReader::TypeName(int type)
+{
+	static const char* names[NUM_TRACE_EVENT_TYPES] = {
+		"pin", "unpin", "new", "free", "flush", "flush-all",
+	};
+	return (type >= 0 && type < NUM_TRACE_EVENT_TYPES) ? names[type] : "?";
+}
@@ -0,0 +1,215 @@
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+#include "trace_recorder.h"
+#include "latency_stats.h"
+#include "frame.h"
+
+
+// SCHEMA FOR THE TRACE RECORDER
+// Each thread finds its ring through a thread_local cache tagged with the
+// serial number of the trace, as LatencyStats does for its shards; a new
+// trace gets a new serial, so rings of a stopped trace are never reused.
+//
+// A ring holds the events [tail, head), indexes taken mod RING_SIZE.  The
+// owner fills events[head] and then publishes it with a release store of
+// head; the writer copies [tail, head) after an acquire load of head and
+// then releases the slots with a store of tail.
+//
+// The file is the header followed by the events.  The header is written
+// again by Stop, once the tick rate and thread count are known.
+
+static unsigned next_trace_serial = 0;
+
+static double SecondsNow()
+{
+	return std::chrono::duration<double>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool EarlierEvent(const TraceEvent& a, const TraceEvent& b)
+{
+	return a.time < b.time;
+}
+
+TraceRecorder::TraceRecorder()
+{
+	file = NULL;
+	writeFailed = false;
+	serial = 0;
+	startTicks = 0;
+	startSeconds = 0;
+	stopping = false;
+	numWritten = 0;
+	numStalls = 0;
+}
+
+TraceRecorder::~TraceRecorder()
+{
+	Stop();
+}
+
+Status TraceRecorder::Start(const char* path)
+{
+	if (file) return MINIBASE_FIRST_ERROR(BUFMGR, TRACE_FILE_ERROR);
+
+	file = fopen(path, "wb");
+	if (!file) return MINIBASE_FIRST_ERROR(BUFMGR, TRACE_FILE_ERROR);
+
+	writeFailed = false;
+	serial = ++next_trace_serial;
+	startTicks = LatencyStats::Now();
+	startSeconds = SecondsNow();
+	numWritten = 0;
+	numStalls = 0;
+	WriteHeader();
+
+	stopping = false;
+	writer = std::thread(&TraceRecorder::Write, this);
+	return OK;
+}
+
+Status TraceRecorder::Stop()
+{
+	if (!file) return OK;
+
+	stopping = true;
+	writer.join();
+	Drain();
+	WriteHeader();
+
+	if (fclose(file) != 0) writeFailed = true;
+	file = NULL;
+
+	for (unsigned i = 0; i < rings.size(); i++)
+		delete rings[i];
+	rings.clear();
+
+	return writeFailed ? MINIBASE_FIRST_ERROR(BUFMGR, TRACE_FILE_ERROR) : OK;
+}
+
+void TraceRecorder::WriteHeader()
+{
+	TraceHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, TRACE_MAGIC, 4);
+	header.version = TRACE_VERSION;
+	header.eventSize = sizeof(TraceEvent);
+	header.numThreads = (unsigned)rings.size();
+	header.startTicks = startTicks;
+
+	unsigned long long ticks = LatencyStats::Now() - startTicks;
+	header.nsPerTick = (ticks > 0) ? (SecondsNow() - startSeconds) * 1e9 / ticks : 1.0;
+
+	long end = ftell(file);
+	if (fseek(file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, file) != 1)
+		writeFailed = true;
+	if (end > 0) fseek(file, end, SEEK_SET);
+}
+
+TraceRecorder::Ring* TraceRecorder::MyRing()
+{
+	static thread_local unsigned owner = 0;
+	static thread_local Ring* ring = 0;
+
+	if (owner != serial) {
+		std::lock_guard<std::mutex> guard(ringLock);
+		std::thread::id me = std::this_thread::get_id();
+
+		ring = 0;
+		for (unsigned i = 0; i < rings.size() && !ring; i++)
+			if (rings[i]->owner == me)
+				ring = rings[i];
+
+		if (!ring) {
+			ring = new Ring;
+			ring->owner = me;
+			ring->thread = (unsigned short)rings.size();
+			ring->tailSeen = 0;
+			ring->head.store(0, std::memory_order_relaxed);
+			ring->tail.store(0, std::memory_order_relaxed);
+			rings.push_back(ring);
+		}
+		owner = serial;
+	}
+	return ring;
+}
+
+void TraceRecorder::Record(TraceEventType type, int pid, int flags)
+{
+	Ring* ring = MyRing();
+
+	unsigned long long head = ring->head.load(std::memory_order_relaxed);
+	if (head - ring->tailSeen == RING_SIZE) {
+		ring->tailSeen = ring->tail.load(std::memory_order_acquire);
+		if (head - ring->tailSeen == RING_SIZE) {
+			numStalls++;
+			while (head - ring->tailSeen == RING_SIZE) {
+				std::this_thread::yield();
+				ring->tailSeen = ring->tail.load(std::memory_order_acquire);
+			}
+		}
+	}
+
+	TraceEvent& event = ring->events[head & (RING_SIZE - 1)];
+	event.time = LatencyStats::Now();
+	event.pid = pid;
+	event.thread = ring->thread;
+	event.type = (unsigned char)type;
+	event.flags = (unsigned char)flags;
+	ring->head.store(head + 1, std::memory_order_release);
+}
+
+//--------------------------------------------------------------------
+// TraceRecorder::Drain
+//
+// Purpose  : Copy every published event out of the rings and append
+//            them to the file, sorted by time.
+// Return   : whether there was anything to write.
+// Note     : What a ring holds is already in time order, so each ring's
+//            run is merged into the batch rather than sorting it all.
+//--------------------------------------------------------------------
+bool TraceRecorder::Drain()
+{
+	batch.clear();
+	{
+		std::lock_guard<std::mutex> guard(ringLock);
+		for (unsigned i = 0; i < rings.size(); i++) {
+			Ring* ring = rings[i];
+			unsigned long long tail = ring->tail.load(std::memory_order_relaxed);
+			unsigned long long head = ring->head.load(std::memory_order_acquire);
+			if (tail == head) continue;
+
+			size_t merged = batch.size();
+			unsigned from = (unsigned)(tail & (RING_SIZE - 1));
+			unsigned to = (unsigned)(head & (RING_SIZE - 1));
+			if (from < to) {
+				batch.insert(batch.end(), ring->events + from, ring->events + to);
+			}
+			else {
+				batch.insert(batch.end(), ring->events + from, ring->events + RING_SIZE);
+				batch.insert(batch.end(), ring->events, ring->events + to);
+			}
+			ring->tail.store(head, std::memory_order_release);
+
+			if (merged > 0)
+				std::inplace_merge(batch.begin(), batch.begin() + merged, batch.end(), EarlierEvent);
+		}
+	}
+	if (batch.empty()) return false;
+
+	if (fwrite(&batch[0], sizeof(TraceEvent), batch.size(), file) != batch.size())
+		writeFailed = true;
+	numWritten += batch.size();
+	return true;
+}
+
+// The background writer.
+void TraceRecorder::Write()
+{
+	while (!stopping) {
+		if (!Drain())
+			std::this_thread::sleep_for(std::chrono::milliseconds(DRAIN_MS));
+	}
+}
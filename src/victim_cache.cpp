@@ -0,0 +1,24 @@
+#include "victim_cache.h"
+
+VictimCache::VictimCache() {
+	ResetStat();
+}
+
+VictimCache::~VictimCache() {
+}
+
+long VictimCache::GetNumLookups() const {
+	return numLookups;
+}
+
+long VictimCache::GetNumHits() const {
+	return numHits;
+}
+
+void VictimCache::ResetStat() {
+	numLookups = 0;
+	numHits = 0;
+	numPuts = 0;
+	numDeclined = 0;
+	numEvictions = 0;
+}
@@ -0,0 +1,81 @@
+// trace_dump: print a buffer manager trace (see TraceRecorder) as text.
+//
+//   trace_dump [-s] trace-file
+//
+// Prints one line per event: time in microseconds from the start of the
+// trace, thread, event, page and flags.  With -s, prints only a summary:
+// events by type, distinct pages and the span of the trace.
+
+#include <stdio.h>
+#include <string.h>
+#include <set>
+#include <vector>
+
+#include "trace.h"
+
+static void Usage()
+{
+	fprintf(stderr, "usage: trace_dump [-s] trace-file\n");
+}
+
+static void PrintEvent(const TraceReader& reader, const TraceEvent& e)
+{
+	printf("%14.3f %4u  %-9s %10d ", reader.ToNs(e) / 1000, e.thread, TraceReader::TypeName(e.type), e.pid);
+	if (e.flags & TRACE_DIRTY) printf(" dirty");
+	if (e.flags & TRACE_EMPTY) printf(" empty");
+	if (e.flags & TRACE_FAILED) printf(" failed");
+	printf("\n");
+}
+
+static void PrintSummary(const TraceReader& reader, const std::vector<TraceEvent>& events)
+{
+	long long byType[NUM_TRACE_EVENT_TYPES] = { 0 };
+	long long failed = 0;
+	std::set<int> pages;
+	for (size_t i = 0; i < events.size(); i++) {
+		const TraceEvent& e = events[i];
+		if (e.type < NUM_TRACE_EVENT_TYPES) byType[e.type]++;
+		if (e.flags & TRACE_FAILED) failed++;
+		if (e.type != TRACE_FLUSH_ALL) pages.insert(e.pid);
+	}
+
+	printf("events    %lld\n", (long long)events.size());
+	for (int t = 0; t < NUM_TRACE_EVENT_TYPES; t++)
+		printf("  %-9s %lld\n", TraceReader::TypeName(t), byType[t]);
+	printf("failed    %lld\n", failed);
+	printf("pages     %lld\n", (long long)pages.size());
+	printf("threads   %u\n", reader.GetHeader().numThreads);
+	if (!events.empty())
+		printf("span      %.3f ms\n", (reader.ToNs(events.back()) - reader.ToNs(events.front())) / 1e6);
+}
+
+int main(int argc, char* argv[])
+{
+	bool summary = false;
+	const char* path = NULL;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-s") == 0) summary = true;
+		else if (!path) path = argv[i];
+		else { Usage(); return 2; }
+	}
+	if (!path) { Usage(); return 2; }
+
+	TraceReader reader;
+	if (!reader.Open(path)) {
+		fprintf(stderr, "trace_dump: %s is not a readable trace\n", path);
+		return 1;
+	}
+
+	std::vector<TraceEvent> events;
+	reader.ReadAll(events);
+
+	if (summary) {
+		PrintSummary(reader, events);
+		return 0;
+	}
+
+	printf("%14s %4s  %-9s %10s  flags\n", "time (us)", "thr", "event", "pid");
+	for (size_t i = 0; i < events.size(); i++)
+		PrintEvent(reader, events[i]);
+	return 0;
+}
@@ -0,0 +1,147 @@
+// trace_sim: replay a buffer manager trace (see TraceRecorder) against
+// replacement policies and pool sizes, and compare them with Belady's OPT.
+//
+//   trace_sim [-p policy]... [-f frames,frames,...] [-c] trace-file
+//
+// -p  a policy spec as BufMgr takes it ("lru", "lru-k:k=3"); may be
+//     repeated.  The default is every registered policy with its
+//     default parameters.
+// -f  the pool sizes to try.  The default is powers of two from 4 up to
+//     the number of distinct pages in the trace.
+// -c  print CSV instead of a table.
+//
+// Every (policy, size) pair, OPT included, is fed the same events in a
+// single pass over the trace.  Nothing touches a DB.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "cache_sim.h"
+#include "replacer_registry.h"
+#include "trace.h"
+
+static void Usage()
+{
+	fprintf(stderr, "usage: trace_sim [-p policy]... [-f frames,frames,...] [-c] trace-file\n");
+	fprintf(stderr, "policies:\n");
+	ReplacerRegistry::List(std::cerr);
+}
+
+static bool ParseSizes(const char* text, std::vector<int>& sizes)
+{
+	const char* p = text;
+	while (*p) {
+		char* end;
+		long n = strtol(p, &end, 10);
+		if (end == p || n <= 0) return false;
+		sizes.push_back((int)n);
+		p = (*end == ',') ? end + 1 : end;
+		if (*end != ',' && *end != '\0') return false;
+	}
+	return !sizes.empty();
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<std::string> policies;
+	std::vector<int> sizes;
+	bool csv = false;
+	const char* path = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) policies.push_back(argv[++i]);
+		else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+			if (!ParseSizes(argv[++i], sizes)) { Usage(); return 2; }
+		}
+		else if (strcmp(argv[i], "-c") == 0) csv = true;
+		else if (!path && argv[i][0] != '-') path = argv[i];
+		else { Usage(); return 2; }
+	}
+	if (!path) { Usage(); return 2; }
+
+	TraceReader reader;
+	if (!reader.Open(path)) {
+		fprintf(stderr, "trace_sim: %s is not a readable trace\n", path);
+		return 1;
+	}
+	std::vector<TraceEvent> events;
+	reader.ReadAll(events);
+
+	std::set<int> distinct;
+	for (size_t i = 0; i < events.size(); i++)
+		if (events[i].type == TRACE_PIN || events[i].type == TRACE_NEW)
+			distinct.insert(events[i].pid);
+
+	if (policies.empty()) ReplacerRegistry::GetNames(policies);
+	if (sizes.empty()) {
+		for (int n = 4; ; n *= 2) {
+			sizes.push_back(n);
+			if (n >= (int)distinct.size()) break;
+		}
+	}
+
+	// One simulator per (size, policy), OPT last for each size.
+	std::vector<CacheSim*> sims;
+	std::vector<std::string> names;
+	std::vector<Belady*> oracles;
+	for (size_t s = 0; s < sizes.size(); s++) {
+		for (size_t p = 0; p < policies.size(); p++) {
+			Status status;
+			Replacer* r = ReplacerRegistry::Create(policies[p].c_str(), status);
+			if (!r) {
+				fprintf(stderr, "trace_sim: bad policy %s\n", policies[p].c_str());
+				Usage();
+				return 2;
+			}
+			sims.push_back(new CacheSim(r, sizes[s]));
+			names.push_back(policies[p]);
+		}
+		Belady* opt = new Belady;
+		oracles.push_back(opt);
+		sims.push_back(new CacheSim(opt, sizes[s]));
+		names.push_back("OPT");
+	}
+
+	std::vector<long long> next;
+	Belady::FindNextUses(events, next);
+
+	for (size_t i = 0; i < events.size(); i++) {
+		const TraceEvent& e = events[i];
+		if ((e.type == TRACE_PIN || e.type == TRACE_NEW) && !(e.flags & TRACE_FAILED))
+			for (size_t o = 0; o < oracles.size(); o++)
+				oracles[o]->SetNextUse(e.pid, next[i]);
+
+		for (size_t s = 0; s < sims.size(); s++)
+			sims[s]->Apply(e);
+	}
+
+	if (csv) {
+		printf("policy,frames,pins,hits,misses,hit_ratio,eviction_writes,failed_pins\n");
+		for (size_t s = 0; s < sims.size(); s++) {
+			CacheSim* sim = sims[s];
+			printf("%s,%d,%lld,%lld,%lld,%.6f,%lld,%lld\n", names[s].c_str(), sim->GetNumFrames(),
+			       sim->GetNumPins(), sim->GetNumHits(), sim->GetNumMisses(), sim->GetHitRatio(),
+			       sim->GetNumEvictionWrites(), sim->GetNumFailedPins());
+		}
+	}
+	else {
+		printf("%s: %lld events, %lld distinct pages\n", path, (long long)events.size(), (long long)distinct.size());
+		printf("%-20s %8s %8s %10s %12s %12s\n", "policy", "frames", "hit %", "misses", "evict writes", "failed pins");
+		for (size_t s = 0; s < sims.size(); s++) {
+			CacheSim* sim = sims[s];
+			if (s > 0 && sim->GetNumFrames() != sims[s - 1]->GetNumFrames()) printf("\n");
+			printf("%-20s %8d %8.2f %10lld %12lld %12lld\n", names[s].c_str(), sim->GetNumFrames(),
+			       sim->GetHitRatio() * 100, sim->GetNumMisses(), sim->GetNumEvictionWrites(),
+			       sim->GetNumFailedPins());
+		}
+	}
+
+	for (size_t s = 0; s < sims.size(); s++)
+		delete sims[s];
+	return 0;
+}